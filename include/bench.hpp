@@ -0,0 +1,55 @@
+/**
+ * @file bench.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief On-device benchmarks.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+/**
+ * @brief Benchmark the recording storage backends.
+ *
+ * Writes the same amount of sample data through the old per-sample LittleFS
+ * path, the block writer on LittleFS and the block writer on the raw partition
+ * (if there is one), and logs the sustained throughput and worst-case write
+ * latency of each.
+ *
+ * Blocks the main loop while running, so don't run it while recording.
+ */
+void bench_storage();
+
+/**
+ * @brief Benchmark exporting recordings.
+ *
+ * Records a few minutes of synthetic samples, then exports them in
+ * response-sized chunks with a JSON document per sample (how exports used to
+ * work) and with RecExporter in each format, with and without gzip, and logs
+ * the throughput and estimated download time of each.
+ *
+ * Blocks the main loop while running, so don't run it while recording.
+ */
+void bench_export();
@@ -0,0 +1,57 @@
+/**
+ * @file boot.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Boot stage timings.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Start timing a boot stage.
+ *
+ * Stages can run at the same time, on different tasks. Only the first
+ * BOOT_MAX_STAGES are kept.
+ *
+ * @param name The stage name, which must outlive the stage.
+ * @return The stage ID, for boot_stage_end().
+ */
+size_t boot_stage_begin(const char* name);
+
+/**
+ * @brief Finish a boot stage, and log how long it took.
+ *
+ * @param stage The stage ID, from boot_stage_begin().
+ * @param ok If the stage succeeded.
+ */
+void boot_stage_end(size_t stage, bool ok = true);
+
+/**
+ * @brief Log every boot stage, including the ones still running.
+ */
+void boot_print_report();
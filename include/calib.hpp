@@ -0,0 +1,105 @@
+/**
+ * @file calib.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Stored MPU6050 offsets, by temperature.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <ArduinoJson.h>
+
+/**
+ * @brief MPU6050 offsets, calibrated at one temperature.
+ */
+struct calib_t {
+    int16_t accel[3]; // Accelerometer offsets
+    int16_t gyro[3];  // Gyroscope offsets
+    float temp;       // Temperature they were calibrated at (in °C)
+    uint32_t time;    // When they were calibrated (Unix time, 0 if unknown)
+
+    /**
+     * @brief Convert these offsets to a JSON.
+     *
+     * @return A new JsonDocument with the offsets.
+     */
+    StaticJsonDocument<256> to_json() const;
+};
+
+/**
+ * @brief Open the calibration table in NVS.
+ *
+ * The table has one entry per CALIB_BAND_WIDTH °C band, from CALIB_BAND_MIN.
+ *
+ * @return bool If the table was opened.
+ */
+bool calib_setup();
+
+/**
+ * @brief Get the band a temperature falls in.
+ *
+ * Temperatures outside the table go in the first or last band.
+ *
+ * @param temp The temperature (in °C).
+ * @return The band.
+ */
+size_t calib_band(float temp);
+
+/**
+ * @brief Get the offsets for a temperature.
+ *
+ * Falls back to the closest band with offsets if its own band has none.
+ *
+ * @param temp The temperature (in °C).
+ * @param calib Where to save the offsets.
+ * @return The band the offsets are from, or -1 if none are stored.
+ */
+int calib_find(float temp, calib_t* calib);
+
+/**
+ * @brief Store offsets in the band of the temperature they were calibrated at.
+ *
+ * @param calib The offsets.
+ * @return bool If they were stored.
+ */
+bool calib_store(const calib_t& calib);
+
+/**
+ * @brief Get every stored set of offsets.
+ *
+ * @param calibs Where to save the offsets, indexed by band.
+ * @param stored Set to whether each band has offsets.
+ * @param max The number of bands there's room for.
+ * @return The number of bands.
+ */
+size_t calib_list(calib_t* calibs, bool* stored, size_t max);
+
+/**
+ * @brief Forget every stored set of offsets.
+ *
+ * @return bool If the table was cleared.
+ */
+bool calib_clear();
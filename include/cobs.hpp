@@ -0,0 +1,122 @@
+/**
+ * @file cobs.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Consistent Overhead Byte Stuffing, for framing binary data.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * COBS rewrites a buffer so it has no zero bytes, for at most one extra byte
+ * every 254 bytes. A zero can then mark the end of every frame, and a reader
+ * that joins mid-stream, or loses bytes, resyncs at the next zero.
+ *
+ * Doesn't depend on Arduino, so host tools can use it too.
+ */
+
+/**
+ * @brief Worst-case size of an encoded buffer, without the trailing zero.
+ */
+constexpr size_t
+cobs_max_len(size_t len)
+{
+    return len + len / 254 + 1;
+}
+
+/**
+ * @brief Encode a buffer.
+ *
+ * @param in The buffer to encode.
+ * @param len The size of in.
+ * @param out Where to save the encoded bytes, at least cobs_max_len(len) long.
+ * @return The number of encoded bytes, which doesn't include a trailing zero.
+ */
+inline size_t
+cobs_encode(const uint8_t* in, size_t len, uint8_t* out)
+{
+    size_t code_pos = 0; // Where the current run's length goes
+    size_t pos = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i]) {
+            out[pos++] = in[i];
+            code++;
+        }
+
+        // End the run at a zero, or when it's as long as a run can be
+        if (!in[i] || code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+
+            // A full run at the very end doesn't need an empty one after it
+            if (in[i] && i == len - 1) {
+                pos--;
+                return pos;
+            }
+        }
+    }
+
+    out[code_pos] = code;
+    return pos;
+}
+
+/**
+ * @brief Decode a buffer.
+ *
+ * @param in The encoded bytes, without the trailing zero.
+ * @param len The size of in.
+ * @param out Where to save the decoded bytes, at least len long.
+ * @return The number of decoded bytes, or 0 if in isn't valid COBS.
+ */
+inline size_t
+cobs_decode(const uint8_t* in, size_t len, uint8_t* out)
+{
+    size_t pos = 0;
+
+    for (size_t i = 0; i < len;) {
+        uint8_t code = in[i++];
+        if (!code || i + code - 1 > len)
+            return 0;
+
+        for (uint8_t j = 1; j < code; j++) {
+            if (!in[i])
+                return 0;
+            out[pos++] = in[i++];
+        }
+
+        // Runs shorter than the max were ended by a zero, except the last
+        if (code != 0xFF && i < len)
+            out[pos++] = 0;
+    }
+
+    return pos;
+}
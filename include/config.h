@@ -13,6 +13,232 @@
 // Should be a multiple of 10
 #define MPU_SAMPLE_RATE 50
 
+/*
+        Calibration config
+*/
+// NVS namespace the calibration table is stored in (see calib.hpp)
+#define CALIB_NVS_NAMESPACE "calib"
+
+// Temperature bands to keep offsets for (in °C)
+// The gyro bias drifts with temperature, so a cold pool needs its own offsets.
+#define CALIB_BAND_MIN   0
+#define CALIB_BAND_WIDTH 5
+#define CALIB_BANDS      8
+
+// How often to check which band the temperature is in (in ms)
+#define CALIB_TEMP_INTERVAL 10000
+
+// Calibrate a band without offsets once the tracker has been still this long
+// (in ms), unless it's recording
+#define CALIB_STILL_MS 5000
+
+// Largest rotation (in °/s) and acceleration (in m/s^2) that count as still
+#define CALIB_STILL_DPS   2
+#define CALIB_STILL_ACCEL 0.3
+
+/*
+        Task config
+*/
+// Core that reads the MPU (see tasks.hpp)
+// Only the Arduino loop shares it, so sampling isn't held up by the network.
+#define TASKS_ACQ_CORE 1
+
+// Core that streams, records, and serves data, next to the WiFi stack
+#define TASKS_IO_CORE 0
+
+// Stack size and priority of the acquisition task
+// Keep it above everything else on its core, so samples are read on time.
+#define ACQ_TASK_STACK    4096
+#define ACQ_TASK_PRIORITY 5
+
+// Stack size and priority of the data task, which streams or records samples
+#define DATA_TASK_STACK    8192
+#define DATA_TASK_PRIORITY 2
+
+// Number of samples that can be waiting for the data task
+// Absorbs slow flash writes and network stalls, newer samples are dropped
+// once it's full.
+#define DATA_QUEUE_LEN 32
+
+// How often the Arduino loop checks for serial commands (in ms)
+#define LOOP_INTERVAL 10
+
+// Window to measure each task's CPU share over (in ms)
+#define TASKS_WINDOW_MS 1000
+
+/*
+        Serial config
+*/
+// Baud rate of the serial console
+#define SERIAL_BAUD 115200
+
+// Baud rate of binary sample streaming (see serialstream.hpp)
+#define SERIALSTREAM_BAUD 921600
+
+// Size of the serial transmit buffer (in bytes)
+// Samples are dropped instead of waiting once it's full, so leave some slack.
+#define SERIAL_TX_BUFFER 4096
+
+/*
+        Boot config
+*/
+// Number of boot stages to time (see boot.hpp)
+#define BOOT_MAX_STAGES 12
+
+// Stack size of the task that brings up the network in the background
+#define BOOT_NET_TASK_STACK 8192
+
+// Record this long as soon as sampling starts, without waiting for WiFi
+// (in ms, 0 to disable)
+#define BOOT_RECORD_MS 0
+
+/*
+        Recording config
+*/
+// Uncomment to record to the raw recording partition instead of LittleFS.
+// Skips the filesystem overhead, which helps for long, high-rate sessions.
+// Needs the partition table in partitions-recs.csv, so build the
+// esp32dev-recpart environment instead, which defines this.
+// #define REC_USE_PARTITION
+
+#ifdef REC_USE_PARTITION
+#  define REC_STORAGE_DEFAULT STORAGE_PARTITION
+#else
+#  define REC_STORAGE_DEFAULT STORAGE_LITTLEFS
+#endif
+
+// Label of the raw recording partition (see partitions-recs.csv)
+#define REC_PARTITION_LABEL "recs"
+
+// NVS namespace the recording sequence number is stored in (see storage.hpp)
+#define REC_NVS_NAMESPACE "recs"
+
+// Size of a block of samples in a recording (in bytes)
+#define REC_BLOCK_SIZE 1024
+
+// Comment out to store raw samples instead of compressing them
+// Compression (see gorilla.hpp) makes recordings several times smaller.
+#define REC_COMPRESS
+
+// Add a seek index entry every this many samples
+// Lower values make seeking more precise, but use more space.
+#define REC_INDEX_INTERVAL 100
+
+// Make the recording durable every this many ms
+// Anything after the last sync may be lost if the power goes out.
+#define REC_SYNC_INTERVAL 2000
+
+// Only keep this many recordings, deleting the oldest ones (0 to disable)
+#define REC_KEEP_LAST 0
+
+// Delete the oldest recordings once they take more than this many bytes
+// (0 to disable)
+#define REC_MAX_BYTES 0
+
+// Number of recordings made before the time is synced to rename once it is
+#define REC_UNSYNCED_MAX 8
+
+/*
+        Storage worker config
+*/
+// Stack size of the storage worker task (in bytes)
+#define JOBS_TASK_STACK 4096
+
+// Priority of the storage worker task
+// Keep it below the async_tcp task, so deleting never stalls the web server.
+#define JOBS_TASK_PRIORITY 1
+
+// Number of jobs that can be waiting at once
+#define JOBS_QUEUE_LEN 8
+
+// Number of finished jobs to remember the status of
+#define JOBS_HISTORY 8
+
+/*
+        Export config
+*/
+// Comment out to never gzip exports
+// Exports to clients that send "Accept-Encoding: gzip" are compressed on the fly,
+// which makes JSON exports about 5x smaller over the air.
+#define EXPORT_GZIP
+
+// Number of exports that can be compressed at once
+// Each compressor takes about 10 KB, reserved at boot so exports never carve it
+// out of the heap. Exports past this are sent uncompressed.
+#define EXPORT_GZIP_SLOTS 1
+
+// Number of exports that can run at once
+// Each takes about 3.5 KB, reserved at boot. Requests past this get a 503.
+#define EXPORT_SLOTS 3
+
+// Add a resume point every this many bytes of output (before compression)
+// Range requests pick up from the last resume point before the range, so lower
+// values resume faster, but make compressed exports bigger (about 1% at 16 KB).
+#define EXPORT_RESUME_INTERVAL (16 * 1024)
+
+// Most resume points to keep per export
+// Long exports keep every other one once they run out, so this many always
+// cover the whole export.
+#define EXPORT_RESUME_POINTS 64
+
+/*
+        Live data config
+*/
+// Most live data clients to track at once
+// Clients past this still connect, but don't get any events.
+#define SSE_MAX_CLIENTS 8
+
+// Most events to queue per client before dropping new ones
+// Keeps a slow client's view of the live data at most this many samples behind,
+// and its queue from eating the heap.
+#define SSE_MAX_QUEUED 8
+
+// Disconnect clients whose queue has been full for this long (in ms)
+#define SSE_EVICT_MS 5000
+
+// Number of recent samples the latency summary covers (see latency.hpp)
+#define LATENCY_WINDOW 128
+
+/*
+        Network self-test config
+*/
+// Comment out to remove the /bench endpoints (see netbench.hpp)
+#define NET_BENCH
+
+// Largest download to generate (in MB)
+#define NET_BENCH_MAX_MB 64
+
+// Fastest rate to send synthetic events at (in Hz)
+#define NET_BENCH_MAX_RATE 500
+
+// Longest synthetic event run (in seconds)
+#define NET_BENCH_MAX_SECONDS 60
+
+/*
+        Replay config
+*/
+// Fastest a recording can be replayed, as a multiple of real time
+#define REPLAY_MAX_SPEED 20
+
+// Stack size of the replay task (in bytes)
+#define REPLAY_TASK_STACK 4096
+
+// Priority of the replay task
+#define REPLAY_TASK_PRIORITY 1
+
+/*
+        Heap config
+*/
+// Take a heap sample this often, for the fragmentation report (in ms)
+#define HEAP_SAMPLE_INTERVAL (60 * 1000)
+
+// Number of heap samples to keep (an hour's worth, by default)
+#define HEAP_SAMPLES 60
+
+// Number of tasks whose allocations can be counted
+// Only used by the esp32dev-heapcheck environment, which defines HEAP_CHECK.
+#define HEAP_CHECK_TASKS 4
+
 /*
         Logging Config
 */
@@ -88,6 +314,18 @@
 // Offset for DST. Should be just one hour
 #define NTP_DST_OFFSET_SEC 3600
 
+// How long to wait for each time sync attempt (in ms)
+#define NTP_SYNC_TIMEOUT 10000
+
+// NTP syncs closer together than this (in ms) don't update the drift estimate
+#define TIMESYNC_MIN_INTERVAL 60000
+
+// Drift (in ppm) beyond which a sync is treated as a clock step, not drift
+#define TIMESYNC_MAX_DRIFT_PPM 500
+
+// How much of each new drift measurement to take (1/n)
+#define TIMESYNC_DRIFT_SMOOTHING 4
+
 /*
         EEPROM config
 */
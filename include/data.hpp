@@ -35,29 +35,45 @@
 #include <ArduinoJson.h>
 #include <helper_3dmath.h>
 
-#define MPU_DATA_JSON_SIZE     208
+#define MPU_DATA_JSON_SIZE     224
 #define MPU_DATA_JSON_ARR_SIZE 224
 
 /**
  * @brief A struct for holding raw MPU data measurements
  */
 struct mpu_data_t {
-    float ypr[3];       // [yaw, pitch, roll]  (radians)
-    VectorFloat accel;  // [a_x, a_y, a_z]     (w/o gravity, m/s^2)
-    VectorFloat gyro;   // [g_x, g_y, g_z]     (rad / s)
-    unsigned long time; // millis()
+    float ypr[3];            // [yaw, pitch, roll]  (radians)
+    VectorFloat accel;       // [a_x, a_y, a_z]     (w/o gravity, m/s^2)
+    VectorFloat gyro;        // [g_x, g_y, g_z]     (°/s)
+    unsigned long time;      // When it was sampled (ms since boot, like millis())
+    int64_t time_us = 0;     // The same, in us, or 0 if unknown (e.g. replayed)
+    uint32_t decoded_us = 0; // When it was decoded, in us after time_us
 
     /**
      * @brief Convert this data struct to a JSON.
      *
+     * Once the time is synced, includes when it was sampled in epoch time (see
+     * timesync.hpp).
+     *
      * @return A new JsonObject with this struct's data.
      */
-    StaticJsonDocument<MPU_DATA_JSON_SIZE> to_json();
+    StaticJsonDocument<MPU_DATA_JSON_SIZE> to_json() const;
 };
 
+/**
+ * @brief Set up data processing.
+ *
+ * Must be called before anything else here.
+ *
+ * @return bool If the setup was successful.
+ */
+bool data_setup();
+
 /**
  * @brief Process new MPU measurements.
  *
+ * Runs on the data task (see tasks.hpp).
+ *
  * @param meas The new measurements.
  */
 void data_process_measurement(mpu_data_t meas);
@@ -65,14 +81,25 @@ void data_process_measurement(mpu_data_t meas);
 /**
  * @brief Start recording data.
  *
+ * Recordings are named after the current time by default. Until the time is
+ * synced, they get a placeholder name ("boot-<boot ID>-<ms since boot>"), and
+ * are renamed after the time they started once it is (see data_time_synced()).
+ *
  * @param recording_len How long to record for.
- * @param filename The filename to record to.
+ * @param name The recording to create, without the extension.
+ */
+void data_start_recording(uint32_t recording_len, const char* name = nullptr);
+
+/**
+ * @brief Rename the recordings made before the time was synced.
+ *
+ * Call once the time has been synced.
  */
-void data_start_recording(uint32_t recording_len, String filename = iso8601_str());
+void data_time_synced();
 
 /**
- * @brief Clear recording data.
+ * @brief Check if we are currently recording.
  *
- * @return If the operation was successful.
+ * @return If a recording is in progress.
  */
-bool data_clear_recordings();
+bool data_is_recording();
@@ -0,0 +1,100 @@
+/**
+ * @file downsample.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Streaming min/max downsampling.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include "data.hpp"
+
+// Number of channels in a sample (ypr, accel, gyro)
+#define DOWNSAMPLE_CHANNELS 9
+
+/**
+ * @brief Downsamples a stream of samples in a single pass.
+ *
+ * Splits the time range into max_points / 2 equal buckets, and replaces the
+ * samples in each bucket with two: one at the start of the bucket and one at
+ * the end. Between them, they hold the minimum and maximum of every channel,
+ * in the order they happened. Peaks survive, so a preview looks like the full
+ * recording, and only one bucket is ever kept in RAM.
+ */
+class Downsampler {
+    uint32_t start_ = 0; // Time the first bucket starts at
+    uint32_t width_ = 1; // Length of a bucket (in ms)
+
+    // The bucket being filled
+    uint32_t bucket_ = 0;  // Index of the bucket
+    uint32_t count_ = 0;   // Samples in the bucket
+    uint32_t first_ = 0;   // Time of the first sample
+    uint32_t last_ = 0;    // Time of the last sample
+    float min_[DOWNSAMPLE_CHANNELS];
+    float max_[DOWNSAMPLE_CHANNELS];
+    bool max_first_[DOWNSAMPLE_CHANNELS]; // If the max came before the min
+
+    // Output of the last finished bucket
+    mpu_data_t out_[2];
+    uint8_t out_len_ = 0;
+    uint8_t out_pos_ = 0;
+
+    void flush_();
+
+ public:
+    /**
+     * @brief Start downsampling.
+     *
+     * @param from Time of the first sample that may come.
+     * @param to Time of the last sample that may come.
+     * @param max_points Most samples to output, at least 2.
+     */
+    void begin(uint32_t from, uint32_t to, uint16_t max_points);
+
+    /**
+     * @brief Add the next sample.
+     *
+     * Samples must come in order.
+     *
+     * @param sample The sample.
+     */
+    void add(const mpu_data_t& sample);
+
+    /**
+     * @brief Finish the last bucket, once all samples have been added.
+     *
+     * Does nothing if there's nothing left to finish.
+     */
+    void finish();
+
+    /**
+     * @brief Get the next downsampled sample.
+     *
+     * @param sample Container to save the sample to.
+     * @return If a sample was ready.
+     */
+    bool next(mpu_data_t* sample);
+};
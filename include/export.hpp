@@ -0,0 +1,299 @@
+/**
+ * @file export.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Streaming recording exports.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include "config.h"
+#include "downsample.hpp"
+#include "gzip.hpp"
+#include "recording.hpp"
+
+// Longest piece of output the exporter formats at once (in bytes)
+#define EXPORT_CARRY_SIZE 256
+
+/*
+ * All formats use the same units: yaw/pitch/roll in degrees, acceleration in
+ * m/s^2, rotation in °/s, and time in ms since the device booted.
+ *
+ * JSON: {"data":[{"ypr":[y,p,r],"accel":[x,y,z],"gyro":[x,y,z],"time":t},...]}
+ *
+ * CSV: A header row, then a row per sample:
+ *      time,yaw,pitch,roll,accel_x,accel_y,accel_z,gyro_x,gyro_y,gyro_z
+ *
+ * Binary: An export_bin_header_t, then an export_bin_sample_t per sample until
+ *         the end of the response. Everything is little-endian, and floats are
+ *         IEEE 754 single precision. In Python, that's
+ *         struct.unpack("<I9f", ...) per sample.
+ */
+
+#define EXPORT_BIN_MAGIC   0x58455753 // "SWEX"
+#define EXPORT_BIN_VERSION 1
+
+/**
+ * @brief The header at the start of a binary export.
+ */
+struct __attribute__((packed)) export_bin_header_t {
+    uint32_t magic;       // EXPORT_BIN_MAGIC
+    uint16_t version;     // EXPORT_BIN_VERSION
+    uint16_t sample_size; // sizeof(export_bin_sample_t)
+};
+
+/**
+ * @brief A sample in a binary export.
+ */
+struct __attribute__((packed)) export_bin_sample_t {
+    uint32_t time;   // ms
+    float ypr[3];    // degrees
+    float accel[3];  // m/s^2
+    float gyro[3];   // °/s
+};
+
+static_assert(sizeof(export_bin_sample_t) == 40, "Binary samples must be 40 bytes");
+
+/**
+ * @brief A point an export can be picked up from, without generating everything
+ * before it again.
+ *
+ * Resume points are between two samples. In compressed exports, they are also
+ * gzip sync points.
+ */
+struct export_resume_t {
+    uint32_t out;     // Bytes of output before it
+    uint32_t raw;     // Bytes of output before it, before compression
+    uint32_t crc;     // CRC32 of the output before it, before compression
+    uint32_t time;    // Time of the next sample (or a bit before it)
+    uint32_t samples; // Samples exported before it
+};
+
+/**
+ * @brief The formats a recording can be exported as.
+ */
+enum ExportFormat {
+    EXPORT_JSON,   // application/json
+    EXPORT_CSV,    // text/csv
+    EXPORT_BINARY, // application/octet-stream
+};
+
+/**
+ * @brief Parse an export format name ("json", "csv", or "bin").
+ *
+ * @param str The format name.
+ * @param format Container to save the format to.
+ * @return If the name was valid.
+ */
+bool export_format_parse(const String& str, ExportFormat* format);
+
+/**
+ * @brief The MIME type of an export format.
+ */
+const char* export_format_mime(ExportFormat format);
+
+/**
+ * @brief The file extension of an export format, without the dot.
+ */
+const char* export_format_ext(ExportFormat format);
+
+/**
+ * @brief Exports a recording, a chunk at a time.
+ *
+ * Made for chunked HTTP responses: every call to fill() fills the chunk
+ * completely. Output that doesn't fit is carried over to the next call, so no
+ * sample is ever dropped. Samples are formatted straight to the output,
+ * without building a JSON document for each one.
+ */
+class RecExporter {
+    RecReader reader_;
+    ExportFormat format_ = EXPORT_JSON;
+
+    uint32_t from_ = 0;        // Start of the window
+    uint32_t to_ = UINT32_MAX; // End of the window
+
+    Downsampler downsampler_;
+    bool downsample_ = false; // If we're downsampling
+
+    char carry_[EXPORT_CARRY_SIZE]; // Output that didn't fit in the last chunk
+    size_t carry_len_ = 0;          // Bytes in the carry-over buffer
+    size_t carry_pos_ = 0;          // Bytes of it already sent
+
+    enum {
+        EXPORT_HEADER,  // Nothing sent yet
+        EXPORT_SAMPLES, // Sending samples
+        EXPORT_FOOTER,  // All samples sent
+        EXPORT_DONE,    // Everything sent
+    } state_ = EXPORT_HEADER;
+
+    GzipEncoder* gzip_ = nullptr; // Compresses the output, if compressing
+
+    // Resume points, one every EXPORT_RESUME_INTERVAL bytes, but only every
+    // resume_stride_-th one is kept
+    export_resume_t resumes_[EXPORT_RESUME_POINTS];
+    size_t resumes_len_ = 0;
+    uint32_t resume_count_ = 0;      // Resume points so far, kept or not
+    uint32_t resume_stride_ = 1;     // Keep every this many resume points
+    uint32_t next_resume_ = 0;       // Add a resume point after this many bytes
+    bool resume_due_ = false;        // If one is due at the next sample boundary
+    export_resume_t resume_due_at_;  // Where it is, for compressed exports
+    uint32_t syncs_ = 0;             // gzip sync points seen so far
+
+    uint32_t produced_ = 0;  // Bytes of output generated, before compression
+    uint32_t last_time_ = 0; // Time of the last sample generated
+
+    // Stats
+    uint32_t samples_ = 0;   // Samples exported
+    uint32_t raw_bytes_ = 0; // Bytes of output, before compression
+    uint32_t bytes_ = 0;     // Bytes of output
+
+    bool next_sample_(mpu_data_t* sample);
+    size_t header_(char* buf);
+    size_t next_(char* buf);
+    size_t fill_raw_(uint8_t* buf, size_t max_len);
+    void add_resume_(const export_resume_t& point);
+    bool resume_point_();
+    void free_gzip_();
+
+ public:
+    RecExporter() = default;
+    RecExporter(const RecExporter&) = delete;
+    RecExporter& operator=(const RecExporter&) = delete;
+    ~RecExporter() { free_gzip_(); }
+
+    /**
+     * @brief Start exporting a recording.
+     *
+     * @param file The recording to export.
+     * @param format What to export the recording as.
+     * @return If the recording could be read.
+     */
+    bool begin(RecFile file, ExportFormat format = EXPORT_JSON);
+
+    /**
+     * @brief Only export samples in a time window.
+     *
+     * @param from Start of the window, in ms since the start of the recording.
+     * @param to End of the window (inclusive), in ms since the start of the
+     * recording.
+     * @return If the seek was successful.
+     */
+    bool seek(uint32_t from, uint32_t to = UINT32_MAX);
+
+    /**
+     * @brief Downsample the export to at most `max_points` samples.
+     *
+     * Keeps the minimum and maximum of every channel (see Downsampler). Call
+     * after seek(), if seeking at all.
+     *
+     * @param max_points Most samples to export, at least 2.
+     * @return If the recording could be read.
+     */
+    bool downsample(uint16_t max_points);
+
+    /**
+     * @brief Gzip the output (see GzipEncoder).
+     *
+     * Call before the first fill(). Compressors come from a pool of
+     * EXPORT_GZIP_SLOTS, so this fails while they're all in use.
+     *
+     * @return If the output will be compressed.
+     */
+    bool compress();
+
+    /**
+     * @brief Pick up from a resume point of an earlier export.
+     *
+     * The earlier export must have had the same recording and parameters. Call
+     * after seek() and compress(), before the first fill(). Downsampled exports
+     * can't be resumed.
+     *
+     * @param point The resume point.
+     * @return If the recording could be read from there.
+     */
+    bool resume(const export_resume_t& point);
+
+    /**
+     * @brief Write the next chunk of output.
+     *
+     * @param buf Container to write the output to.
+     * @param max_len Size of the container.
+     * @return How much was written. Less than `max_len` only at the end of the
+     * export, 0 once everything has been written.
+     */
+    size_t fill(uint8_t* buf, size_t max_len);
+
+    /**
+     * @brief Close the recording.
+     */
+    void close();
+
+    /**
+     * @brief The random ID of the recording being exported.
+     */
+    uint32_t id() const { return reader_.id(); }
+
+    /**
+     * @brief The length of the recording being exported (in bytes).
+     */
+    size_t size() const { return reader_.size(); }
+
+    /**
+     * @brief The format being exported.
+     */
+    ExportFormat format() const { return format_; }
+
+    /**
+     * @brief Number of samples exported so far.
+     */
+    uint32_t samples() const { return samples_; }
+
+    /**
+     * @brief If the output is being compressed.
+     */
+    bool compressed() const { return gzip_ != nullptr; }
+
+    /**
+     * @brief Number of bytes of output so far, before compression.
+     */
+    uint32_t raw_bytes() const { return raw_bytes_; }
+
+    /**
+     * @brief Number of bytes of output so far.
+     */
+    uint32_t bytes() const { return bytes_; }
+
+    /**
+     * @brief The resume points of the export so far, in order.
+     *
+     * @param len Container to save the number of resume points to.
+     */
+    const export_resume_t* resume_points(size_t* len) const
+    {
+        *len = resumes_len_;
+        return resumes_;
+    }
+};
@@ -0,0 +1,150 @@
+/**
+ * @file gorilla.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Gorilla-style compression for recorded samples.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Compresses a series of (time, values) samples the way Facebook's Gorilla TSDB
+ * does:
+ *
+ * - Times are stored as the delta of the delta to the previous time, in us.
+ *   Samples are evenly spaced, so this is usually a single 0 bit, or a few bits
+ *   of interrupt jitter.
+ * - Values are XOR-ed with the previous value of the same channel, and only the
+ *   meaningful bits of the XOR are stored. Orientation and acceleration change
+ *   slowly between samples, so most of the bits cancel out.
+ *
+ * Each encoder/decoder run is independent, so every block of a recording can be
+ * decoded on its own. Times are a ms part (like millis()) and the us past it.
+ * Older encoders stored only the ms part, and the decoder can still read those.
+ *
+ * Doesn't depend on Arduino, so host tools can use it too.
+ */
+
+// Number of float channels in a sample
+#define GORILLA_CHANNELS 9
+
+// Worst-case size of an encoded sample, in bits
+#define GORILLA_MAX_SAMPLE_BITS (69 + GORILLA_CHANNELS * 44)
+
+/**
+ * @brief Compresses samples into a buffer.
+ */
+class GorillaEncoder {
+    uint8_t* buf_ = nullptr;
+    size_t cap_bits_ = 0;
+    size_t bits_ = 0;
+
+    uint32_t count_ = 0;
+    uint64_t time_ = 0; // In us
+    int64_t delta_ = 0;
+    uint32_t values_[GORILLA_CHANNELS];
+    uint8_t leading_[GORILLA_CHANNELS];
+    uint8_t trailing_[GORILLA_CHANNELS];
+
+    void write_bits_(uint32_t val, uint8_t nbits);
+    void encode_time_(uint64_t time);
+    void encode_value_(size_t channel, uint32_t val);
+
+ public:
+    /**
+     * @brief Start compressing into a new buffer.
+     *
+     * @param buf The buffer to write to.
+     * @param len The size of the buffer, in bytes.
+     */
+    void begin(uint8_t* buf, size_t len);
+
+    /**
+     * @brief Compress a sample.
+     *
+     * The caller must check there is room with `has_room()` first.
+     *
+     * @param time The sample time, in ms.
+     * @param time_us The us past `time`, 0-999.
+     * @param values The sample values, GORILLA_CHANNELS of them.
+     */
+    void encode(uint32_t time, uint16_t time_us, const float* values);
+
+    /**
+     * @brief Check if there is room for another sample, even in the worst case.
+     */
+    bool has_room() const { return bits_ + GORILLA_MAX_SAMPLE_BITS <= cap_bits_; }
+
+    /**
+     * @brief Get the number of bytes used so far.
+     */
+    size_t size() const { return (bits_ + 7) / 8; }
+};
+
+/**
+ * @brief Decompresses samples from a buffer, one at a time.
+ */
+class GorillaDecoder {
+    const uint8_t* buf_ = nullptr;
+    size_t len_bits_ = 0;
+    size_t bits_ = 0;
+
+    bool ms_only_ = false; // If times are in ms, from an older encoder
+    uint32_t count_ = 0;
+    uint64_t time_ = 0; // In us (or ms)
+    int64_t delta_ = 0;
+    uint32_t values_[GORILLA_CHANNELS];
+    uint8_t leading_[GORILLA_CHANNELS];
+    uint8_t trailing_[GORILLA_CHANNELS];
+
+    bool read_bits_(uint8_t nbits, uint32_t* val);
+    bool decode_time_();
+    bool decode_value_(size_t channel);
+
+ public:
+    /**
+     * @brief Start decompressing a buffer.
+     *
+     * @param buf The buffer to read from.
+     * @param len The size of the buffer, in bytes.
+     * @param ms_only If the times were stored in ms only (recording versions
+     * before 7). The us parts decode as 0.
+     */
+    void begin(const uint8_t* buf, size_t len, bool ms_only = false);
+
+    /**
+     * @brief Decompress the next sample.
+     *
+     * @param time Container to save the sample time (in ms) to.
+     * @param time_us Container to save the us past `time` to.
+     * @param values Container to save the GORILLA_CHANNELS sample values to.
+     * @return If a sample was decoded. False if the buffer is truncated.
+     */
+    bool decode(uint32_t* time, uint16_t* time_us, float* values);
+};
@@ -0,0 +1,188 @@
+/**
+ * @file gzip.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Streaming gzip compression.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/*
+ * A small streaming gzip (RFC 1952) compressor, for compressing responses on the
+ * fly.
+ *
+ * miniz's compressor needs ~320 KB of state, more than the ESP32 has, so this
+ * one trades ratio for RAM:
+ *
+ * - Matches are only searched for in the last GZIP_WINDOW bytes, following at
+ *   most GZIP_MAX_CHAIN earlier positions with the same hash.
+ * - Everything goes in fixed-Huffman blocks, so there are no code tables to
+ *   build or send.
+ *
+ * Exports repeat the same keys and similar numbers over and over, so even this
+ * finds most of the redundancy.
+ *
+ * sync() flushes the output to a byte boundary and forgets the window, like
+ * zlib's Z_FULL_FLUSH. Everything after a sync point only depends on what comes
+ * after it, so a new encoder can pick up from there (see gzip_sync_t).
+ */
+
+// Size of the match window, in bytes (a power of 2, at most 32 KB)
+#define GZIP_WINDOW 2048
+
+// Bits in the hash of the next 3 bytes
+#define GZIP_HASH_BITS 10
+
+// Most earlier positions to try per match
+#define GZIP_MAX_CHAIN 8
+
+// Shortest and longest matches deflate can encode
+#define GZIP_MIN_MATCH 3
+#define GZIP_MAX_MATCH 258
+
+/**
+ * @brief Reads uncompressed data to compress.
+ *
+ * @param buf Container to write the data to.
+ * @param len Size of the container.
+ * @return How much was written. Less than `len` only at the end of the data, 0
+ * once everything has been read.
+ */
+using gzip_source_t = std::function<size_t(uint8_t* buf, size_t len)>;
+
+/**
+ * @brief Where a sync point is, and what the encoder needs to resume from it.
+ */
+struct gzip_sync_t {
+    uint32_t in;  // Uncompressed bytes before it
+    uint32_t out; // Compressed bytes before it
+    uint32_t crc; // CRC32 of the uncompressed bytes before it
+};
+
+/**
+ * @brief Compresses a stream, a chunk at a time.
+ */
+class GzipEncoder {
+    gzip_source_t source_;
+
+    uint8_t window_[2 * GZIP_WINDOW];     // Already compressed data and lookahead
+    uint16_t head_[1 << GZIP_HASH_BITS];  // Last position + 1 of each hash
+    uint16_t prev_[GZIP_WINDOW];          // Previous position + 1 with the same hash
+    size_t len_ = 0;                      // Bytes in the window
+    size_t pos_ = 0;                      // Next byte to compress
+    bool eof_ = false;                    // If the source is empty
+    bool sync_ = false;                   // If a sync was asked for
+
+    uint64_t bits_ = 0; // Output bits that don't make a byte yet
+    uint8_t nbits_ = 0; // Number of them
+
+    enum {
+        GZIP_HEADER,  // Writing the gzip header
+        GZIP_BLOCK,   // Starting a block
+        GZIP_DATA,    // Compressing
+        GZIP_TRAILER, // Writing the gzip trailer
+        GZIP_DONE,    // Everything written
+    } state_ = GZIP_HEADER;
+    uint8_t idx_ = 0; // Bytes of the header/trailer written
+
+    uint32_t crc_ = 0;      // CRC32 of the uncompressed data
+    uint32_t in_size_ = 0;  // Uncompressed bytes
+    uint32_t out_size_ = 0; // Compressed bytes
+
+    gzip_sync_t last_sync_ = {}; // The last sync point
+    uint32_t syncs_ = 0;         // Number of sync points so far
+
+    void put_bits_(uint32_t val, uint8_t nbits);
+    void put_literal_(uint16_t lit);
+    void put_match_(size_t len, size_t dist);
+
+    void read_();
+    void insert_(size_t pos);
+    size_t find_match_(size_t* dist);
+    void flush_();
+    void step_();
+
+ public:
+    /**
+     * @brief Start compressing.
+     *
+     * @param source Where to read the data to compress from.
+     */
+    void begin(gzip_source_t source);
+
+    /**
+     * @brief Start compressing from a sync point of an earlier encoder.
+     *
+     * The output is the same as the earlier encoder's from the sync point on, as
+     * long as the source gives the same data and asks for the same syncs.
+     *
+     * @param source Where to read the data after the sync point from.
+     * @param from The sync point.
+     */
+    void begin(gzip_source_t source, const gzip_sync_t& from);
+
+    /**
+     * @brief Add a sync point once everything read so far is compressed.
+     *
+     * Meant to be called from the source. A source that asks for a sync may
+     * return 0 bytes without ending the stream.
+     */
+    void sync() { sync_ = true; }
+
+    /**
+     * @brief Write the next chunk of compressed output.
+     *
+     * @param buf Container to write the output to.
+     * @param max_len Size of the container.
+     * @return How much was written. Less than `max_len` only at the end of the
+     * stream, 0 once everything has been written.
+     */
+    size_t fill(uint8_t* buf, size_t max_len);
+
+    /**
+     * @brief Number of uncompressed bytes read so far.
+     */
+    uint32_t in_size() const { return in_size_; }
+
+    /**
+     * @brief Number of compressed bytes written so far.
+     */
+    uint32_t out_size() const { return out_size_; }
+
+    /**
+     * @brief Number of sync points so far.
+     */
+    uint32_t syncs() const { return syncs_; }
+
+    /**
+     * @brief The last sync point.
+     */
+    const gzip_sync_t& last_sync() const { return last_sync_; }
+};
@@ -0,0 +1,85 @@
+/**
+ * @file heap.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Heap fragmentation tracking and allocation checks.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief A snapshot of the heap.
+ */
+struct heap_sample_t {
+    uint32_t time;     // When it was taken (in ms)
+    uint32_t free;     // Free heap (in bytes)
+    uint32_t largest;  // Largest block that can be allocated (in bytes)
+    uint32_t min_free; // Lowest free heap since boot (in bytes)
+};
+
+/**
+ * @brief Take a heap sample every HEAP_SAMPLE_INTERVAL ms.
+ *
+ * The last HEAP_SAMPLES are kept for the fragmentation report.
+ */
+void heap_loop();
+
+/**
+ * @brief Log the heap now and over time.
+ *
+ * When the free heap holds steady but the largest block shrinks, the heap is
+ * fragmenting, and big allocations (like TLS or exports) will start failing.
+ */
+void heap_print_report();
+
+#ifdef HEAP_CHECK
+/**
+ * @brief Start counting the allocations made by the calling task.
+ *
+ * Only in HEAP_CHECK builds, which wrap malloc() (see platformio.ini). Up to
+ * HEAP_CHECK_TASKS tasks can be watched.
+ */
+void heap_check_watch();
+
+/**
+ * @brief Number of allocations the calling task has made since it started
+ * being watched.
+ */
+uint32_t heap_check_allocs();
+#else
+inline void
+heap_check_watch()
+{
+}
+
+inline uint32_t
+heap_check_allocs()
+{
+    return 0;
+}
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file jobs.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Background storage jobs.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <ArduinoJson.h>
+
+/**
+ * @brief Kinds of background storage jobs.
+ */
+enum JobType {
+    JOB_DELETE,    // Remove a single recording
+    JOB_CLEAR,     // Remove every recording
+    JOB_RETENTION, // Apply REC_KEEP_LAST and REC_MAX_BYTES
+};
+
+/**
+ * @brief Where a job is at.
+ */
+enum JobState {
+    JOB_QUEUED,  // Waiting for the worker
+    JOB_RUNNING, // Being worked on
+    JOB_DONE,    // Finished successfully
+    JOB_FAILED,  // Finished, but something could not be removed
+};
+
+/**
+ * @brief The status of a background storage job.
+ */
+struct job_t {
+    uint32_t id;       // Job ID, never 0
+    JobType type;      // What the job does
+    JobState state;    // Where the job is at
+    char name[32];     // Recording to remove, for JOB_DELETE
+    uint16_t removed;  // Recordings removed so far
+    uint16_t failed;   // Recordings that could not be removed
+    uint32_t freed;    // Bytes freed so far
+    uint32_t start_ms; // When the job started running
+    uint32_t end_ms;   // When the job finished
+
+    /**
+     * @brief Convert this job's status to a JSON.
+     *
+     * @return A new JsonDocument with the status.
+     */
+    StaticJsonDocument<256> to_json() const;
+};
+
+/**
+ * @brief Start the storage worker.
+ *
+ * Deleting recordings means blocking flash erases, so it happens on this task
+ * instead of the web server or the sampling loop. Also queues a retention pass
+ * for whatever is already stored.
+ *
+ * @return bool If the worker was started.
+ */
+bool jobs_setup();
+
+/**
+ * @brief Queue a job for the storage worker.
+ *
+ * @param type The kind of job.
+ * @param name The recording to remove, for JOB_DELETE.
+ * @return The job ID, or 0 if the queue is full.
+ */
+uint32_t jobs_submit(JobType type, const char* name = nullptr);
+
+/**
+ * @brief Get the status of a recent job.
+ *
+ * @param id The job ID.
+ * @param job Container to save the status to.
+ * @return If the job was found (only the last JOBS_HISTORY jobs are kept).
+ */
+bool jobs_status(uint32_t id, job_t* job);
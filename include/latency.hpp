@@ -0,0 +1,125 @@
+/**
+ * @file latency.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Tracing the latency of live samples.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <ArduinoJson.h>
+
+#include <cstdint>
+
+/*
+ * While tracing is on, every live sample gets a "trace" field with when it
+ * passed each stage on the tracker, in us after its data ready interrupt:
+ *
+ *     "trace": [decoded, dequeued, encoded]
+ *
+ * - decoded: read from the MPU6050 and decoded by the acquisition task
+ * - dequeued: picked up by the data task
+ * - encoded: serialized, and about to be handed to the event source
+ *
+ * The dashboard adds when it received and rendered the sample. Handing the
+ * event to every client (the send stage) ends after the event is encoded, so
+ * it's only in the summary here.
+ */
+
+/**
+ * @brief The stages a live sample goes through on the tracker.
+ */
+enum latency_stage_t {
+    LATENCY_ACQUIRE, // Interrupt to decoded
+    LATENCY_QUEUE,   // Decoded to picked up by the data task
+    LATENCY_ENCODE,  // Picked up to serialized
+    LATENCY_SEND,    // Serialized to handed to every client
+    LATENCY_TOTAL,   // Interrupt to handed to every client
+
+    LATENCY_STAGES
+};
+
+/**
+ * @brief When a live sample passed each stage (in us since boot).
+ */
+struct latency_trace_t {
+    int64_t isr_us;
+    int64_t decoded_us;
+    int64_t dequeued_us;
+    int64_t encoded_us;
+    int64_t sent_us;
+};
+
+/**
+ * @brief How long the last LATENCY_WINDOW traced samples spent in each stage.
+ */
+struct latency_summary_t {
+    bool enabled;   // If tracing is on
+    uint32_t count; // Samples traced since tracing was turned on
+
+    struct {
+        uint32_t p50_us;
+        uint32_t p95_us;
+        uint32_t max_us;
+    } stages[LATENCY_STAGES];
+
+    /**
+     * @brief Convert this summary to a JSON.
+     *
+     * @return A new JsonDocument with the summary.
+     */
+    StaticJsonDocument<512> to_json() const;
+};
+
+/**
+ * @brief Turn tracing on or off.
+ *
+ * Turning it on starts a new summary.
+ *
+ * @param enabled If live samples should be traced.
+ */
+void latency_enable(bool enabled);
+
+/**
+ * @brief Check if tracing is on.
+ *
+ * @return If live samples are being traced.
+ */
+bool latency_enabled();
+
+/**
+ * @brief Add a traced sample to the summary.
+ *
+ * @param trace When it passed each stage.
+ */
+void latency_record(const latency_trace_t& trace);
+
+/**
+ * @brief Summarize the recently traced samples.
+ *
+ * @param summary Where to save the summary.
+ */
+void latency_summary(latency_summary_t* summary);
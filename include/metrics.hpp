@@ -0,0 +1,160 @@
+/**
+ * @file metrics.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Runtime performance counters.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include "config.h"
+#include "server.hpp"
+#include "tasks.hpp"
+
+#include <Arduino.h>
+
+// Longest piece of output the metrics writer formats at once (in bytes)
+#define METRICS_LINE_SIZE 256
+
+// Upper bounds of the recording write latency histogram buckets (in us)
+#define METRICS_WRITE_BUCKETS {10, 50, 100, 500, 1000, 5000, 10000, 50000}
+#define METRICS_WRITE_BUCKETS_LEN 8
+
+/**
+ * @brief Where sent bytes went.
+ */
+enum MetricsChannel {
+    METRICS_EVENTS,  // Live data events
+    METRICS_EXPORTS, // Recording downloads
+    METRICS_CHANNELS,
+};
+
+/**
+ * @brief A snapshot of every counter.
+ */
+struct metrics_t {
+    uint32_t uptime_ms;
+
+    // Main loop
+    uint32_t loops;     // Loop iterations
+    float loop_rate;    // Loop iterations per second, over the last second
+    uint32_t samples;   // Samples read from the MPU
+    uint32_t dropped;   // Samples missed, from gaps in their timestamps
+    float sample_rate;  // Samples per second, over the last second
+
+    // Network
+    uint32_t bytes_sent[METRICS_CHANNELS];
+    uint32_t sse_evicted;
+
+    // Recording writes
+    uint32_t write_buckets[METRICS_WRITE_BUCKETS_LEN + 1]; // Last one is +Inf
+    uint32_t write_count;
+    uint64_t write_sum_us;
+
+    // Memory
+    uint32_t heap_free;
+    uint32_t heap_max_alloc;
+    uint32_t heap_min_free;
+    uint32_t fs_used;
+    uint32_t fs_total;
+
+    // Tasks
+    task_stats_t tasks[TASK_COUNT];
+    size_t num_tasks;
+};
+
+/**
+ * @brief Count a main loop iteration, and update the rates once a second.
+ */
+void metrics_loop();
+
+/**
+ * @brief Count a sample read from the MPU.
+ *
+ * Samples are expected every MPU_SAMPLE_RATE ms, so longer gaps count as
+ * dropped samples.
+ *
+ * @param time The time of the sample (in ms).
+ */
+void metrics_sample(uint32_t time);
+
+/**
+ * @brief Count a recording write.
+ *
+ * @param us How long the write took (in us).
+ */
+void metrics_rec_write(uint32_t us);
+
+/**
+ * @brief Count bytes sent to a client.
+ *
+ * Safe to call from any task.
+ */
+void metrics_bytes_sent(MetricsChannel channel, size_t len);
+
+/**
+ * @brief Get a snapshot of every counter.
+ */
+void metrics_get(metrics_t* metrics);
+
+/**
+ * @brief Writes the metrics in the Prometheus text format, a chunk at a time.
+ *
+ * Like RecExporter, every call to fill() fills the chunk completely, and each
+ * line is formatted straight to the output.
+ */
+class MetricsWriter {
+    metrics_t metrics_;
+    sse_client_stats_t clients_[SSE_MAX_CLIENTS];
+    size_t num_clients_ = 0;
+
+    char carry_[METRICS_LINE_SIZE]; // Output that didn't fit in the last chunk
+    size_t carry_len_ = 0;          // Bytes in the carry-over buffer
+    size_t carry_pos_ = 0;          // Bytes of it already sent
+
+    uint8_t family_ = 0; // Metric being written
+    uint8_t idx_ = 0;    // Line of it being written
+
+    const task_stats_t* next_task_();
+    size_t step_(char* buf);
+    size_t next_(char* buf);
+
+ public:
+    /**
+     * @brief Take a snapshot of the metrics to write.
+     */
+    void begin();
+
+    /**
+     * @brief Write the next chunk of output.
+     *
+     * @param buf Container to write the output to.
+     * @param max_len Size of the container.
+     * @return How much was written. Less than `max_len` only at the end of the
+     * output, 0 once everything has been written.
+     */
+    size_t fill(uint8_t* buf, size_t max_len);
+};
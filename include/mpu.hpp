@@ -30,8 +30,21 @@
  */
 #pragma once
 
+#include "calib.hpp"
+
 #include <MPU6050_6Axis_MotionApps612.h>
 
+/**
+ * @brief The calibration state of the MPU6050.
+ */
+struct mpu_calib_t {
+    calib_t offsets;        // Offsets in use
+    int band = -1;          // Band they're from, -1 if none
+    float temp = 0;         // Last temperature reading (in °C)
+    size_t temp_band = 0;   // Band of the last temperature reading
+    bool requested = false; // If a calibration was requested
+};
+
 /**
  * @brief Set to true if the MPU6050 initialized correctly.
  */
@@ -43,7 +56,8 @@ extern bool dmp_ready;
  * 1. Starts the I2C bus
  * 2. Initializes the MPU6050
  * 3. Initializes the DMP.
- * 4. Calibrates the DMP.
+ * 4. Loads the stored offsets for the temperature, or calibrates the DMP if
+ *    there are none.
  * 5. Attaches an ISR for data ready.
  *
  * @return bool Whether or not the MPU6050 intialized successfully.
@@ -59,6 +73,62 @@ bool mpu_setup();
  */
 bool mpu_data_available();
 
+/**
+ * @brief Get when the packet read by mpu_data_available() was ready.
+ *
+ * Taken in the data ready interrupt, so it doesn't include the time spent
+ * waiting for the reader or reading the packet over I2C.
+ *
+ * @return The time (in us since boot, like esp_timer_get_time()).
+ */
+int64_t mpu_packet_time();
+
+/**
+ * @brief Wait for the MPU6050 to signal that a new packet is ready.
+ *
+ * Lets the reader sleep between packets instead of polling the FIFO.
+ *
+ * @param timeout_ms Longest to wait (in ms).
+ * @return bool If the MPU6050 signalled before the timeout.
+ */
+bool mpu_wait_data(uint32_t timeout_ms);
+
+/**
+ * @brief Keep the offsets in line with the temperature, and calibrate when
+ * needed.
+ *
+ * Switches to the stored offsets for the temperature when it changes bands. If
+ * its band has none, calibrates once the tracker has been still for
+ * CALIB_STILL_MS. Also runs the calibrations requested with
+ * mpu_request_calibration().
+ *
+ * Must be called after every sample, from the task reading the MPU6050. Samples
+ * are dropped while calibrating.
+ *
+ * @param accel The sample's real acceleration (in m/s^2).
+ * @param gyro The sample's gyroscope reading (in °/s).
+ * @param recording If we're recording or streaming samples over serial, which
+ * holds off automatic calibrations.
+ */
+void mpu_calibration_loop(
+    const VectorFloat& accel, const VectorFloat& gyro, bool recording
+);
+
+/**
+ * @brief Recalibrate the MPU6050 on the next sample.
+ *
+ * The tracker should be held still. Waits while samples are streamed over
+ * serial (see serialstream.hpp).
+ */
+void mpu_request_calibration();
+
+/**
+ * @brief Get the calibration state of the MPU6050.
+ *
+ * @param calib Where to save the state.
+ */
+void mpu_get_calibration(mpu_calib_t* calib);
+
 /**
  * @brief Get the real acceleration (without gravity).
  *
@@ -0,0 +1,60 @@
+/**
+ * @file mpumath.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief MPU6050 math that doesn't need the sensor.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <helper_3dmath.h>
+
+#include <cstdint>
+
+/**
+ * @brief Get the linear acceleration from the raw acceleration and gravity.
+ *
+ * Adapted from MPU6050::dmpGetLinearAccel, which uses the wrong multiplier for
+ * gravity (8192 instead of 16384).
+ *
+ * See https://github.com/jrowberg/i2cdevlib/issues/152#issuecomment-682319598
+ * for more details.
+ *
+ * @param v Container to save the linear acceleration to.
+ * @param vRaw The raw acceleration.
+ * @param gravity The gravity vector, in g.
+ * @return uint8_t Always 0, like the MPU6050 library.
+ */
+inline uint8_t
+get_linear_accel(VectorInt16* v, VectorInt16* vRaw, VectorFloat* gravity)
+{
+    // get rid of the gravity component (+1g = +16384 in standard DMP FIFO packet,
+    // sensitivity is 2g)
+    v->x = vRaw->x - gravity->x * 16384;
+    v->y = vRaw->y - gravity->y * 16384;
+    v->z = vRaw->z - gravity->z * 16384;
+    return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file netbench.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Network throughput self-tests.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+/*
+ * Endpoints for telling WiFi, the web server and the firmware apart when the
+ * dashboard is slow (see scripts/netbench.py):
+ *
+ * GET  /bench/download?mb=N   Stream N MB of generated data from RAM
+ * POST /bench/upload          Receive a body and throw it away
+ * POST /bench/events?rate=Hz&seconds=S&size=B
+ *                             Send "bench" events of B bytes at a fixed rate
+ * GET  /bench                 Device-side results of the last run of each
+ */
+
+/**
+ * @brief Device-side results of a network self-test.
+ */
+struct netbench_result_t {
+    uint32_t bytes;   // Bytes sent or received
+    uint32_t ms;      // How long it took
+    uint32_t events;  // Events sent, for the event test
+    uint32_t dropped; // Events dropped because a client's queue was full
+    uint32_t late;    // Events sent more than a period late
+    bool done;        // If the test finished
+
+    /**
+     * @brief Convert these results to a JSON.
+     *
+     * @return A new JsonDocument with the results.
+     */
+    StaticJsonDocument<160> to_json() const;
+};
+
+/**
+ * @brief Handle GET /bench/download.
+ */
+void netbench_download(AsyncWebServerRequest* req);
+
+/**
+ * @brief Handle a chunk of a POST /bench/upload body.
+ */
+void netbench_upload_body(
+    AsyncWebServerRequest* req, uint8_t* data, size_t len, size_t index, size_t total
+);
+
+/**
+ * @brief Handle POST /bench/upload, once the whole body is in.
+ */
+void netbench_upload(AsyncWebServerRequest* req);
+
+/**
+ * @brief Handle POST /bench/events.
+ */
+void netbench_events(AsyncWebServerRequest* req);
+
+/**
+ * @brief Handle GET /bench.
+ */
+void netbench_results(AsyncWebServerRequest* req);
@@ -0,0 +1,140 @@
+/**
+ * @file pool.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Fixed-size object pools in static storage.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <Arduino.h>
+
+#include <memory>
+#include <new>
+
+/**
+ * @brief A fixed number of objects in static storage, handed out at runtime.
+ *
+ * For big objects that come and go while running (exporters, compressors, ...),
+ * so they're never carved out of the heap and can't fragment it. The memory is
+ * reserved at boot. Objects are constructed by acquire() and destroyed by
+ * release(), so every user gets a fresh one.
+ *
+ * Safe to use from any task.
+ *
+ * @tparam T The object type.
+ * @tparam N The number of objects.
+ */
+template <typename T, size_t N>
+class StaticPool {
+    alignas(T) uint8_t storage_[N][sizeof(T)];
+    bool used_[N] = {};
+    uint32_t exhausted_ = 0; // Times nothing was free
+
+    portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+
+ public:
+    /**
+     * @brief Construct an object in a free slot.
+     *
+     * @param args Arguments for the constructor.
+     * @return The object, or nullptr if every slot is in use.
+     */
+    template <typename... Args>
+    T*
+    acquire(Args&&... args)
+    {
+        size_t i = 0;
+
+        portENTER_CRITICAL(&mux_);
+        while (i < N && used_[i])
+            i++;
+        if (i < N)
+            used_[i] = true;
+        else
+            exhausted_++;
+        portEXIT_CRITICAL(&mux_);
+
+        if (i == N)
+            return nullptr;
+        return new (storage_[i]) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Like acquire(), but the object is released with the last copy of the
+     * pointer.
+     *
+     * For objects that are captured by callbacks, like chunked responses. Only
+     * the reference count is allocated.
+     */
+    template <typename... Args>
+    std::shared_ptr<T>
+    acquire_shared(Args&&... args)
+    {
+        T* obj = acquire(std::forward<Args>(args)...);
+        if (!obj)
+            return nullptr;
+        return std::shared_ptr<T>(obj, [this](T* obj) { release(obj); });
+    }
+
+    /**
+     * @brief Destroy an object and free its slot.
+     *
+     * @param obj An object from acquire(), or nullptr.
+     */
+    void
+    release(T* obj)
+    {
+        if (!obj)
+            return;
+
+        size_t i = (reinterpret_cast<uint8_t*>(obj) - storage_[0]) / sizeof(T);
+        obj->~T();
+
+        portENTER_CRITICAL(&mux_);
+        used_[i] = false;
+        portEXIT_CRITICAL(&mux_);
+    }
+
+    /**
+     * @brief Number of objects handed out.
+     */
+    size_t
+    in_use()
+    {
+        size_t count = 0;
+        portENTER_CRITICAL(&mux_);
+        for (bool used : used_)
+            count += used;
+        portEXIT_CRITICAL(&mux_);
+        return count;
+    }
+
+    /**
+     * @brief Number of times acquire() found every slot in use.
+     */
+    uint32_t exhausted() const { return exhausted_; }
+};
@@ -0,0 +1,198 @@
+/**
+ * @file recformat.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief The on-flash layout of recordings.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include "config.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * A recording is a rec_header_t followed by blocks. Each block is a rec_block_t
+ * followed by `len` bytes of payload. There are a few kinds of blocks:
+ *
+ * - Sample blocks hold up to REC_BLOCK_SAMPLES raw samples.
+ * - Compressed blocks hold as many Gorilla-compressed samples as fit in
+ *   REC_BLOCK_SIZE (see gorilla.hpp). Each one decodes on its own.
+ * - Index blocks hold a sparse seek index: the time and offset of every
+ *   REC_INDEX_INTERVAL-th sample block. They are written as the recording
+ *   grows, and each one points back at the previous one.
+ * - Time sync blocks map the sample times to epoch time. One is written before
+ *   the next sample block whenever the time has been synced since the last one
+ *   (see timesync.hpp). Readers that don't know them skip them.
+ * - Padding blocks fill the space before the next REC_ALIGN boundary when the
+ *   next block wouldn't fit. If there isn't even room for a block header, the
+ *   space is left as zeros.
+ * - The trailer is the last block, and points at the last index block.
+ *
+ * Every block has a CRC seeded with the recording's random ID, so blocks left
+ * over from other recordings never validate. No block crosses a REC_ALIGN
+ * boundary, so every boundary starts a block. After a crash, rec_recover() can
+ * binary search for the last good boundary and only walk the damaged tail.
+ *
+ * Everything is append-only, so it works the same on both storage backends.
+ *
+ * The header's sequence number goes up with every recording made on the device,
+ * so recordings can be put in order even while their names are placeholders.
+ *
+ * Raw samples are rec_sample_t: the 9 float channels (ypr, accel, gyro), then
+ * the 32-bit time and the us past it, 44 bytes in all. Compressed blocks hold
+ * the same channels, in the same order. Sample times are in ms since boot, plus
+ * us, taken in the MPU6050's data ready interrupt. To get a sample's epoch time,
+ * map time * 1000 + time_us with the last time sync block before it, or the
+ * first one if there's none before it.
+ *
+ * Before version 7, samples were 40 bytes, without the us. Their best guess is
+ * time * 1000 + 500, the middle of the ms.
+ *
+ * The layout doesn't depend on Arduino, so host tools can use it too.
+ */
+
+#define REC_MAGIC   0x43525753 // "SWRC"
+#define REC_VERSION 7
+
+// Oldest version we can still read (5 only added time sync blocks, 6 the
+// sequence number in the header, 7 the us in sample times)
+#define REC_VERSION_MIN 4
+
+#define REC_BLOCK_MAGIC      0x4B42 // "BK"
+#define REC_COMPRESSED_MAGIC 0x4347 // "GC"
+#define REC_INDEX_MAGIC      0x5849 // "IX"
+#define REC_TIMESYNC_MAGIC   0x5354 // "TS"
+#define REC_PADDING_MAGIC    0x4450 // "PD"
+#define REC_TRAILER_MAGIC    0x5254 // "TR"
+
+// Blocks never cross a multiple of this (one flash sector)
+#define REC_ALIGN 4096
+
+static_assert(REC_BLOCK_SIZE <= REC_ALIGN, "Blocks must fit between boundaries");
+
+// Offset used for "no block"
+#define REC_NO_OFFSET 0xFFFFFFFF
+
+// Number of entries in an index block
+#define REC_INDEX_ENTRIES 32
+
+/**
+ * @brief The header at the start of every recording.
+ */
+struct rec_header_t {
+    uint32_t magic;       // REC_MAGIC
+    uint16_t version;     // REC_VERSION
+    uint16_t sample_size; // sizeof(rec_sample_t)
+    uint32_t id;          // Random ID, seeds the block CRCs
+    uint32_t seq;         // Creation order on this device (since version 6)
+};
+
+/**
+ * @brief Get the size of the header of a recording version.
+ *
+ * Versions before 6 have no sequence number.
+ */
+inline uint32_t
+rec_header_size(uint16_t version)
+{
+    return version >= 6 ? sizeof(rec_header_t) : offsetof(rec_header_t, seq);
+}
+
+/**
+ * @brief The header of a block.
+ */
+struct rec_block_t {
+    uint16_t magic; // REC_*_MAGIC
+    uint16_t count; // Number of samples (or index entries) in the block
+    uint32_t len;   // Length of the payload, in bytes
+    uint32_t crc;   // CRC32 of the fields above and the payload
+};
+
+/**
+ * @brief A raw sample.
+ */
+struct rec_sample_t {
+    float channels[9]; // ypr (rad), accel (m/s^2), gyro (°/s)
+    uint32_t time;     // ms since boot
+    uint16_t time_us;  // us past `time`, 0-999 (since version 7)
+    uint16_t reserved; // Always 0
+};
+
+static_assert(sizeof(rec_sample_t) == 44, "Raw samples are 44 bytes");
+
+/**
+ * @brief Get the size of a raw sample of a recording version.
+ *
+ * Versions before 7 have no us.
+ */
+inline uint32_t
+rec_sample_size(uint16_t version)
+{
+    return version >= 7 ? sizeof(rec_sample_t) : offsetof(rec_sample_t, time_us);
+}
+
+/**
+ * @brief A time sync block, mapping device time to epoch time.
+ *
+ *     epoch_us = sync.epoch_us + dt + dt * sync.drift_ppb / 1e9
+ *
+ * where dt = t_us - sync.timer_us, for a device time t_us (in us since boot).
+ */
+struct rec_timesync_t {
+    rec_block_t block; // REC_TIMESYNC_MAGIC
+    int32_t drift_ppb; // How much slower the device clock runs than NTP time
+    int64_t timer_us;  // A device time (in us since boot)
+    int64_t epoch_us;  // The epoch time it maps to (in us)
+};
+
+static_assert(sizeof(rec_timesync_t) == 32, "Time sync blocks are 32 bytes");
+
+/**
+ * @brief An entry in the seek index.
+ */
+struct rec_index_entry_t {
+    uint32_t time;   // Time of the first sample in the block
+    uint32_t offset; // Offset of the sample block
+};
+
+/**
+ * @brief An index block.
+ */
+struct rec_index_block_t {
+    rec_block_t block; // REC_INDEX_MAGIC
+    uint32_t prev;     // Offset of the previous index block, or REC_NO_OFFSET
+    rec_index_entry_t entries[REC_INDEX_ENTRIES];
+};
+
+/**
+ * @brief The trailer at the end of a closed recording.
+ */
+struct rec_trailer_t {
+    rec_block_t block; // REC_TRAILER_MAGIC
+    uint32_t index;    // Offset of the last index block, or REC_NO_OFFSET
+};
@@ -0,0 +1,236 @@
+/**
+ * @file recording.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Recording file format.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include "config.h"
+#include "data.hpp"
+#include "gorilla.hpp"
+#include "recformat.hpp"
+#include "storage.hpp"
+
+// Maximum number of samples in a block
+#define REC_BLOCK_SAMPLES \
+    ((REC_BLOCK_SIZE - sizeof(rec_block_t)) / sizeof(rec_sample_t))
+
+/**
+ * @brief Writes samples to a recording, one block at a time.
+ */
+class RecWriter {
+    RecFile file_;
+    uint32_t id_ = 0;               // Recording ID
+    uint8_t block_[REC_BLOCK_SIZE]; // Block being filled
+    uint16_t count_ = 0;            // Samples in the block
+    uint16_t capacity_ = 0;         // Size the block may grow to
+    uint32_t offset_ = 0;           // Bytes written so far
+    uint32_t last_sync_ = 0;        // When we last made the recording durable
+    uint32_t syncs_ = 0;            // Last time sync written (see timesync.hpp)
+
+    rec_index_block_t index_;  // Index block being filled
+    uint32_t since_index_ = 0; // Samples since the last index entry
+
+#ifdef REC_COMPRESS
+    GorillaEncoder encoder_;
+#endif
+
+    // Stats
+    uint32_t samples_ = 0;   // Samples written
+    uint32_t encode_us_ = 0; // Time spent encoding samples
+
+    size_t room_() const { return REC_ALIGN - offset_ % REC_ALIGN; }
+
+    bool start_block_();
+    bool write_block_(uint8_t* buf, size_t len);
+    bool write_timesync_();
+    bool write_padding_();
+    bool write_index_();
+
+ public:
+    /**
+     * @brief Start writing to a new recording.
+     *
+     * @param file The recording to write to.
+     * @return If the recording header was written.
+     */
+    bool begin(RecFile file);
+
+    /**
+     * @brief Add a sample to the recording.
+     *
+     * The sample is buffered until the block is full.
+     *
+     * @param sample The sample to add.
+     * @return If the write was successful.
+     */
+    bool write(const mpu_data_t& sample);
+
+    /**
+     * @brief Write out the current block, even if it isn't full.
+     *
+     * @return If the write was successful.
+     */
+    bool flush();
+
+    /**
+     * @brief Flush the current block and make everything so far durable.
+     *
+     * Runs automatically every REC_SYNC_INTERVAL ms.
+     *
+     * @return If the sync was successful.
+     */
+    bool sync();
+
+    /**
+     * @brief Flush and close the recording.
+     */
+    void close();
+
+    explicit operator bool() const { return (bool)file_; }
+};
+
+/**
+ * @brief Reads samples from a recording, one block at a time.
+ */
+class RecReader {
+    RecFile file_;
+    uint32_t id_ = 0;               // Recording ID
+    uint8_t block_[REC_BLOCK_SIZE]; // Current block, kept 4-byte aligned
+    uint16_t version_ = 0;          // Recording format version
+    uint16_t count_ = 0;            // Samples in the block
+    uint16_t idx_ = 0;              // Next sample to read
+    bool done_ = false;             // If we've read past the end
+    bool compressed_ = false;       // If the current block is compressed
+
+    GorillaDecoder decoder_;
+
+    uint32_t data_start_ = 0;  // Offset of the first block
+    uint32_t start_time_ = 0;  // Time of the first sample
+    uint32_t from_ = 0;        // Skip samples before this time
+    uint32_t to_ = UINT32_MAX; // Stop at samples after this time
+
+    bool load_block_();
+    uint32_t find_block_(uint32_t time);
+
+ public:
+    /**
+     * @brief Start reading a recording.
+     *
+     * @param file The recording to read.
+     * @return If the recording has a valid header.
+     */
+    bool begin(RecFile file);
+
+    /**
+     * @brief Read the next sample.
+     *
+     * @param sample Container to save the sample to.
+     * @return If there was a sample left to read.
+     */
+    bool next(mpu_data_t* sample);
+
+    /**
+     * @brief Only read samples in a time window.
+     *
+     * Uses the seek index to jump straight to the block containing `from`, so
+     * the cost depends on the size of the window, not the recording.
+     *
+     * @param from Start of the window, in ms since the start of the recording.
+     * @param to End of the window (inclusive), in ms since the start of the
+     * recording.
+     * @return If the seek was successful.
+     */
+    bool seek(uint32_t from, uint32_t to = UINT32_MAX);
+
+    /**
+     * @brief Find the time of the last sample.
+     *
+     * Uses the seek index to only read the end of the recording. Moves the read
+     * position, so seek() before reading afterwards.
+     *
+     * @param time Container to save the time to.
+     * @return If the recording has any samples.
+     */
+    bool end_time(uint32_t* time);
+
+    /**
+     * @brief The recording's random ID.
+     */
+    uint32_t id() const { return id_; }
+
+    /**
+     * @brief The length of the recording (in bytes).
+     */
+    size_t size() const { return file_.size(); }
+
+    /**
+     * @brief The time of the first sample.
+     */
+    uint32_t start_time() const { return start_time_; }
+
+    /**
+     * @brief Check if there may be more samples to read.
+     *
+     * @return Non-zero if there are more samples or blocks left.
+     */
+    int available();
+
+    /**
+     * @brief Close the recording.
+     */
+    void close();
+
+    explicit operator bool() const { return (bool)file_; }
+};
+
+/**
+ * @brief Read a recording's header.
+ *
+ * Leaves the file at the start of the recording.
+ *
+ * @param file The recording.
+ * @param header Container to save the header to. Recordings from before
+ * version 6 get a sequence number of 0.
+ * @return If the recording has a valid header.
+ */
+bool rec_read_header(RecFile& file, rec_header_t* header);
+
+/**
+ * @brief Find how much of an interrupted recording is intact.
+ *
+ * Binary searches the REC_ALIGN boundaries for the last one that starts with a
+ * valid block, then walks the blocks after it. Only the tail gets read, so this
+ * stays fast no matter how long the recording is.
+ *
+ * @param file The recording.
+ * @param max_len How far the recording could possibly extend.
+ * @return The length of the intact part of the recording, 0 if even the header
+ * is damaged.
+ */
+uint32_t rec_recover(RecFile& file, uint32_t max_len);
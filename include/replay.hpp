@@ -0,0 +1,93 @@
+/**
+ * @file replay.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Recording replay over the live event stream.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <ArduinoJson.h>
+
+/**
+ * @brief The status of the current (or last) replay.
+ */
+struct replay_status_t {
+    bool running;      // If a replay is in progress
+    char name[32];     // Recording being replayed
+    float speed;       // Multiple of real time
+    uint32_t position; // Time of the last sample sent, in ms since the start
+    uint32_t sent;     // Samples sent so far
+
+    /**
+     * @brief Convert this status to a JSON.
+     *
+     * @return A new JsonDocument with the status.
+     */
+    StaticJsonDocument<128> to_json() const;
+};
+
+/**
+ * @brief Set up recording replays.
+ *
+ * @return bool If the setup was successful.
+ */
+bool replay_setup();
+
+/**
+ * @brief Start replaying a recording as live data.
+ *
+ * Samples go out as "mpuData" events, the same as live samples, paced to match
+ * the recording at `speed` times real time. The recording is read a block at
+ * a time on the replay task. Live samples aren't streamed while replaying.
+ *
+ * Stops any replay already in progress, so calling it again with a different
+ * `from` scrubs through the recording. Sends a "replay" event when the replay
+ * starts and stops.
+ *
+ * @param name The recording to replay.
+ * @param speed Multiple of real time, 1 to REPLAY_MAX_SPEED.
+ * @param from Where to start, in ms since the start of the recording.
+ * @return If the replay was started.
+ */
+bool replay_start(const char* name, float speed, uint32_t from = 0);
+
+/**
+ * @brief Stop the current replay, if any.
+ */
+void replay_stop();
+
+/**
+ * @brief Check if a replay is in progress.
+ */
+bool replay_running();
+
+/**
+ * @brief Get the status of the current (or last) replay.
+ *
+ * @param status Container to save the status to.
+ */
+void replay_status(replay_status_t* status);
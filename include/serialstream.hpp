@@ -0,0 +1,119 @@
+/**
+ * @file serialstream.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Binary sample streaming over the serial port.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * For tethered captures, samples can go straight out the serial port instead
+ * of over WiFi. The 'B' serial command switches the port to SERIALSTREAM_BAUD
+ * and silences every log. From then on, the port only carries frames:
+ *
+ * - Each frame is a serialstream_hello_t or serialstream_sample_t, COBS-encoded
+ *   (see cobs.hpp) and followed by a zero byte.
+ * - Every frame ends with the CRC-32 of everything before it.
+ * - Samples are numbered, and dropped ones still use up a number, so the
+ *   reader can tell exactly how many it missed.
+ *
+ * Sending SERIALSTREAM_STOP goes back to the console at the old baud rate.
+ * tools/capture.cpp is the host side.
+ *
+ * The layout doesn't depend on Arduino, so host tools can use it too.
+ */
+
+#define SERIALSTREAM_VERSION 1
+
+// Sent to stop streaming
+#define SERIALSTREAM_STOP 'X'
+
+/**
+ * @brief Kinds of frames.
+ */
+enum SerialStreamFrame : uint8_t {
+    SERIALSTREAM_HELLO = 1,  // Sent once, when streaming starts
+    SERIALSTREAM_SAMPLE = 2, // Sent for every sample
+};
+
+/**
+ * @brief The first frame of a stream.
+ */
+struct __attribute__((packed)) serialstream_hello_t {
+    uint8_t type;         // SERIALSTREAM_HELLO
+    uint8_t version;      // SERIALSTREAM_VERSION
+    uint16_t sample_rate; // Time between samples (in ms)
+    uint32_t baud;        // Baud rate of the stream
+    uint32_t crc;         // CRC-32 of everything before it
+};
+
+/**
+ * @brief A sample frame.
+ */
+struct __attribute__((packed)) serialstream_sample_t {
+    uint8_t type;   // SERIALSTREAM_SAMPLE
+    uint32_t seq;   // Sample number, counting dropped ones
+    uint32_t time;  // When it was sampled (millis())
+    float ypr[3];   // [yaw, pitch, roll]  (radians)
+    float accel[3]; // [a_x, a_y, a_z]     (w/o gravity, m/s^2)
+    float gyro[3];  // [g_x, g_y, g_z]     (°/s)
+    uint32_t crc;   // CRC-32 of everything before it
+};
+
+struct mpu_data_t;
+
+/**
+ * @brief Switch the serial port to binary streaming.
+ *
+ * Silences the logs, changes the baud rate, and sends a hello frame.
+ */
+void serialstream_start();
+
+/**
+ * @brief Switch the serial port back to the console.
+ */
+void serialstream_stop();
+
+/**
+ * @brief Check if the serial port is streaming.
+ *
+ * @return If it is.
+ */
+bool serialstream_active();
+
+/**
+ * @brief Send a sample, if the serial port is streaming.
+ *
+ * Never blocks. If the transmit buffer is too full for the frame, the sample
+ * is dropped instead.
+ *
+ * @param meas The sample.
+ */
+void serialstream_send(const mpu_data_t& meas);
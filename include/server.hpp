@@ -32,6 +32,8 @@
 
 #include <ArduinoJson.h>
 
+struct mpu_data_t;
+
 /**
  * @brief Set up the web server.
  *
@@ -41,10 +43,77 @@
  */
 bool web_server_setup();
 
+/**
+ * @brief How well a live data client is keeping up.
+ */
+struct sse_client_stats_t {
+    uint32_t ip;         // Client IP address
+    uint32_t connected;  // How long the client has been connected (in ms)
+    uint32_t sent;       // Events queued to the client
+    uint32_t dropped;    // Events dropped because the client's queue was full
+    uint16_t queued;     // Events waiting to be sent now
+    uint16_t max_queued; // Most events ever waiting at once
+    uint32_t lag;        // How long since the queue was last empty (in ms)
+
+    /**
+     * @brief Convert these stats to a JSON.
+     *
+     * @return A new JsonDocument with the stats.
+     */
+    StaticJsonDocument<192> to_json() const;
+};
+
 /**
  * @brief Send an event to any clients connected to the event source.
  *
+ * Clients with SSE_MAX_QUEUED events already waiting skip the event, and ones
+ * that stay that way for SSE_EVICT_MS are disconnected.
+ *
  * @param name The event name.
  * @param json The event data, as a JSON document.
+ * @param id The event ID, or 0 for the current time (in ms since boot).
+ */
+void web_server_send_event(
+    const char* name, const JsonDocument& json, uint32_t id = 0
+);
+
+/**
+ * @brief Send a live sample to any clients connected to the event source.
+ *
+ * Sends it as an "mpuData" event, with the sample's time as the ID. While
+ * latency tracing is on, adds the trace (see latency.hpp). Clients whose queue
+ * is full keep the newest sample, and get it as soon as there's room.
+ *
+ * @param meas The sample.
+ * @param dequeued_us When the data task picked it up (in us since boot), or 0
+ * for samples that weren't just measured.
+ */
+void web_server_send_sample(const mpu_data_t& meas, int64_t dequeued_us);
+
+/**
+ * @brief Send an event to any clients connected to the event source.
+ *
+ * @param name The event name.
+ * @param msg The event data.
+ * @param id The event ID, or 0 for the current time (in ms since boot).
+ */
+void web_server_send_event(const char* name, const char* msg, uint32_t id = 0);
+
+/**
+ * @brief Get the stats of the connected live data clients.
+ *
+ * @param stats Container to save the stats to.
+ * @param max_len Most clients to save.
+ * @return Number of clients saved.
+ */
+size_t web_server_sse_clients(sse_client_stats_t* stats, size_t max_len);
+
+/**
+ * @brief Number of live data clients disconnected for falling behind.
+ */
+uint32_t web_server_sse_evicted();
+
+/**
+ * @brief Average number of events waiting to be sent, over all live data clients.
  */
-void web_server_send_event(const char* name, const JsonDocument& json);
+size_t web_server_sse_avg_queued();
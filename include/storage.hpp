@@ -0,0 +1,187 @@
+/**
+ * @file storage.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Recording storage backends.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <FS.h>
+
+#include <functional>
+
+/**
+ * @brief Where a recording is stored.
+ */
+enum StorageBackend {
+    STORAGE_LITTLEFS,  // A file in /recs on LittleFS
+    STORAGE_PARTITION, // An extent of the raw recording partition
+};
+
+/**
+ * @brief A recording on one of the storage backends.
+ *
+ * Mirrors the parts of fs::File used for recordings, so the server and the
+ * recording writer do not need to care which backend a recording lives on.
+ */
+class RecFile {
+    StorageBackend backend_ = STORAGE_LITTLEFS;
+
+    // LittleFS backend
+    File file_;
+
+    // Partition backend
+    int slot_ = -1;         // Index slot of the recording
+    uint32_t start_ = 0;    // Partition offset of the first byte
+    uint32_t size_ = 0;     // Recording length, in bytes
+    uint32_t end_ = 0;      // Partition offset the recording can grow up to
+    uint32_t pos_ = 0;      // Current read/write position
+    bool writable_ = false; // If we are recording to this (both backends)
+    char name_[32] = "";    // Recording name
+
+    friend RecFile storage_open(const char* name);
+    friend RecFile storage_create(const char* name, StorageBackend backend);
+    friend void part_recover(size_t slot);
+
+ public:
+    RecFile() = default;
+
+    size_t write(const uint8_t* buf, size_t len);
+    size_t read(uint8_t* buf, size_t len);
+    bool seek(uint32_t pos);
+    size_t position() const;
+    size_t size() const;
+    int available();
+    void flush();
+    void close();
+
+    /**
+     * @brief The recording name (without any directory).
+     */
+    const char* name() const;
+
+    /**
+     * @brief The backend this recording is stored on.
+     */
+    StorageBackend backend() const { return backend_; }
+
+    explicit operator bool() const;
+};
+
+/**
+ * @brief Callback for listing recordings.
+ *
+ * @param name The recording name.
+ * @param size The recording size, in bytes.
+ */
+using storage_list_cb_t = std::function<void(const char* name, size_t size)>;
+
+/**
+ * @brief Set up the recording storage.
+ *
+ * Assumes LittleFS has already been mounted. Loads the index of the raw
+ * recording partition, if there is one.
+ *
+ * @return bool If the setup was successful.
+ */
+bool storage_setup();
+
+/**
+ * @brief Check if there is a raw recording partition.
+ *
+ * Only the esp32dev-recpart environment's partition table has one.
+ */
+bool storage_has_partition();
+
+/**
+ * @brief Open a recording for reading.
+ *
+ * Searches the raw partition first, then LittleFS.
+ *
+ * @param name The recording name, e.g. "2022-12-31T20:06:38-0600.dat".
+ * @return The recording, which is false-y if it was not found.
+ */
+RecFile storage_open(const char* name);
+
+/**
+ * @brief Create a new recording for writing.
+ *
+ * @param name The recording name.
+ * @param backend Which backend to store the recording on.
+ * @return The recording, which is false-y if it could not be created.
+ */
+RecFile storage_create(const char* name, StorageBackend backend);
+
+/**
+ * @brief List all recordings, on all backends.
+ *
+ * @param cb Called once for every recording.
+ * @return If the listing was successful.
+ */
+bool storage_list(storage_list_cb_t cb);
+
+/**
+ * @brief Check if a recording is still being written to.
+ *
+ * @param name The recording name.
+ * @return If the recording is in progress, and may still change.
+ */
+bool storage_is_recording(const char* name);
+
+/**
+ * @brief Remove a single recording.
+ *
+ * @param name The recording name.
+ * @param freed If given, set to how many bytes of storage were released.
+ * @return If the operation was successful.
+ */
+bool storage_remove(const char* name, size_t* freed = nullptr);
+
+/**
+ * @brief Rename a finished recording.
+ *
+ * On the raw partition, the index can't be rewritten in place, so this adds a
+ * new index entry for the same data and removes the old one. The index is
+ * compacted when it runs out of entries.
+ *
+ * @param name The recording name.
+ * @param new_name Its new name.
+ * @return If the operation was successful.
+ */
+bool storage_rename(const char* name, const char* new_name);
+
+/**
+ * @brief Get the sequence number for a new recording.
+ *
+ * Goes up with every call and survives reboots, so recordings can be ordered by
+ * when they were made.
+ *
+ * @return The sequence number, starting at 1.
+ */
+uint32_t storage_next_seq();
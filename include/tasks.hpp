@@ -0,0 +1,135 @@
+/**
+ * @file tasks.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Task layout and per-task statistics.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * @brief The long-running tasks.
+ *
+ * Reading the MPU gets a core to itself, and everything that waits on the
+ * network or flash runs on the other one, next to the WiFi stack:
+ *
+ * - TASKS_ACQ_CORE: acquire, and the Arduino loop (serial commands, DRD)
+ * - TASKS_IO_CORE: data, storage, the web server, replays, and self-tests
+ *
+ * Samples go from the acquisition task to the data task through a queue of
+ * DATA_QUEUE_LEN, so a slow flash write or network stall delays the stream
+ * instead of the next sample.
+ */
+enum TaskId {
+    TASK_ACQUIRE, // Reads samples from the MPU
+    TASK_DATA,    // Streams or records samples
+    TASK_STORAGE, // Runs storage jobs (see jobs.hpp)
+    TASK_LOOP,    // The Arduino loop
+    TASK_NETWORK, // The web server (asyncTcpSock)
+    TASK_COUNT,
+};
+
+/**
+ * @brief What a task has been up to.
+ */
+struct task_stats_t {
+    const char* name;    // Task name
+    int8_t core;         // Core it's pinned to, -1 for either
+    uint8_t priority;    // FreeRTOS priority
+    float cpu;           // Share of a core spent working, -1 if not measured
+    uint32_t stack_free; // Least free stack space since it started (in bytes)
+    uint32_t runs;       // Work items processed
+    uint32_t alloc_runs; // Work items that allocated (HEAP_CHECK builds only)
+    uint32_t dropped;    // Items that didn't fit in its queue
+    uint16_t queued;     // Items waiting in its queue
+    uint16_t max_queued; // Most items waiting at once
+    uint16_t queue_len;  // Size of its queue, 0 if it doesn't have one
+
+    /**
+     * @brief Convert these stats to a JSON.
+     *
+     * @return A new JsonDocument with the stats.
+     */
+    StaticJsonDocument<256> to_json() const;
+};
+
+/**
+ * @brief Start the acquisition and data tasks.
+ *
+ * Call after the MPU is set up.
+ *
+ * @return bool If both tasks were started.
+ */
+bool tasks_setup();
+
+/**
+ * @brief Add a task to the statistics.
+ *
+ * @param id Which task it is.
+ * @param task The task.
+ * @param queue The queue it reads from, if any.
+ */
+void tasks_register(TaskId id, TaskHandle_t task, QueueHandle_t queue = nullptr);
+
+/**
+ * @brief Queue an item for a task, without waiting.
+ *
+ * Counts the item as dropped if the queue is full. Safe to call from any task.
+ *
+ * @param id The task to send to.
+ * @param item The item, the size the queue was created with.
+ * @return If the item was queued.
+ */
+bool tasks_send(TaskId id, const void* item);
+
+/**
+ * @brief Count a work item a task finished.
+ *
+ * The sampling path shouldn't touch the heap, so the first work item that
+ * allocates logs a warning (see heap_check_allocs()).
+ *
+ * @param id The task.
+ * @param us How long it took (in us).
+ * @param allocs Allocations it made.
+ */
+void tasks_busy(TaskId id, uint32_t us, uint32_t allocs = 0);
+
+/**
+ * @brief Update the CPU shares once every TASKS_WINDOW_MS.
+ */
+void tasks_loop();
+
+/**
+ * @brief Get the stats of every task that exists.
+ *
+ * @param stats Container to save the stats to.
+ * @param max_len Size of the container.
+ * @return The number of tasks.
+ */
+size_t tasks_stats(task_stats_t* stats, size_t max_len);
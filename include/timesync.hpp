@@ -0,0 +1,89 @@
+/**
+ * @file timesync.hpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Mapping device time to epoch time.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <ArduinoJson.h>
+
+#include <cstdint>
+
+/**
+ * @brief How device time (esp_timer_get_time()) maps to epoch time.
+ *
+ * Taken at every NTP sync. Between syncs, the device clock drifts from NTP
+ * time by a few tens of ppm, so the mapping also tracks the drift:
+ *
+ *     epoch = epoch_us + (t - timer_us) * (1 + drift_ppb / 1e9)
+ */
+struct timesync_t {
+    int64_t timer_us;  // Device time of the last sync (in us since boot)
+    int64_t epoch_us;  // Epoch time it maps to (in us)
+    int32_t drift_ppb; // How much slower the device clock runs than NTP time
+    uint32_t syncs;    // Number of syncs so far, changes with every sync
+
+    /**
+     * @brief Map a device time to epoch time.
+     *
+     * @param timer_us The device time (in us since boot).
+     * @return The epoch time (in us).
+     */
+    int64_t to_epoch(int64_t timer_us) const;
+
+    /**
+     * @brief Convert this mapping to a JSON.
+     *
+     * @return A new JsonDocument with the mapping.
+     */
+    StaticJsonDocument<128> to_json() const;
+};
+
+/**
+ * @brief Start following NTP syncs.
+ *
+ * Call before configTime().
+ */
+void timesync_setup();
+
+/**
+ * @brief Get the current mapping from device time to epoch time.
+ *
+ * @param sync Where to save the mapping.
+ * @return bool If the time has been synced yet.
+ */
+bool timesync_get(timesync_t* sync);
+
+/**
+ * @brief Map a device time to epoch time with the current mapping.
+ *
+ * @param timer_us The device time (in us since boot).
+ * @param epoch_us Where to save the epoch time (in us).
+ * @return bool If the time has been synced yet.
+ */
+bool timesync_to_epoch(int64_t timer_us, int64_t* epoch_us);
@@ -21,15 +21,22 @@
 
 #define _UTILS__ISO8601_LEN 26 // 2022-12-31T20:06:38-0600
 
-inline String
-iso8601_str() noexcept
+inline bool
+iso8601_str(char* buf, size_t len, uint32_t timeout_ms = 5000) noexcept
 {
     struct tm tm;
-    if (!getLocalTime(&tm))
-        return "";
+    if (!getLocalTime(&tm, timeout_ms))
+        return false;
+
+    return strftime(buf, len, "%FT%T%z", &tm) > 0;
+}
 
+inline String
+iso8601_str() noexcept
+{
     char buf[_UTILS__ISO8601_LEN];
-    strftime(buf, _UTILS__ISO8601_LEN, "%FT%T%z", &tm);
+    if (!iso8601_str(buf, _UTILS__ISO8601_LEN))
+        return "";
 
     return buf;
 }
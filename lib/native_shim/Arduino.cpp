@@ -0,0 +1,188 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include <chrono>
+#include <thread>
+
+void
+native_log(int level, const char* func, const char* fmt, ...)
+{
+    if (level > CORE_DEBUG_LEVEL)
+        return;
+
+    static const char levels[] = " EWIDV";
+    fprintf(stderr, "[%6lu][%c] %s(): ", millis(), levels[level], func);
+
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+/******************************************************************************/
+
+unsigned long
+millis()
+{
+    return esp_timer_get_time() / 1000;
+}
+
+unsigned long
+micros()
+{
+    return esp_timer_get_time();
+}
+
+void
+delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+bool
+getLocalTime(struct tm* info, uint32_t)
+{
+    time_t now = time(nullptr);
+    return localtime_r(&now, info) != nullptr;
+}
+
+/******************************************************************************/
+
+// Semaphores are never deleted, like the firmware's
+SemaphoreHandle_t
+xSemaphoreCreateMutex()
+{
+    return new std::recursive_mutex;
+}
+
+SemaphoreHandle_t
+xSemaphoreCreateRecursiveMutex()
+{
+    return new std::recursive_mutex;
+}
+
+BaseType_t
+xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    auto* mutex = static_cast<std::recursive_mutex*>(sem);
+    if (ticks == portMAX_DELAY) {
+        mutex->lock();
+        return pdTRUE;
+    }
+    return mutex->try_lock() ? pdTRUE : pdFALSE;
+}
+
+BaseType_t
+xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    static_cast<std::recursive_mutex*>(sem)->unlock();
+    return pdTRUE;
+}
+
+BaseType_t
+xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    return xSemaphoreTake(sem, ticks);
+}
+
+BaseType_t
+xSemaphoreGiveRecursive(SemaphoreHandle_t sem)
+{
+    return xSemaphoreGive(sem);
+}
+
+/******************************************************************************/
+
+int
+String::indexOf(char c, unsigned int from) const
+{
+    size_t pos = str_.find(c, from);
+    return pos == std::string::npos ? -1 : pos;
+}
+
+int
+String::indexOf(const String& str, unsigned int from) const
+{
+    size_t pos = str_.find(str.str_, from);
+    return pos == std::string::npos ? -1 : pos;
+}
+
+int
+String::lastIndexOf(char c) const
+{
+    size_t pos = str_.rfind(c);
+    return pos == std::string::npos ? -1 : pos;
+}
+
+String
+String::substring(unsigned int from) const
+{
+    return from < str_.size() ? String(str_.substr(from)) : String();
+}
+
+String
+String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to)
+        std::swap(from, to);
+    return from < str_.size() ? String(str_.substr(from, to - from)) : String();
+}
+
+bool
+String::startsWith(const String& prefix) const
+{
+    return str_.compare(0, prefix.str_.size(), prefix.str_) == 0;
+}
+
+bool
+String::endsWith(const String& suffix) const
+{
+    return str_.size() >= suffix.str_.size()
+           && str_.compare(str_.size() - suffix.str_.size(), suffix.str_.size(), suffix.str_)
+                  == 0;
+}
+
+/******************************************************************************/
+
+size_t
+Print::write(const uint8_t* buf, size_t len)
+{
+    size_t n = 0;
+    while (n < len && write(buf[n]))
+        n++;
+    return n;
+}
+
+size_t
+Print::println(const char* str)
+{
+    return print(str) + print("\r\n");
+}
+
+size_t
+Print::printf(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(nullptr, 0, fmt, args);
+    va_end(args);
+    if (len < 0)
+        return 0;
+
+    std::string buf(len + 1, '\0');
+    va_start(args, fmt);
+    vsnprintf(&buf[0], buf.size(), fmt, args);
+    va_end(args);
+    return write((const uint8_t*)buf.data(), len);
+}
+
+String
+Stream::readString()
+{
+    std::string str;
+    int c;
+    while ((c = read()) >= 0)
+        str += (char)c;
+    return String(str);
+}
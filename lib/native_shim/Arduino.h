@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+/*
+ * Host stand-in for the parts of the ESP32 Arduino core that the portable
+ * modules (recording, storage, export, ...) use, so they build and run in the
+ * native environment. Only what those modules need is here, and it behaves like
+ * the real thing as far as they can tell.
+ *
+ * ARDUINO stays undefined, so libraries like ArduinoJson build their host
+ * versions.
+ */
+
+using std::max;
+using std::min;
+
+#define IRAM_ATTR
+
+#ifndef PI
+#  define PI 3.1415926535897932384626433832795
+#endif
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+
+/******************************************************************************/
+
+/*
+ * Logging, like esp32-hal-log.h. Everything up to CORE_DEBUG_LEVEL goes to
+ * stderr.
+ */
+
+#ifndef CORE_DEBUG_LEVEL
+#  define CORE_DEBUG_LEVEL 2 // Errors and warnings
+#endif
+
+// No format checking: the firmware's formats assume a 32-bit long
+void native_log(int level, const char* func, const char* fmt, ...);
+
+#define log_e(fmt, ...) native_log(1, __func__, fmt, ##__VA_ARGS__)
+#define log_w(fmt, ...) native_log(2, __func__, fmt, ##__VA_ARGS__)
+#define log_i(fmt, ...) native_log(3, __func__, fmt, ##__VA_ARGS__)
+#define log_d(fmt, ...) native_log(4, __func__, fmt, ##__VA_ARGS__)
+#define log_v(fmt, ...) native_log(5, __func__, fmt, ##__VA_ARGS__)
+
+/******************************************************************************/
+
+// Newer glibc has it, as do macOS and newlib
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+inline size_t
+strlcpy(char* dst, const char* src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+/******************************************************************************/
+
+/*
+ * Time, from the host's monotonic clock. Starts at 0 like the ESP32's.
+ */
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+
+bool getLocalTime(struct tm* info, uint32_t ms = 5000);
+
+/******************************************************************************/
+
+/*
+ * FreeRTOS, as far as locking goes. Tasks are host threads.
+ */
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void* SemaphoreHandle_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+
+#define portMAX_DELAY        0xFFFFFFFF
+#define portTICK_PERIOD_MS   1
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(ms))
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem);
+
+// Critical sections nest on the same core, like a recursive mutex
+typedef std::recursive_mutex portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux)      (mux)->lock()
+#define portEXIT_CRITICAL(mux)       (mux)->unlock()
+
+/******************************************************************************/
+
+/*
+ * Strings, like WString.h.
+ */
+
+class String {
+    std::string str_;
+
+ public:
+    String() = default;
+    String(const char* str) : str_(str ? str : "") {}
+    String(const std::string& str) : str_(str) {}
+    explicit String(char c) : str_(1, c) {}
+    explicit String(int val) : str_(std::to_string(val)) {}
+    explicit String(unsigned int val) : str_(std::to_string(val)) {}
+    explicit String(long val) : str_(std::to_string(val)) {}
+    explicit String(unsigned long val) : str_(std::to_string(val)) {}
+
+    const char* c_str() const { return str_.c_str(); }
+    unsigned int length() const { return str_.size(); }
+    bool isEmpty() const { return str_.empty(); }
+    bool reserve(unsigned int size)
+    {
+        str_.reserve(size);
+        return true;
+    }
+
+    char operator[](unsigned int i) const { return i < str_.size() ? str_[i] : 0; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& str, unsigned int from = 0) const;
+    int lastIndexOf(char c) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    bool startsWith(const String& prefix) const;
+    bool endsWith(const String& suffix) const;
+    long toInt() const { return strtol(str_.c_str(), nullptr, 10); }
+
+    String& operator+=(const String& rhs)
+    {
+        str_ += rhs.str_;
+        return *this;
+    }
+    String& operator+=(const char* rhs)
+    {
+        str_ += rhs;
+        return *this;
+    }
+    String& operator+=(char rhs)
+    {
+        str_ += rhs;
+        return *this;
+    }
+
+    friend String operator+(const String& lhs, const String& rhs)
+    {
+        return String(lhs.str_ + rhs.str_);
+    }
+    friend String operator+(const String& lhs, const char* rhs)
+    {
+        return String(lhs.str_ + rhs);
+    }
+    friend String operator+(const char* lhs, const String& rhs)
+    {
+        return String(lhs + rhs.str_);
+    }
+
+    bool operator==(const String& rhs) const { return str_ == rhs.str_; }
+    bool operator==(const char* rhs) const { return str_ == rhs; }
+    bool operator!=(const String& rhs) const { return str_ != rhs.str_; }
+    bool operator!=(const char* rhs) const { return str_ != rhs; }
+    bool operator<(const String& rhs) const { return str_ < rhs.str_; }
+};
+
+/******************************************************************************/
+
+/*
+ * Output streams, like Print.h and Stream.h.
+ */
+
+class Print {
+ public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t len);
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str) { return write(str.c_str()); }
+    size_t println(const char* str = "");
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+ public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    String readString();
+};
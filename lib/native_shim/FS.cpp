@@ -0,0 +1,336 @@
+#include <FS.h>
+#include <LittleFS.h>
+
+#include "native_shim.h"
+
+#include <algorithm>
+
+// LittleFS works in blocks, and every directory takes a pair of them
+#define BLOCK_SIZE 4096
+
+namespace fs {
+
+struct FSImpl {
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> files;
+    std::set<std::string> dirs = {"/"};
+};
+
+struct FileImpl {
+    std::shared_ptr<FSImpl> fs;
+    std::string path;
+    std::shared_ptr<std::vector<uint8_t>> data; // nullptr for directories
+    size_t pos = 0;
+    bool readable = true;
+    bool writable = false;
+    bool append = false;
+
+    // Directory listing, taken on the first openNextFile()
+    std::vector<std::string> children;
+    size_t next_child = 0;
+    bool listed = false;
+};
+
+/**
+ * @brief Make a path absolute, without a trailing slash.
+ */
+static std::string
+normalize(const char* path)
+{
+    std::string res = path && path[0] == '/' ? path : std::string("/") + (path ? path : "");
+    while (res.size() > 1 && res.back() == '/')
+        res.pop_back();
+    return res;
+}
+
+static std::string
+parent_of(const std::string& path)
+{
+    size_t slash = path.rfind('/');
+    return slash ? path.substr(0, slash) : "/";
+}
+
+static void
+make_dirs(FSImpl& fs, const std::string& path)
+{
+    for (std::string dir = path; dir != "/"; dir = parent_of(dir))
+        fs.dirs.insert(dir);
+}
+
+static File
+open_path(
+    const std::shared_ptr<FSImpl>& fs, const std::string& path, const char* mode,
+    bool create
+)
+{
+    auto file = std::make_shared<FileImpl>();
+    file->fs = fs;
+    file->path = path;
+
+    if (fs->dirs.count(path))
+        return File(file);
+
+    bool plus = strchr(mode, '+') != nullptr;
+    auto existing = fs->files.find(path);
+
+    if (mode[0] == 'r') {
+        if (existing == fs->files.end()) {
+            log_v("%s does not exist", path.c_str());
+            return File();
+        }
+        file->data = existing->second;
+        file->writable = plus;
+        return File(file);
+    }
+
+    // Writing or appending
+    std::string parent = parent_of(path);
+    if (!fs->dirs.count(parent)) {
+        if (!create) {
+            log_e("%s has no parent directory", path.c_str());
+            return File();
+        }
+        make_dirs(*fs, parent);
+    }
+
+    if (existing == fs->files.end() || mode[0] == 'w')
+        fs->files[path] = std::make_shared<std::vector<uint8_t>>();
+    file->data = fs->files[path];
+    file->readable = plus;
+    file->writable = true;
+    file->append = mode[0] == 'a';
+    return File(file);
+}
+
+/******************************************************************************/
+
+size_t
+File::write(const uint8_t* buf, size_t len)
+{
+    if (!impl_ || !impl_->data || !impl_->writable)
+        return 0;
+
+    auto& data = *impl_->data;
+    if (impl_->append)
+        impl_->pos = data.size();
+    if (impl_->pos + len > data.size())
+        data.resize(impl_->pos + len);
+
+    memcpy(data.data() + impl_->pos, buf, len);
+    impl_->pos += len;
+    return len;
+}
+
+int
+File::available()
+{
+    if (!impl_ || !impl_->data || !impl_->readable)
+        return 0;
+    return impl_->data->size() - std::min(impl_->pos, impl_->data->size());
+}
+
+int
+File::read()
+{
+    uint8_t c;
+    return read(&c, 1) ? c : -1;
+}
+
+int
+File::peek()
+{
+    return available() ? (*impl_->data)[impl_->pos] : -1;
+}
+
+size_t
+File::read(uint8_t* buf, size_t len)
+{
+    len = std::min<size_t>(len, available());
+    if (len) {
+        memcpy(buf, impl_->data->data() + impl_->pos, len);
+        impl_->pos += len;
+    }
+    return len;
+}
+
+bool
+File::seek(uint32_t pos, SeekMode mode)
+{
+    if (!impl_ || !impl_->data)
+        return false;
+
+    size_t base = mode == SeekSet ? 0 : mode == SeekCur ? impl_->pos : size();
+    if (base + pos > size())
+        return false;
+
+    impl_->pos = base + pos;
+    return true;
+}
+
+size_t
+File::position() const
+{
+    return impl_ ? impl_->pos : 0;
+}
+
+size_t
+File::size() const
+{
+    return impl_ && impl_->data ? impl_->data->size() : 0;
+}
+
+const char*
+File::path() const
+{
+    return impl_ ? impl_->path.c_str() : nullptr;
+}
+
+const char*
+File::name() const
+{
+    if (!impl_)
+        return nullptr;
+    return impl_->path.c_str() + impl_->path.rfind('/') + 1;
+}
+
+bool
+File::isDirectory() const
+{
+    return impl_ && !impl_->data;
+}
+
+File
+File::openNextFile(const char* mode)
+{
+    if (!isDirectory())
+        return File();
+
+    auto& fs = *impl_->fs;
+    if (!impl_->listed) {
+        auto add = [&](const std::string& path) {
+            if (path != impl_->path && parent_of(path) == impl_->path)
+                impl_->children.push_back(path);
+        };
+        for (const auto& file : fs.files)
+            add(file.first);
+        for (const auto& dir : fs.dirs)
+            add(dir);
+        std::sort(impl_->children.begin(), impl_->children.end());
+        impl_->listed = true;
+    }
+
+    // Skip anything removed since the listing
+    while (impl_->next_child < impl_->children.size()) {
+        const auto& path = impl_->children[impl_->next_child++];
+        if (fs.files.count(path) || fs.dirs.count(path))
+            return open_path(impl_->fs, path, mode, false);
+    }
+    return File();
+}
+
+void
+File::rewindDirectory()
+{
+    if (impl_) {
+        impl_->children.clear();
+        impl_->next_child = 0;
+        impl_->listed = false;
+    }
+}
+
+/******************************************************************************/
+
+FS::FS() : impl_(std::make_shared<FSImpl>()) {}
+
+File
+FS::open(const char* path, const char* mode, bool create)
+{
+    return open_path(impl_, normalize(path), mode, create);
+}
+
+bool
+FS::exists(const char* path)
+{
+    std::string p = normalize(path);
+    return impl_->files.count(p) || impl_->dirs.count(p);
+}
+
+bool
+FS::remove(const char* path)
+{
+    return impl_->files.erase(normalize(path)) > 0;
+}
+
+bool
+FS::rename(const char* from, const char* to)
+{
+    std::string src = normalize(from), dst = normalize(to);
+    auto file = impl_->files.find(src);
+    if (file == impl_->files.end() || !impl_->dirs.count(parent_of(dst)))
+        return false;
+
+    auto data = file->second;
+    impl_->files.erase(file);
+    impl_->files[dst] = data;
+    return true;
+}
+
+bool
+FS::mkdir(const char* path)
+{
+    std::string p = normalize(path);
+    if (impl_->files.count(p))
+        return false;
+
+    // Parents too, so files can be created anywhere
+    make_dirs(*impl_, p);
+    return true;
+}
+
+bool
+FS::rmdir(const char* path)
+{
+    std::string p = normalize(path);
+    if (p == "/" || !impl_->dirs.count(p))
+        return false;
+
+    for (const auto& file : impl_->files) {
+        if (parent_of(file.first) == p)
+            return false;
+    }
+    for (const auto& dir : impl_->dirs) {
+        if (dir != p && parent_of(dir) == p)
+            return false;
+    }
+    impl_->dirs.erase(p);
+    return true;
+}
+
+void
+FS::clear()
+{
+    impl_->files.clear();
+    impl_->dirs = {"/"};
+}
+
+size_t
+FS::usedBytes()
+{
+    size_t used = impl_->dirs.size() * 2 * BLOCK_SIZE;
+    for (const auto& file : impl_->files) {
+        size_t blocks = (file.second->size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        used += std::max<size_t>(blocks, 1) * BLOCK_SIZE;
+    }
+    return used;
+}
+
+} // namespace fs
+
+LittleFSFS LittleFS;
+
+void
+native_shim_reset(bool partition)
+{
+    LittleFS.format();
+    native_shim_reset_flash(partition);
+    native_shim_reset_nvs();
+}
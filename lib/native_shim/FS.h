@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+/*
+ * Host stand-in for the ESP32 Arduino core's FS.h: files live in memory, so
+ * every test starts from an empty file system (see native_shim_reset()).
+ */
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet,
+    SeekCur,
+    SeekEnd,
+};
+
+struct FileImpl;
+struct FSImpl;
+
+class File : public Stream {
+    std::shared_ptr<FileImpl> impl_;
+
+ public:
+    File() = default;
+    explicit File(std::shared_ptr<FileImpl> impl) : impl_(std::move(impl)) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t len) override;
+    using Print::write;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buf, size_t len);
+
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void flush() override {}
+    void close() { impl_.reset(); }
+
+    const char* path() const;
+    const char* name() const;
+
+    bool isDirectory() const;
+    File openNextFile(const char* mode = "r");
+    void rewindDirectory();
+
+    operator bool() const { return impl_ != nullptr; }
+};
+
+class FS {
+ protected:
+    std::shared_ptr<FSImpl> impl_;
+
+ public:
+    FS();
+
+    File open(const char* path, const char* mode = "r", bool create = false);
+    File open(const String& path, const char* mode = "r", bool create = false)
+    {
+        return open(path.c_str(), mode, create);
+    }
+
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to)
+    {
+        return rename(from.c_str(), to.c_str());
+    }
+
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+
+    bool rmdir(const char* path);
+    bool rmdir(const String& path) { return rmdir(path.c_str()); }
+
+    /**
+     * @brief Delete everything.
+     */
+    void clear();
+
+    /**
+     * @brief Bytes taken by the files, in whole blocks.
+     */
+    size_t usedBytes();
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekMode;
+using fs::SeekSet;
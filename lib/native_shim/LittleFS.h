@@ -0,0 +1,26 @@
+#pragma once
+
+#include <FS.h>
+
+/*
+ * Host stand-in for the ESP32 Arduino core's LittleFS, on the in-memory file
+ * system (see FS.h).
+ */
+
+class LittleFSFS : public fs::FS {
+ public:
+    bool begin(bool = false, const char* = "/littlefs", uint8_t = 10, const char* = "spiffs")
+    {
+        return true;
+    }
+    void end() {}
+    bool format()
+    {
+        clear();
+        return true;
+    }
+
+    size_t totalBytes() { return 1536 * 1024; }
+};
+
+extern LittleFSFS LittleFS;
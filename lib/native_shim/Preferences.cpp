@@ -0,0 +1,102 @@
+#include <Preferences.h>
+
+#include "native_shim.h"
+
+#include <map>
+#include <vector>
+
+// Namespace -> key -> value
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvs;
+
+void
+native_shim_reset_nvs()
+{
+    nvs.clear();
+}
+
+/******************************************************************************/
+
+bool
+Preferences::begin(const char* name, bool read_only, const char*)
+{
+    // NVS namespaces are at most 15 characters
+    if (!name || strlen(name) > 15)
+        return false;
+
+    namespace_ = name;
+    read_only_ = read_only;
+    started_ = true;
+    return true;
+}
+
+bool
+Preferences::clear()
+{
+    if (!started_ || read_only_)
+        return false;
+    nvs[namespace_].clear();
+    return true;
+}
+
+bool
+Preferences::remove(const char* key)
+{
+    if (!started_ || read_only_)
+        return false;
+    return nvs[namespace_].erase(key) > 0;
+}
+
+bool
+Preferences::isKey(const char* key)
+{
+    return started_ && nvs[namespace_].count(key);
+}
+
+size_t
+Preferences::putUInt(const char* key, uint32_t value)
+{
+    return putBytes(key, &value, sizeof(value));
+}
+
+uint32_t
+Preferences::getUInt(const char* key, uint32_t default_value)
+{
+    uint32_t value;
+    if (getBytesLength(key) != sizeof(value))
+        return default_value;
+    getBytes(key, &value, sizeof(value));
+    return value;
+}
+
+size_t
+Preferences::putBytes(const char* key, const void* value, size_t len)
+{
+    if (!started_ || read_only_ || !key || strlen(key) > 15)
+        return 0;
+
+    auto* bytes = static_cast<const uint8_t*>(value);
+    nvs[namespace_][key].assign(bytes, bytes + len);
+    return len;
+}
+
+size_t
+Preferences::getBytesLength(const char* key)
+{
+    if (!started_)
+        return 0;
+
+    auto& values = nvs[namespace_];
+    auto value = values.find(key);
+    return value == values.end() ? 0 : value->second.size();
+}
+
+size_t
+Preferences::getBytes(const char* key, void* buf, size_t max_len)
+{
+    size_t len = getBytesLength(key);
+    if (!len || len > max_len)
+        return 0;
+
+    memcpy(buf, nvs[namespace_][key].data(), len);
+    return len;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+
+/*
+ * Host stand-in for the ESP32 Arduino core's Preferences. Every namespace lives
+ * in memory until native_shim_reset(), so values survive across instances like
+ * they do in NVS.
+ */
+
+class Preferences {
+    std::string namespace_;
+    bool started_ = false;
+    bool read_only_ = false;
+
+ public:
+    bool begin(const char* name, bool read_only = false, const char* = nullptr);
+    void end() { started_ = false; }
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putUInt(const char* key, uint32_t value);
+    uint32_t getUInt(const char* key, uint32_t default_value = 0);
+
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t max_len);
+};
@@ -0,0 +1,40 @@
+#include <esp_sntp.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
+#include "native_shim.h"
+
+#include <chrono>
+#include <random>
+
+static const auto boot = std::chrono::steady_clock::now();
+static sntp_sync_time_cb_t sync_cb = nullptr;
+
+uint32_t
+esp_random()
+{
+    static std::random_device device;
+    return device();
+}
+
+int64_t
+esp_timer_get_time()
+{
+    auto elapsed = std::chrono::steady_clock::now() - boot;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+void
+sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback)
+{
+    sync_cb = callback;
+}
+
+void
+native_shim_time_sync()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    if (sync_cb)
+        sync_cb(&tv);
+}
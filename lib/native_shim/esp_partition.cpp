@@ -0,0 +1,80 @@
+#include <esp_partition.h>
+
+#include "native_shim.h"
+
+#include <cstring>
+#include <vector>
+
+static const esp_partition_t recs = {
+    ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, 0x340000, 0xC0000, "recs",
+    false,
+};
+
+static std::vector<uint8_t> flash(recs.size, 0xFF);
+static bool has_partition = true;
+
+void
+native_shim_reset_flash(bool partition)
+{
+    std::fill(flash.begin(), flash.end(), 0xFF);
+    has_partition = partition;
+}
+
+/******************************************************************************/
+
+const esp_partition_t*
+esp_partition_find_first(
+    esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label
+)
+{
+    if (!has_partition || type != recs.type)
+        return nullptr;
+    if (subtype != ESP_PARTITION_SUBTYPE_ANY && subtype != recs.subtype)
+        return nullptr;
+    if (label && strcmp(label, recs.label) != 0)
+        return nullptr;
+    return &recs;
+}
+
+esp_err_t
+esp_partition_read(const esp_partition_t* part, size_t offset, void* dst, size_t size)
+{
+    if (part != &recs || !dst)
+        return ESP_ERR_INVALID_ARG;
+    if (offset > part->size || size > part->size - offset)
+        return ESP_ERR_INVALID_SIZE;
+
+    memcpy(dst, flash.data() + offset, size);
+    return ESP_OK;
+}
+
+esp_err_t
+esp_partition_write(
+    const esp_partition_t* part, size_t offset, const void* src, size_t size
+)
+{
+    if (part != &recs || !src)
+        return ESP_ERR_INVALID_ARG;
+    if (offset > part->size || size > part->size - offset)
+        return ESP_ERR_INVALID_SIZE;
+
+    // Programming only clears bits
+    auto* bytes = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < size; i++)
+        flash[offset + i] &= bytes[i];
+    return ESP_OK;
+}
+
+esp_err_t
+esp_partition_erase_range(const esp_partition_t* part, size_t offset, size_t size)
+{
+    if (part != &recs)
+        return ESP_ERR_INVALID_ARG;
+    if (offset % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE)
+        return ESP_ERR_INVALID_ARG;
+    if (offset > part->size || size > part->size - offset)
+        return ESP_ERR_INVALID_SIZE;
+
+    memset(flash.data() + offset, 0xFF, size);
+    return ESP_OK;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <sys/time.h>
+
+/*
+ * Host stand-in for ESP-IDF's esp_sntp.h. There's no SNTP client, tests call
+ * native_shim_time_sync() instead.
+ */
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
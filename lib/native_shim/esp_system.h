@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Host stand-in for ESP-IDF's esp_system.h.
+ */
+
+/**
+ * @brief Random numbers, from the host's random device.
+ */
+uint32_t esp_random();
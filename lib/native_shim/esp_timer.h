@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Host stand-in for ESP-IDF's esp_timer.h.
+ */
+
+/**
+ * @brief us since boot, from the same clock as micros().
+ */
+int64_t esp_timer_get_time();
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Host stand-in for the vector types of I2Cdevlib's helper_3dmath.h, which
+ * only builds for Arduino. Just the parts the portable modules use.
+ */
+
+class Quaternion {
+ public:
+    float w = 1, x = 0, y = 0, z = 0;
+
+    Quaternion() = default;
+    Quaternion(float nw, float nx, float ny, float nz) : w(nw), x(nx), y(ny), z(nz) {}
+};
+
+class VectorInt16 {
+ public:
+    int16_t x = 0, y = 0, z = 0;
+
+    VectorInt16() = default;
+    VectorInt16(int16_t nx, int16_t ny, int16_t nz) : x(nx), y(ny), z(nz) {}
+};
+
+class VectorFloat {
+ public:
+    float x = 0, y = 0, z = 0;
+
+    VectorFloat() = default;
+    VectorFloat(float nx, float ny, float nz) : x(nx), y(ny), z(nz) {}
+};
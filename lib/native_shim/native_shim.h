@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+ * Controls for the host stand-ins, for tests and host tools.
+ */
+
+/**
+ * @brief Start from a blank device: erased flash, empty LittleFS and NVS.
+ *
+ * Call storage_setup() again afterwards.
+ *
+ * @param partition If there is a "recs" partition, or only LittleFS.
+ */
+void native_shim_reset(bool partition = true);
+
+/**
+ * @brief Act like SNTP just set the clock, to the host's time.
+ */
+void native_shim_time_sync();
+
+// Parts of native_shim_reset()
+void native_shim_reset_flash(bool partition);
+void native_shim_reset_nvs();
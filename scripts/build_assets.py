@@ -0,0 +1,119 @@
+"""Prepare the web dashboard in data/ for the filesystem image.
+
+Gzips every asset that isn't already compressed, then writes data/assets.json,
+a manifest the web server loads at boot. For every asset, it lists:
+
+- path: the URL it's served at
+- file: where it is on LittleFS
+- type: its MIME type
+- etag: a strong ETag, from the SHA-256 of the stored bytes
+- gzip: if the stored file is gzipped
+- immutable: if the name has a content hash in it (e.g. index-4f1a2b3c.js)
+
+Run it after copying a dashboard build to data/ (the `web` task does), or let
+scripts/pre_build.py run it before building the filesystem image.
+"""
+
+import gzip
+import hashlib
+import json
+import mimetypes
+import os
+import re
+import sys
+
+MANIFEST = "assets.json"
+
+# Vite names bundled files "<name>-<hash>.<ext>"
+HASHED = re.compile(r"-[A-Za-z0-9_-]{8}\.[a-z0-9]+$")
+
+# Already compressed, gzip would only make them bigger
+NO_GZIP = {".png", ".jpg", ".jpeg", ".gif", ".webp", ".ico", ".woff", ".woff2"}
+
+# MIME types mimetypes doesn't know everywhere
+TYPES = {
+    ".js": "application/javascript",
+    ".mjs": "application/javascript",
+    ".css": "text/css",
+    ".html": "text/html",
+    ".svg": "image/svg+xml",
+    ".json": "application/json",
+    ".webmanifest": "application/manifest+json",
+    ".ico": "image/x-icon",
+    ".txt": "text/plain",
+}
+
+
+def mime_type(path):
+    ext = os.path.splitext(path)[1].lower()
+    if ext in TYPES:
+        return TYPES[ext]
+    return mimetypes.guess_type(path)[0] or "application/octet-stream"
+
+
+def compress(path):
+    """Gzip a file in place, deterministically, and return the new path."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    out = path + ".gz"
+    with open(out, "wb") as f:
+        # No name or mtime in the header, so rebuilds are byte-identical
+        with gzip.GzipFile(fileobj=f, mode="wb", compresslevel=9, filename="", mtime=0) as gz:
+            gz.write(data)
+
+    os.remove(path)
+    return out
+
+
+def build(data_dir):
+    """Compress the assets in data_dir and write the manifest.
+
+    Returns the manifest entries.
+    """
+    assets = []
+
+    for root, _, files in os.walk(data_dir):
+        for name in sorted(files):
+            file = os.path.join(root, name)
+            rel = "/" + os.path.relpath(file, data_dir).replace(os.sep, "/")
+            if rel == "/" + MANIFEST or name.startswith("."):
+                continue
+
+            is_gzip = rel.endswith(".gz")
+            path = rel[:-3] if is_gzip else rel
+            if not is_gzip and os.path.splitext(path)[1].lower() not in NO_GZIP:
+                file = compress(file)
+                is_gzip = True
+
+            with open(file, "rb") as f:
+                digest = hashlib.sha256(f.read()).hexdigest()
+
+            assets.append(
+                {
+                    "path": path,
+                    "file": path + ".gz" if is_gzip else path,
+                    "type": mime_type(path),
+                    "etag": '"' + digest[:16] + '"',
+                    "gzip": is_gzip,
+                    "immutable": bool(HASHED.search(path)),
+                }
+            )
+
+    assets.sort(key=lambda asset: asset["path"])
+    with open(os.path.join(data_dir, MANIFEST), "w") as f:
+        json.dump({"assets": assets}, f, separators=(",", ":"))
+
+    return assets
+
+
+if __name__ == "__main__":
+    data_dir = sys.argv[1] if len(sys.argv) > 1 else "data"
+    for asset in build(data_dir):
+        print(
+            "{path:40} {etag} {flags}".format(
+                flags=("immutable " if asset["immutable"] else "")
+                + ("gzip" if asset["gzip"] else ""),
+                **asset
+            )
+        )
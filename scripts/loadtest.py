@@ -0,0 +1,313 @@
+"""Load-test a tracker's live stream and downloads as subscribers pile up.
+
+For each client count in --clients, opens that many /events subscribers plus
+--downloads back-to-back /recordings/<name> downloads, runs for --seconds, and
+prints a row of the scaling curve:
+
+- ev/s: mpuData events per second, per subscriber
+- miss: events missing from each subscriber's stream, from the gaps in the
+  sample times
+- p50/p95/p99/max: latency on top of the fastest event each subscriber saw. The
+  host and device clocks aren't synced, so this is the queueing delay, not the
+  absolute latency.
+- dl MB/s: total download throughput, and how many downloads finished, were
+  turned away (503), or failed
+- dropped/evicted: what the device reports in /events/clients
+
+    python scripts/loadtest.py swim-stats.local --clients 1,2,4,8 --downloads 2
+
+--standin runs the same test against a small local server that streams and
+serves downloads the same way, to check the tool and the host, not the tracker.
+"""
+
+import argparse
+import http.client
+import http.server
+import json
+import socket
+import statistics
+import threading
+import time
+
+CHUNK = 16 * 1024
+
+
+def connect(args, timeout=5):
+    return http.client.HTTPConnection(args.host, args.port, timeout=timeout)
+
+
+def get_json(args, path):
+    conn = connect(args)
+    try:
+        conn.request("GET", path)
+        res = conn.getresponse()
+        body = res.read()
+        return json.loads(body) if res.status == 200 else None
+    except (OSError, ValueError):
+        return None
+    finally:
+        conn.close()
+
+
+def subscribe(args, client, stop):
+    """Collect (device time, host time) of every mpuData event until told to stop."""
+    try:
+        # Short timeout, so we notice when to stop even if events stall
+        conn = connect(args, timeout=1)
+        conn.request("GET", "/events", headers={"Accept": "text/event-stream"})
+        res = conn.getresponse()
+        if res.status != 200:
+            client["error"] = "HTTP %d" % res.status
+            return
+    except OSError as e:
+        client["error"] = str(e)
+        return
+
+    event = None
+    while not stop.is_set():
+        try:
+            line = res.fp.readline()
+        except socket.timeout:
+            continue
+        except OSError as e:
+            client["error"] = str(e)
+            break
+        if not line:
+            client["error"] = "closed by the device"
+            break
+
+        line = line.decode(errors="replace").rstrip("\r\n")
+        if line.startswith("event:"):
+            event = line[6:].strip()
+        elif line.startswith("data:") and event == "mpuData":
+            try:
+                dev_ms = json.loads(line[5:])["time"]
+            except (ValueError, KeyError):
+                continue
+            client["events"].append((dev_ms, time.monotonic() * 1000))
+        elif not line:
+            event = None
+    conn.close()
+
+
+def download(args, dl, stop):
+    """Download the recording over and over until told to stop."""
+    path = "/recordings/%s?format=%s" % (args.recording, args.format)
+    while not stop.is_set():
+        conn = connect(args, timeout=30)
+        try:
+            conn.request("GET", path)
+            res = conn.getresponse()
+            if res.status == 503:
+                res.read()
+                dl["busy"] += 1
+                time.sleep(float(res.getheader("Retry-After", "1")))
+                continue
+            if res.status != 200:
+                res.read()
+                dl["errors"] += 1
+                continue
+
+            while not stop.is_set():
+                chunk = res.read(CHUNK)
+                if not chunk:
+                    dl["done"] += 1
+                    break
+                dl["bytes"] += len(chunk)
+        except OSError:
+            dl["errors"] += 1
+        finally:
+            conn.close()
+
+
+def analyze(clients):
+    """Turn each subscriber's events into rates, misses, and extra latency."""
+    extra = []
+    events = missing = 0
+    secs = []
+
+    for client in clients:
+        evs = client["events"]
+        if len(evs) < 3:
+            continue
+        events += len(evs)
+        secs.append((evs[-1][1] - evs[0][1]) / 1000)
+
+        deltas = [b[0] - a[0] for a, b in zip(evs, evs[1:])]
+        period = statistics.median(deltas) or 1
+        missing += sum(round(d / period) - 1 for d in deltas if d > 1.5 * period)
+
+        # The fastest event is as close to zero latency as we can know
+        base = min(host - dev for dev, host in evs)
+        extra += [host - dev - base for dev, host in evs]
+
+    result = {
+        "rate": events / sum(secs) if secs and sum(secs) else 0,
+        "missing": 100 * missing / (events + missing) if events else 0,
+    }
+    if extra:
+        extra.sort()
+        for name, q in (("p50", 0.5), ("p95", 0.95), ("p99", 0.99)):
+            result[name] = extra[min(int(len(extra) * q), len(extra) - 1)]
+        result["max"] = extra[-1]
+    return result
+
+
+def step(args, n):
+    stop = threading.Event()
+    clients = [{"events": [], "error": None} for _ in range(n)]
+    dl = {"bytes": 0, "done": 0, "busy": 0, "errors": 0}
+
+    threads = [
+        threading.Thread(target=subscribe, args=(args, c, stop), daemon=True)
+        for c in clients
+    ]
+    if args.recording:
+        threads += [
+            threading.Thread(target=download, args=(args, dl, stop), daemon=True)
+            for _ in range(args.downloads)
+        ]
+    for t in threads:
+        t.start()
+
+    time.sleep(args.seconds)
+    device = get_json(args, "/events/clients") or {}
+    stop.set()
+    for t in threads:
+        t.join(5)
+
+    result = analyze(clients)
+    result["dl"] = dl["bytes"] / args.seconds / 1e6
+    result["dl_counts"] = "%d/%d/%d" % (dl["done"], dl["busy"], dl["errors"])
+    result["dropped"] = sum(c.get("dropped", 0) for c in device.get("clients", []))
+    result["evicted"] = device.get("evicted", "-")
+    result["failed"] = sum(1 for c in clients if c["error"])
+    return result
+
+
+def fmt(result, key, spec="%.1f"):
+    return spec % result[key] if key in result else "-"
+
+
+# ================================================================
+# ===                     LOCAL STAND-IN                       ===
+# ================================================================
+
+
+class StandIn(http.server.BaseHTTPRequestHandler):
+    """Streams and serves downloads like the tracker, from the host."""
+
+    protocol_version = "HTTP/1.1"
+    start = time.monotonic()
+    period = 0.05
+    recording = bytes(range(256)) * (2 * 1024 * 1024 // 256)
+
+    def log_message(self, *_):
+        pass
+
+    def send_json(self, doc):
+        body = json.dumps(doc).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        if self.path == "/events":
+            self.send_response(200)
+            self.send_header("Content-Type", "text/event-stream")
+            self.send_header("Cache-Control", "no-cache")
+            self.end_headers()
+            try:
+                while True:
+                    ms = int((time.monotonic() - self.start) * 1000)
+                    data = json.dumps({"ypr": [0, 0, 0], "time": ms})
+                    self.wfile.write(
+                        ("event: mpuData\nid: %d\ndata: %s\n\n" % (ms, data)).encode()
+                    )
+                    self.wfile.flush()
+                    time.sleep(self.period)
+            except OSError:
+                return
+        elif self.path == "/events/clients":
+            self.send_json({"evicted": 0, "clients": []})
+        elif self.path == "/recordings":
+            self.send_json({"files": ["standin.dat"]})
+        elif self.path.startswith("/recordings/"):
+            self.send_response(200)
+            self.send_header("Content-Type", "application/octet-stream")
+            self.send_header("Content-Length", str(len(self.recording)))
+            self.end_headers()
+            try:
+                self.wfile.write(self.recording)
+            except OSError:
+                return
+        else:
+            self.send_error(404)
+
+
+class StandInServer(http.server.ThreadingHTTPServer):
+    daemon_threads = True
+
+    def handle_error(self, *_):
+        # Clients hang up mid-download when a step ends, that's expected
+        pass
+
+
+def start_standin(args):
+    server = StandInServer(("127.0.0.1", 0), StandIn)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    args.host, args.port = server.server_address
+    print("Stand-in listening on %s:%d" % (args.host, args.port))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host", nargs="?", default="swim-stats.local")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument(
+        "--clients", default="1,2,4,8", help="subscriber counts to step through"
+    )
+    parser.add_argument(
+        "--downloads", type=int, default=0, help="concurrent downloads at each step"
+    )
+    parser.add_argument("--recording", help="recording to download (default: first)")
+    parser.add_argument("--format", default="bin", choices=["json", "csv", "bin"])
+    parser.add_argument("--seconds", type=int, default=15, help="length of each step")
+    parser.add_argument("--standin", action="store_true", help="test a local stand-in")
+    args = parser.parse_args()
+
+    if args.standin:
+        start_standin(args)
+
+    if args.downloads and not args.recording:
+        files = (get_json(args, "/recordings") or {}).get("files", [])
+        if not files:
+            print("No recordings to download, skipping downloads")
+        else:
+            args.recording = files[0]
+
+    print(
+        "%7s %7s %6s %7s %7s %7s %7s %8s %10s %8s %8s"
+        % (
+            "clients", "ev/s", "miss%", "p50 ms", "p95 ms", "p99 ms", "max ms",
+            "dl MB/s", "ok/503/err", "dropped", "evicted",
+        )
+    )
+    for n in [int(n) for n in args.clients.split(",")]:
+        r = step(args, n)
+        print(
+            "%7d %7.1f %6.2f %7s %7s %7s %7s %8.3f %10s %8s %8s"
+            % (
+                n, r["rate"], r["missing"], fmt(r, "p50"), fmt(r, "p95"),
+                fmt(r, "p99"), fmt(r, "max"), r["dl"], r["dl_counts"], r["dropped"],
+                r["evicted"],
+            )
+        )
+        if r["failed"]:
+            print("%7s %d of %d subscribers were cut off" % ("", r["failed"], n))
+
+
+if __name__ == "__main__":
+    main()
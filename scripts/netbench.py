@@ -0,0 +1,188 @@
+"""Run the network self-tests against a tracker (see include/netbench.hpp).
+
+Compares what the host measured with what the device reports. If both sides
+see the same slow throughput, the WiFi link is the bottleneck. If the device
+keeps up but the host sees gaps, look at the network. If the device itself
+reports drops or late events, the firmware is the bottleneck.
+
+    python scripts/netbench.py swim-stats.local --mb 8 --rate 200 --seconds 10
+"""
+
+import argparse
+import http.client
+import json
+import statistics
+import threading
+import time
+
+CHUNK = 16 * 1024
+
+
+def connect(args):
+    return http.client.HTTPConnection(args.host, args.port, timeout=30)
+
+
+def download(args):
+    conn = connect(args)
+    start = time.monotonic()
+    conn.request("GET", "/bench/download?mb=%d" % args.mb)
+    res = conn.getresponse()
+    if res.status != 200:
+        raise RuntimeError("download: %d %s" % (res.status, res.read().decode()))
+
+    total = 0
+    while True:
+        chunk = res.read(CHUNK)
+        if not chunk:
+            break
+        total += len(chunk)
+    elapsed = time.monotonic() - start
+    conn.close()
+
+    expected = args.mb * 1024 * 1024
+    if total != expected:
+        print("download: got %d of %d bytes" % (total, expected))
+    return {"bytes": total, "ms": elapsed * 1000}
+
+
+def upload(args):
+    size = args.mb * 1024 * 1024
+    block = bytes(range(256)) * (CHUNK // 256)
+
+    conn = connect(args)
+    start = time.monotonic()
+    conn.putrequest("POST", "/bench/upload")
+    conn.putheader("Content-Type", "application/octet-stream")
+    conn.putheader("Content-Length", str(size))
+    conn.endheaders()
+
+    sent = 0
+    while sent < size:
+        chunk = block[: min(CHUNK, size - sent)]
+        conn.send(chunk)
+        sent += len(chunk)
+
+    res = conn.getresponse()
+    body = res.read()
+    elapsed = time.monotonic() - start
+    conn.close()
+    if res.status != 200:
+        raise RuntimeError("upload: %d %s" % (res.status, body.decode()))
+    return {"bytes": sent, "ms": elapsed * 1000}
+
+
+def listen(args, received, ready, stop):
+    """Collect "bench" events as (seq, arrival time) until told to stop."""
+    conn = connect(args)
+    conn.request("GET", "/events", headers={"Accept": "text/event-stream"})
+    res = conn.getresponse()
+    ready.set()
+
+    event = None
+    while not stop.is_set():
+        line = res.fp.readline()
+        if not line:
+            break
+        line = line.decode(errors="replace").rstrip("\r\n")
+        if line.startswith("event:"):
+            event = line[6:].strip()
+        elif line.startswith("data:") and event == "bench":
+            try:
+                received.append((json.loads(line[5:])["seq"], time.monotonic()))
+            except ValueError:
+                pass
+        elif not line:
+            event = None
+    conn.close()
+
+
+def events(args):
+    received = []
+    ready = threading.Event()
+    stop = threading.Event()
+    listener = threading.Thread(
+        target=listen, args=(args, received, ready, stop), daemon=True
+    )
+    listener.start()
+    ready.wait(10)
+
+    conn = connect(args)
+    conn.request(
+        "POST",
+        "/bench/events?rate=%d&seconds=%d&size=%d"
+        % (args.rate, args.seconds, args.size),
+    )
+    res = conn.getresponse()
+    body = res.read()
+    conn.close()
+    if res.status != 202:
+        raise RuntimeError("events: %d %s" % (res.status, body.decode()))
+
+    # Wait for the run, plus a bit for stragglers
+    time.sleep(args.seconds + 2)
+    stop.set()
+    listener.join(5)
+
+    expected = args.rate * args.seconds
+    seqs = [seq for seq, _ in received]
+    gaps = [b - a for (_, a), (_, b) in zip(received, received[1:])]
+    result = {
+        "events": len(received),
+        "missing": expected - len(set(seqs)),
+        "out_of_order": sum(1 for a, b in zip(seqs, seqs[1:]) if b < a),
+        "bytes": len(received) * args.size,
+    }
+    if received:
+        result["ms"] = (received[-1][1] - received[0][1]) * 1000
+    if len(gaps) > 1:
+        gaps.sort()
+        result["gap_p50_ms"] = statistics.median(gaps) * 1000
+        result["gap_p99_ms"] = gaps[int(len(gaps) * 0.99)] * 1000
+        result["gap_max_ms"] = gaps[-1] * 1000
+    return result
+
+
+def device_results(args):
+    conn = connect(args)
+    conn.request("GET", "/bench")
+    res = conn.getresponse()
+    results = json.loads(res.read())
+    conn.close()
+    return results
+
+
+def rate(result):
+    if not result.get("ms"):
+        return "-"
+    return "%.1f KB/s" % (result["bytes"] / 1.024 / result["ms"])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host", nargs="?", default="swim-stats.local")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--mb", type=int, default=4, help="MB to download/upload")
+    parser.add_argument("--rate", type=int, default=100, help="events per second")
+    parser.add_argument("--seconds", type=int, default=10, help="event test length")
+    parser.add_argument("--size", type=int, default=200, help="bytes per event")
+    parser.add_argument(
+        "--only", choices=["download", "upload", "events"], action="append"
+    )
+    args = parser.parse_args()
+
+    tests = {"download": download, "upload": upload, "events": events}
+    host = {}
+    for name in args.only or tests:
+        print("Running %s..." % name)
+        host[name] = tests[name](args)
+
+    device = device_results(args)
+    for name, result in host.items():
+        dev = device.get(name, {})
+        print("\n%s" % name)
+        print("  host:   %s, %s" % (rate(result), json.dumps(result)))
+        print("  device: %s, %s" % (rate(dev), json.dumps(dev)))
+
+
+if __name__ == "__main__":
+    main()
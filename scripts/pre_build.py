@@ -1,5 +1,20 @@
 import os
+import sys
+
 Import("env")
 
 # include toolchain paths
 env.Replace(COMPILATIONDB_INCLUDE_TOOLCHAIN=True)
+
+# gzip the dashboard and write its asset manifest before building the
+# filesystem image
+sys.path.insert(0, os.path.join(env.subst("$PROJECT_DIR"), "scripts"))
+import build_assets  # noqa: E402
+
+
+def before_buildfs(*args, **kwargs):
+    assets = build_assets.build(env.subst("$PROJECT_DATA_DIR"))
+    print("Wrote manifest for %d dashboard assets" % len(assets))
+
+
+env.AddPreAction("$BUILD_DIR/${ESP32_FS_IMAGE_NAME}.bin", before_buildfs)
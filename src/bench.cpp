@@ -0,0 +1,281 @@
+/**
+ * @file bench.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief On-device benchmarks.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "bench.hpp"
+
+#include "config.h"
+#include "data.hpp"
+#include "export.hpp"
+#include "recording.hpp"
+#include "storage.hpp"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// Amount of sample data to write per storage benchmark
+#define BENCH_STORAGE_BYTES (256 * 1024)
+
+// Name of the scratch recording
+#define BENCH_REC_NAME "bench.dat"
+
+// Length of the recording to export (in ms)
+#define BENCH_EXPORT_LEN (5 * 60 * 1000)
+
+// Size of the chunks to export to, about what AsyncWebServer asks for
+#define BENCH_EXPORT_CHUNK 1436
+
+// Typical WiFi throughput to a phone (in KB/s), for estimating download times
+#define BENCH_LINK_RATE 400
+
+/**
+ * @brief Timing results of a benchmark.
+ */
+struct bench_result_t {
+    uint32_t bytes;    // Bytes processed
+    uint32_t total_us; // Total time taken
+    uint32_t max_us;   // Longest single operation
+};
+
+static void
+bench_log(const char* name, const bench_result_t& res)
+{
+    float mb_per_s = res.total_us ? res.bytes / (float)res.total_us : 0;
+    log_i(
+        "%-24s %7lu B in %7lu us: %6.3f MB/s, worst write %6lu us", name, res.bytes,
+        res.total_us, mb_per_s, res.max_us
+    );
+}
+
+static mpu_data_t
+bench_sample(uint32_t i)
+{
+    mpu_data_t sample;
+    sample.ypr[0] = sample.ypr[1] = sample.ypr[2] = i * 0.001f;
+    sample.accel = VectorFloat(i * 0.01f, -0.5f, 9.81f);
+    sample.gyro = VectorFloat(0.1f, i * 0.02f, -0.1f);
+    sample.time = i * MPU_SAMPLE_RATE;
+    return sample;
+}
+
+static bench_result_t
+bench_file_write()
+{
+    bench_result_t res = {};
+
+    File file = LittleFS.open("/" BENCH_REC_NAME, "w", true);
+    if (!file) {
+        log_e("Could not open benchmark file");
+        return res;
+    }
+
+    uint32_t start = micros();
+    for (uint32_t i = 0; res.bytes < BENCH_STORAGE_BYTES; i++) {
+        mpu_data_t sample = bench_sample(i);
+
+        uint32_t t = micros();
+        file.write(reinterpret_cast<uint8_t*>(&sample), sizeof(sample));
+        res.max_us = max<uint32_t>(res.max_us, micros() - t);
+
+        res.bytes += sizeof(sample);
+    }
+    file.close();
+    res.total_us = micros() - start;
+
+    LittleFS.remove("/" BENCH_REC_NAME);
+    return res;
+}
+
+static bench_result_t
+bench_rec_writer(StorageBackend backend)
+{
+    bench_result_t res = {};
+
+    static RecWriter writer; // Too big for the stack
+    if (!writer.begin(storage_create(BENCH_REC_NAME, backend))) {
+        log_e("Could not create benchmark recording");
+        writer.close();
+        return res;
+    }
+
+    uint32_t start = micros();
+    for (uint32_t i = 0; res.bytes < BENCH_STORAGE_BYTES; i++) {
+        mpu_data_t sample = bench_sample(i);
+
+        uint32_t t = micros();
+        writer.write(sample);
+        res.max_us = max<uint32_t>(res.max_us, micros() - t);
+
+        res.bytes += sizeof(sample);
+    }
+    writer.close();
+    res.total_us = micros() - start;
+
+    storage_remove(BENCH_REC_NAME);
+    return res;
+}
+
+/**
+ * @brief Export the old way: a JSON document per sample, dropped if it doesn't
+ * fit in the chunk.
+ */
+static bench_result_t
+bench_export_documents(uint8_t* buf)
+{
+    bench_result_t res = {};
+
+    static RecReader reader; // Too big for the stack
+    if (!reader.begin(storage_open(BENCH_REC_NAME))) {
+        log_e("Could not open benchmark recording");
+        return res;
+    }
+
+    uint32_t start = micros();
+    mpu_data_t sample;
+    bool more = true;
+    while (more) {
+        uint32_t t = micros();
+        size_t written = 0;
+        while ((more = reader.next(&sample))) {
+            auto doc = sample.to_json();
+            size_t json_size = measureJson(doc) + 1;
+            if (json_size > BENCH_EXPORT_CHUNK - written)
+                break; // The old code lost this sample
+
+            serializeJson(doc, buf + written, json_size);
+            written += json_size;
+        }
+        res.max_us = max<uint32_t>(res.max_us, micros() - t);
+        res.bytes += written;
+    }
+    res.total_us = micros() - start;
+
+    reader.close();
+    return res;
+}
+
+static bench_result_t
+bench_export_exporter(uint8_t* buf, ExportFormat format, bool gzip = false)
+{
+    bench_result_t res = {};
+
+    static RecExporter exporter; // Too big for the stack
+    if (!exporter.begin(storage_open(BENCH_REC_NAME), format)) {
+        log_e("Could not open benchmark recording");
+        return res;
+    }
+    if (gzip && !exporter.compress()) {
+        log_e("Could not compress export");
+        exporter.close();
+        return res;
+    }
+
+    uint32_t start = micros();
+    size_t len;
+    do {
+        uint32_t t = micros();
+        len = exporter.fill(buf, BENCH_EXPORT_CHUNK);
+        res.max_us = max<uint32_t>(res.max_us, micros() - t);
+        res.bytes += len;
+    } while (len);
+    res.total_us = micros() - start;
+
+    exporter.close();
+    return res;
+}
+
+static void
+bench_export_log(const char* name, const bench_result_t& res)
+{
+    float kb_per_s = res.total_us ? res.bytes * 1e6f / 1024 / res.total_us : 0;
+
+    // Generating and sending overlap, so the slower one sets the download time
+    uint32_t air_ms = (uint64_t)res.bytes * 1000 / (BENCH_LINK_RATE * 1024);
+    uint32_t download_ms = max(res.total_us / 1000, air_ms);
+
+    log_i(
+        "%-24s %7lu B in %7lu us: %7.1f KB/s, worst chunk %6lu us, ~%lu ms to "
+        "download",
+        name, res.bytes, res.total_us, kb_per_s, res.max_us, download_ms
+    );
+}
+
+void
+bench_export()
+{
+    uint32_t samples = BENCH_EXPORT_LEN / MPU_SAMPLE_RATE;
+    log_i("Benchmarking exports of a %lu sample recording...", samples);
+
+    static RecWriter writer; // Too big for the stack
+    if (!writer.begin(storage_create(BENCH_REC_NAME, REC_STORAGE_DEFAULT))) {
+        log_e("Could not create benchmark recording");
+        writer.close();
+        return;
+    }
+    for (uint32_t i = 0; i < samples; i++)
+        writer.write(bench_sample(i));
+    writer.close();
+
+    uint8_t* buf = (uint8_t*)malloc(BENCH_EXPORT_CHUNK);
+    if (buf) {
+        bench_export_log("JSON document per sample", bench_export_documents(buf));
+        bench_export_log("RecExporter, JSON", bench_export_exporter(buf, EXPORT_JSON));
+        bench_export_log("RecExporter, CSV", bench_export_exporter(buf, EXPORT_CSV));
+        bench_export_log(
+            "RecExporter, JSON, gzip", bench_export_exporter(buf, EXPORT_JSON, true)
+        );
+        bench_export_log(
+            "RecExporter, CSV, gzip", bench_export_exporter(buf, EXPORT_CSV, true)
+        );
+        bench_export_log(
+            "RecExporter, binary", bench_export_exporter(buf, EXPORT_BINARY)
+        );
+        free(buf);
+    } else {
+        log_e("Could not allocate export buffer");
+    }
+
+    storage_remove(BENCH_REC_NAME);
+    log_i("Export benchmark done");
+}
+
+void
+bench_storage()
+{
+    log_i("Benchmarking recording storage (%u KB each)...", BENCH_STORAGE_BYTES / 1024);
+
+    bench_log("LittleFS, per sample", bench_file_write());
+    bench_log("LittleFS, blocks", bench_rec_writer(STORAGE_LITTLEFS));
+    if (storage_has_partition())
+        bench_log("Raw partition, blocks", bench_rec_writer(STORAGE_PARTITION));
+    else
+        log_i("No recording partition, skipping it");
+
+    log_i("Storage benchmark done");
+}
@@ -0,0 +1,113 @@
+/**
+ * @file boot.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Boot stage timings.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "boot.hpp"
+
+#include "config.h"
+
+/**
+ * @brief A boot stage.
+ */
+struct boot_stage_t {
+    const char* name;
+    uint32_t start_ms; // When it started, since boot
+    uint32_t end_ms;   // When it finished, 0 if it's still running
+    bool ok;           // If it succeeded
+};
+
+/******************************************************************************/
+
+static boot_stage_t stages[BOOT_MAX_STAGES];
+static size_t num_stages = 0;
+
+// Stages start and end on different tasks
+static portMUX_TYPE boot_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/******************************************************************************/
+
+size_t
+boot_stage_begin(const char* name)
+{
+    uint32_t now = millis();
+    size_t stage = BOOT_MAX_STAGES;
+
+    portENTER_CRITICAL(&boot_mux);
+    if (num_stages < BOOT_MAX_STAGES) {
+        stage = num_stages++;
+        stages[stage] = {name, now, 0, false};
+    }
+    portEXIT_CRITICAL(&boot_mux);
+
+    log_i("Boot stage \"%s\" started at %lu ms", name, now);
+    return stage;
+}
+
+void
+boot_stage_end(size_t stage, bool ok)
+{
+    if (stage >= BOOT_MAX_STAGES)
+        return;
+
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&boot_mux);
+    auto& s = stages[stage];
+    s.end_ms = max<uint32_t>(now, 1);
+    s.ok = ok;
+    portEXIT_CRITICAL(&boot_mux);
+
+    log_i(
+        "Boot stage \"%s\" %s in %lu ms", s.name, ok ? "finished" : "failed",
+        now - s.start_ms
+    );
+}
+
+void
+boot_print_report()
+{
+    boot_stage_t copy[BOOT_MAX_STAGES];
+
+    portENTER_CRITICAL(&boot_mux);
+    size_t len = num_stages;
+    memcpy(copy, stages, sizeof(copy));
+    portEXIT_CRITICAL(&boot_mux);
+
+    log_i("Boot stages:      start     time");
+    for (size_t i = 0; i < len; i++) {
+        const auto& s = copy[i];
+        if (!s.end_ms)
+            log_i("%14s %7lu ms  running", s.name, s.start_ms);
+        else
+            log_i(
+                "%14s %7lu ms %5lu ms%s", s.name, s.start_ms, s.end_ms - s.start_ms,
+                s.ok ? "" : "  failed"
+            );
+    }
+}
@@ -0,0 +1,192 @@
+/**
+ * @file calib.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Stored MPU6050 offsets, by temperature.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "calib.hpp"
+
+#include "config.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+static Preferences prefs;
+
+// NVS isn't safe to use from the sampling task and the web server at once
+static SemaphoreHandle_t calib_lock = nullptr;
+
+/******************************************************************************/
+
+/**
+ * @brief Get the NVS key of a band.
+ *
+ * @param band The band.
+ * @param key Where to save the key.
+ * @param len The size of key.
+ */
+static void
+band_key(size_t band, char* key, size_t len)
+{
+    snprintf(key, len, "band%u", band);
+}
+
+/**
+ * @brief Load the offsets of a band.
+ *
+ * Must be called with the lock held.
+ *
+ * @param band The band.
+ * @param calib Where to save the offsets.
+ * @return bool If the band has offsets.
+ */
+static bool
+load_band(size_t band, calib_t* calib)
+{
+    char key[16];
+    band_key(band, key, sizeof(key));
+
+    // Skip entries from an older layout
+    if (prefs.getBytesLength(key) != sizeof(calib_t))
+        return false;
+    return prefs.getBytes(key, calib, sizeof(calib_t)) == sizeof(calib_t);
+}
+
+/******************************************************************************/
+
+StaticJsonDocument<256>
+calib_t::to_json() const
+{
+    StaticJsonDocument<256> doc;
+
+    auto accel_arr = doc.createNestedArray("accel");
+    auto gyro_arr = doc.createNestedArray("gyro");
+    for (size_t i = 0; i < 3; i++) {
+        accel_arr.add(accel[i]);
+        gyro_arr.add(gyro[i]);
+    }
+    doc["temp"] = temp;
+    if (time)
+        doc["time"] = time;
+
+    return doc;
+}
+
+bool
+calib_setup()
+{
+    calib_lock = xSemaphoreCreateMutex();
+    if (!calib_lock) {
+        log_e("Could not create the calibration lock");
+        return false;
+    }
+
+    if (!prefs.begin(CALIB_NVS_NAMESPACE)) {
+        log_e("Could not open the calibration table");
+        return false;
+    }
+    return true;
+}
+
+size_t
+calib_band(float temp)
+{
+    if (temp < CALIB_BAND_MIN)
+        return 0;
+
+    size_t band = (temp - CALIB_BAND_MIN) / CALIB_BAND_WIDTH;
+    return min<size_t>(band, CALIB_BANDS - 1);
+}
+
+int
+calib_find(float temp, calib_t* calib)
+{
+    if (!calib_lock)
+        return -1;
+
+    int band = calib_band(temp);
+    int found = -1;
+
+    xSemaphoreTake(calib_lock, portMAX_DELAY);
+    // Its own band, then the ones next to it, then further out
+    for (int dist = 0; dist < CALIB_BANDS && found < 0; dist++) {
+        if (band - dist >= 0 && load_band(band - dist, calib))
+            found = band - dist;
+        else if (dist && band + dist < CALIB_BANDS && load_band(band + dist, calib))
+            found = band + dist;
+    }
+    xSemaphoreGive(calib_lock);
+
+    return found;
+}
+
+bool
+calib_store(const calib_t& calib)
+{
+    if (!calib_lock)
+        return false;
+
+    char key[16];
+    band_key(calib_band(calib.temp), key, sizeof(key));
+
+    xSemaphoreTake(calib_lock, portMAX_DELAY);
+    bool ok = prefs.putBytes(key, &calib, sizeof(calib)) == sizeof(calib);
+    xSemaphoreGive(calib_lock);
+
+    if (!ok)
+        log_e("Could not store the offsets for %.1f °C", calib.temp);
+    return ok;
+}
+
+size_t
+calib_list(calib_t* calibs, bool* stored, size_t max)
+{
+    if (!calib_lock)
+        return 0;
+
+    size_t len = min<size_t>(max, CALIB_BANDS);
+
+    xSemaphoreTake(calib_lock, portMAX_DELAY);
+    for (size_t i = 0; i < len; i++)
+        stored[i] = load_band(i, &calibs[i]);
+    xSemaphoreGive(calib_lock);
+
+    return len;
+}
+
+bool
+calib_clear()
+{
+    if (!calib_lock)
+        return false;
+
+    xSemaphoreTake(calib_lock, portMAX_DELAY);
+    bool ok = prefs.clear();
+    xSemaphoreGive(calib_lock);
+
+    return ok;
+}
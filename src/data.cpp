@@ -30,9 +30,15 @@
  */
 #include "data.hpp"
 
+#include "config.h"
+#include "jobs.hpp"
+#include "metrics.hpp"
+#include "recording.hpp"
+#include "replay.hpp"
 #include "server.hpp"
+#include "storage.hpp"
 
-#include <LittleFS.h>
+#include <esp_timer.h>
 
 // What are we doing with our MPU data.
 enum DataSink {
@@ -51,59 +57,131 @@ static DataSink cur_data_sink = DATA_SINK_DEFAULT;
 // When to stop recording
 static unsigned long rec_end;
 
-// The file we're recording to
-static File rec_file;
+// The recording we're writing to
+static RecWriter rec_writer;
+
+// Guards the sink, which the data task and the web server both touch
+static SemaphoreHandle_t data_lock = nullptr;
+
+/**
+ * @brief A recording started before the time was synced.
+ */
+struct unsynced_rec_t {
+    char name[32];     // Its placeholder name, with the extension
+    uint32_t start_ms; // When it started, since boot
+};
+
+// Recordings to rename once the time is synced
+static unsynced_rec_t unsynced[REC_UNSYNCED_MAX];
+static size_t num_unsynced = 0;
+
+// If the recording in progress is the last of them
+static bool rec_unsynced = false;
+
+// If the time has been synced
+static bool time_synced = false;
+
+// Random ID of this boot, so placeholder names from different boots don't clash
+static uint32_t boot_id = 0;
 
 /******************************************************************************/
 
-StaticJsonDocument<MPU_DATA_JSON_SIZE>
-mpu_data_t::to_json()
+/**
+ * @brief Give the recordings started before the time was synced their real
+ * names, from when they started.
+ *
+ * The recording in progress is left for stop_recording().
+ */
+static void
+rename_unsynced()
+{
+    size_t len = num_unsynced - rec_unsynced;
+    time_t now = time(nullptr);
+
+    for (size_t i = 0; i < len; i++) {
+        const auto& rec = unsynced[i];
+
+        time_t start = now - (millis() - rec.start_ms) / 1000;
+        struct tm tm;
+        localtime_r(&start, &tm);
+
+        char name[32];
+        strftime(name, sizeof(name), "%FT%T%z.dat", &tm);
+        if (storage_rename(rec.name, name))
+            log_i("Renamed %s to %s", rec.name, name);
+        else
+            log_w("Could not rename %s to %s", rec.name, name);
+    }
+
+    if (rec_unsynced)
+        unsynced[0] = unsynced[len];
+    num_unsynced -= len;
+}
+
+/**
+ * @brief Close the current recording and go back to the default sink.
+ */
+static void
+stop_recording()
 {
-    StaticJsonDocument<MPU_DATA_JSON_SIZE> doc;
-
-    // Yaw, pitch, roll
-    // TODO(nino): send in radians or degrees?
-    JsonArray ypr_json = doc.createNestedArray("ypr");
-    ypr_json.add(degrees(ypr[0]));
-    ypr_json.add(degrees(ypr[1]));
-    ypr_json.add(degrees(ypr[2]));
-
-    // Real acceleration (w/o gravity)
-    JsonArray accel_json = doc.createNestedArray("accel");
-    accel_json.add(accel.x);
-    accel_json.add(accel.y);
-    accel_json.add(accel.x);
-
-    // Gyroscope
-    JsonArray gyro_json = doc.createNestedArray("gyro");
-    gyro_json.add(gyro.x);
-    gyro_json.add(gyro.y);
-    gyro_json.add(gyro.z);
-
-    // Time
-    doc["time"] = time;
-
-    return doc;
+    rec_writer.close();
+    cur_data_sink = DATA_SINK_DEFAULT;
+
+    rec_unsynced = false;
+    if (time_synced)
+        rename_unsynced();
+
+    // Make room for the next one
+    if (REC_KEEP_LAST || REC_MAX_BYTES)
+        jobs_submit(JOB_RETENTION);
+}
+
+/******************************************************************************/
+
+bool
+data_setup()
+{
+    data_lock = xSemaphoreCreateMutex();
+    if (!data_lock) {
+        log_e("Could not create the data lock");
+        return false;
+    }
+
+    boot_id = esp_random();
+    return true;
 }
 
 void
 data_process_measurement(mpu_data_t meas)
 {
+    int64_t dequeued_us = esp_timer_get_time();
+    xSemaphoreTake(data_lock, portMAX_DELAY);
+
     switch (cur_data_sink) {
         case DATA_SINK_STREAM:
-            web_server_send_event("mpuData", meas.to_json());
+            // Replays go out as the same event, so don't mix live data in
+            if (!replay_running())
+                web_server_send_sample(meas, dequeued_us);
             break;
 
-        case DATA_SINK_RECORD:
+        case DATA_SINK_RECORD: {
             if (millis() > rec_end) {
-                rec_file.close();
-                cur_data_sink = DATA_SINK_DEFAULT;
+                stop_recording();
 
                 log_i("Recording completed!");
-                return;
+                break;
+            }
+
+            uint32_t start = micros();
+            bool ok = rec_writer.write(meas);
+            metrics_rec_write(micros() - start);
+
+            if (!ok) {
+                log_e("Recording write failed, stopping recording.");
+                stop_recording();
             }
-            rec_file.write(reinterpret_cast<uint8_t*>(&meas), sizeof(meas));
             break;
+        }
 
         default:
             log_w("Invalid data sink %lu", cur_data_sink);
@@ -111,67 +189,73 @@ data_process_measurement(mpu_data_t meas)
             ESP.restart();
             break;
     }
+
+    xSemaphoreGive(data_lock);
 }
 
 void
-data_start_recording(uint32_t rec_len, String filename)
+data_start_recording(uint32_t rec_len, const char* name)
 {
-    // Prepend the dir and append the ext
-    filename = "/recs/" + filename + ".dat";
+    xSemaphoreTake(data_lock, portMAX_DELAY);
+
+    if (cur_data_sink == DATA_SINK_RECORD) {
+        log_w("Already recording, stopping the current recording first.");
+        stop_recording();
+    }
+
+    // Default to the current time, or a placeholder until we know it
+    char filename[32];
+    bool placeholder = false;
+    if (name) {
+        snprintf(filename, sizeof(filename), "%s.dat", name);
+    } else if (iso8601_str(filename, sizeof(filename), 0)) {
+        strlcat(filename, ".dat", sizeof(filename));
+    } else {
+        snprintf(filename, sizeof(filename), "boot-%08lx-%lu.dat", boot_id, millis());
+        placeholder = true;
+    }
 
-    log_i("Recording to %s...", filename.c_str());
+    log_i("Recording to %s...", filename);
 
     // Open the file
-    rec_file = LittleFS.open(filename, "w", true);
-    if (!rec_file) {
+    if (!rec_writer.begin(storage_create(filename, REC_STORAGE_DEFAULT))) {
         log_e("Could not open recording file.");
-        rec_file.close();
+        rec_writer.close();
+        xSemaphoreGive(data_lock);
         return;
     }
 
+    // Rename it once the time is synced
+    if (placeholder && num_unsynced < REC_UNSYNCED_MAX) {
+        auto& rec = unsynced[num_unsynced++];
+        strlcpy(rec.name, filename, sizeof(rec.name));
+        rec.start_ms = millis();
+        rec_unsynced = true;
+    } else if (placeholder) {
+        log_w("Too many recordings before the time sync, %s keeps its name", filename);
+    }
+
     // Set the sink mode
     cur_data_sink = DATA_SINK_RECORD;
 
     // Set the end time
     log_i("Starting recording for %lu ms.", rec_len);
     rec_end = millis() + rec_len;
+
+    xSemaphoreGive(data_lock);
 }
 
-bool
-data_clear_recordings()
+void
+data_time_synced()
 {
-    if (cur_data_sink == DATA_SINK_RECORD) {
-        log_w("In the middle of a recording, cannot modify recording data.");
-        return false;
-    }
-
-    File rec_dir = LittleFS.open("/recs");
-    if (!rec_dir) {
-        log_i("Recording dir already deleted");
-        rec_dir.close();
-        return true;
-    }
-
-    if (!rec_dir.isDirectory()) {
-        log_w("Recording dir not a directory, removing");
-        rec_dir.close();
-        LittleFS.remove("/recs");
-        return true;
-    }
-
-    File f;
-    while (f = rec_dir.openNextFile()) {
-        char* filename = strdup(f.path());
-        log_d("Deleting file %s", filename);
-
-        f.close();
-        if (!LittleFS.remove(filename)) {
-            log_e("Deleting file %s failed", filename);
-            return false;
-        }
-    }
+    xSemaphoreTake(data_lock, portMAX_DELAY);
+    time_synced = true;
+    rename_unsynced();
+    xSemaphoreGive(data_lock);
+}
 
-    log_d("Deleting recordings directory");
-    rec_dir.close();
-    return LittleFS.rmdir("/recs");
+bool
+data_is_recording()
+{
+    return cur_data_sink == DATA_SINK_RECORD;
 }
@@ -0,0 +1,131 @@
+/**
+ * @file downsample.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Streaming min/max downsampling.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "downsample.hpp"
+
+static void
+sample_to_channels(const mpu_data_t& sample, float* channels)
+{
+    memcpy(channels, sample.ypr, sizeof(sample.ypr));
+    channels[3] = sample.accel.x;
+    channels[4] = sample.accel.y;
+    channels[5] = sample.accel.z;
+    channels[6] = sample.gyro.x;
+    channels[7] = sample.gyro.y;
+    channels[8] = sample.gyro.z;
+}
+
+static void
+channels_to_sample(uint32_t time, const float* channels, mpu_data_t* sample)
+{
+    memcpy(sample->ypr, channels, sizeof(sample->ypr));
+    sample->accel = VectorFloat(channels[3], channels[4], channels[5]);
+    sample->gyro = VectorFloat(channels[6], channels[7], channels[8]);
+    sample->time = time;
+}
+
+/******************************************************************************/
+
+void
+Downsampler::begin(uint32_t from, uint32_t to, uint16_t max_points)
+{
+    uint32_t buckets = max<uint16_t>(max_points / 2, 1);
+
+    start_ = from;
+    width_ = max<uint32_t>((to - from) / buckets + 1, 1);
+    count_ = 0;
+    out_len_ = out_pos_ = 0;
+}
+
+void
+Downsampler::flush_()
+{
+    if (!count_)
+        return;
+
+    float first[DOWNSAMPLE_CHANNELS], second[DOWNSAMPLE_CHANNELS];
+    for (size_t c = 0; c < DOWNSAMPLE_CHANNELS; c++) {
+        first[c] = max_first_[c] ? max_[c] : min_[c];
+        second[c] = max_first_[c] ? min_[c] : max_[c];
+    }
+
+    channels_to_sample(first_, first, &out_[0]);
+    channels_to_sample(last_, second, &out_[1]);
+    out_len_ = count_ > 1 ? 2 : 1; // A lone sample is its own min and max
+    out_pos_ = 0;
+    count_ = 0;
+}
+
+void
+Downsampler::add(const mpu_data_t& sample)
+{
+    uint32_t bucket = sample.time > start_ ? (sample.time - start_) / width_ : 0;
+    if (count_ && bucket != bucket_)
+        flush_();
+
+    float channels[DOWNSAMPLE_CHANNELS];
+    sample_to_channels(sample, channels);
+
+    if (!count_) {
+        bucket_ = bucket;
+        first_ = sample.time;
+        memcpy(min_, channels, sizeof(min_));
+        memcpy(max_, channels, sizeof(max_));
+        memset(max_first_, 0, sizeof(max_first_));
+    }
+    count_++;
+    last_ = sample.time;
+
+    for (size_t c = 0; c < DOWNSAMPLE_CHANNELS; c++) {
+        if (channels[c] < min_[c]) {
+            min_[c] = channels[c];
+            max_first_[c] = true;
+        } else if (channels[c] > max_[c]) {
+            max_[c] = channels[c];
+            max_first_[c] = false;
+        }
+    }
+}
+
+void
+Downsampler::finish()
+{
+    flush_();
+}
+
+bool
+Downsampler::next(mpu_data_t* sample)
+{
+    if (out_pos_ >= out_len_)
+        return false;
+
+    *sample = out_[out_pos_++];
+    return true;
+}
@@ -0,0 +1,522 @@
+/**
+ * @file export.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Streaming recording exports.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "export.hpp"
+
+#include "config.h"
+#include "pool.hpp"
+
+#include <Arduino.h>
+#include <cmath>
+
+#ifdef EXPORT_GZIP
+// Compressors, shared by every export
+static StaticPool<GzipEncoder, EXPORT_GZIP_SLOTS> gzip_pool;
+#endif
+
+// Room for one value formatted with %.7g
+#define EXPORT_VALUE_SIZE 16
+
+/**
+ * @brief Get the channels of a sample, in export order and units.
+ *
+ * @return If all of them are finite.
+ */
+static bool
+export_values(const mpu_data_t& sample, double* vals)
+{
+    double channels[9] = {
+        degrees(sample.ypr[0]), degrees(sample.ypr[1]), degrees(sample.ypr[2]),
+        sample.accel.x,         sample.accel.y,         sample.accel.z,
+        sample.gyro.x,          sample.gyro.y,          sample.gyro.z,
+    };
+
+    bool finite = true;
+    for (size_t i = 0; i < 9; i++) {
+        vals[i] = channels[i];
+        finite = finite && std::isfinite(channels[i]);
+    }
+    return finite;
+}
+
+/**
+ * @brief Format each channel on its own, for samples with non-finite values.
+ *
+ * @param bufs Containers for the formatted values.
+ * @param vals The channels.
+ * @param strs Set to the formatted values.
+ * @param missing Used instead of non-finite values.
+ */
+static void
+export_strs(
+    char (*bufs)[EXPORT_VALUE_SIZE], const double* vals, const char** strs,
+    const char* missing
+)
+{
+    for (size_t i = 0; i < 9; i++) {
+        if (std::isfinite(vals[i])) {
+            snprintf(bufs[i], EXPORT_VALUE_SIZE, "%.7g", vals[i]);
+            strs[i] = bufs[i];
+        } else {
+            strs[i] = missing;
+        }
+    }
+}
+
+/**
+ * @brief Format a sample as JSON, the same way as mpu_data_t::to_json().
+ *
+ * Floats get 7 significant digits, all a float really has. JSON has no NaN or
+ * infinity, so those become null.
+ *
+ * @param buf Container to write the JSON to.
+ * @param size Size of the container.
+ * @param sample The sample.
+ * @param first If this is the first sample, which doesn't need a separator.
+ * @return The length of the JSON.
+ */
+static size_t
+format_json(char* buf, size_t size, const mpu_data_t& sample, bool first)
+{
+    double v[9];
+    int len;
+    if (export_values(sample, v)) {
+        len = snprintf(
+            buf, size,
+            "%s{\"ypr\":[%.7g,%.7g,%.7g],\"accel\":[%.7g,%.7g,%.7g],"
+            "\"gyro\":[%.7g,%.7g,%.7g],\"time\":%lu}",
+            first ? "" : ",", v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8],
+            sample.time
+        );
+    } else {
+        char bufs[9][EXPORT_VALUE_SIZE];
+        const char* s[9];
+        export_strs(bufs, v, s, "null");
+        len = snprintf(
+            buf, size,
+            "%s{\"ypr\":[%s,%s,%s],\"accel\":[%s,%s,%s],"
+            "\"gyro\":[%s,%s,%s],\"time\":%lu}",
+            first ? "" : ",", s[0], s[1], s[2], s[3], s[4], s[5], s[6], s[7], s[8],
+            sample.time
+        );
+    }
+    return min<size_t>(len, size - 1);
+}
+
+/**
+ * @brief Format a sample as a CSV row.
+ *
+ * Non-finite values are left empty.
+ */
+static size_t
+format_csv(char* buf, size_t size, const mpu_data_t& sample)
+{
+    double v[9];
+    int len;
+    if (export_values(sample, v)) {
+        len = snprintf(
+            buf, size, "%lu,%.7g,%.7g,%.7g,%.7g,%.7g,%.7g,%.7g,%.7g,%.7g\n",
+            sample.time, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8]
+        );
+    } else {
+        char bufs[9][EXPORT_VALUE_SIZE];
+        const char* s[9];
+        export_strs(bufs, v, s, "");
+        len = snprintf(
+            buf, size, "%lu,%s,%s,%s,%s,%s,%s,%s,%s,%s\n", sample.time, s[0], s[1],
+            s[2], s[3], s[4], s[5], s[6], s[7], s[8]
+        );
+    }
+    return min<size_t>(len, size - 1);
+}
+
+/**
+ * @brief Pack a sample for a binary export.
+ */
+static size_t
+format_binary(char* buf, const mpu_data_t& sample)
+{
+    // The ESP32 is little-endian already
+    export_bin_sample_t packed = {
+        (uint32_t)sample.time,
+        {(float)degrees(sample.ypr[0]), (float)degrees(sample.ypr[1]),
+         (float)degrees(sample.ypr[2])},
+        {sample.accel.x, sample.accel.y, sample.accel.z},
+        {sample.gyro.x, sample.gyro.y, sample.gyro.z},
+    };
+    memcpy(buf, &packed, sizeof(packed));
+    return sizeof(packed);
+}
+
+/******************************************************************************/
+
+bool
+export_format_parse(const String& str, ExportFormat* format)
+{
+    if (str == "json")
+        *format = EXPORT_JSON;
+    else if (str == "csv")
+        *format = EXPORT_CSV;
+    else if (str == "bin")
+        *format = EXPORT_BINARY;
+    else
+        return false;
+
+    return true;
+}
+
+const char*
+export_format_mime(ExportFormat format)
+{
+    switch (format) {
+        case EXPORT_CSV:
+            return "text/csv";
+        case EXPORT_BINARY:
+            return "application/octet-stream";
+        default:
+            return "application/json";
+    }
+}
+
+const char*
+export_format_ext(ExportFormat format)
+{
+    switch (format) {
+        case EXPORT_CSV:
+            return "csv";
+        case EXPORT_BINARY:
+            return "bin";
+        default:
+            return "json";
+    }
+}
+
+/******************************************************************************/
+
+bool
+RecExporter::begin(RecFile file, ExportFormat format)
+{
+    format_ = format;
+    from_ = 0;
+    to_ = UINT32_MAX;
+    downsample_ = false;
+    carry_len_ = carry_pos_ = 0;
+    state_ = EXPORT_HEADER;
+    free_gzip_();
+    samples_ = raw_bytes_ = bytes_ = 0;
+
+    resumes_len_ = 0;
+    resume_count_ = 0;
+    resume_stride_ = 1;
+    next_resume_ = EXPORT_RESUME_INTERVAL;
+    resume_due_ = false;
+    syncs_ = 0;
+    produced_ = last_time_ = 0;
+
+    return reader_.begin(file);
+}
+
+bool
+RecExporter::seek(uint32_t from, uint32_t to)
+{
+    from_ = from;
+    to_ = to;
+    return reader_.seek(from, to);
+}
+
+bool
+RecExporter::downsample(uint16_t max_points)
+{
+    // Buckets need to cover the part of the window that has samples
+    uint32_t end;
+    if (!reader_.end_time(&end))
+        end = reader_.start_time();
+
+    uint32_t start = reader_.start_time();
+    uint32_t from = start + from_;
+    uint32_t to = to_ > UINT32_MAX - start ? UINT32_MAX : start + to_;
+
+    downsampler_.begin(from, min(to, end), max_points);
+    downsample_ = true;
+    return reader_.seek(from_, to_);
+}
+
+bool
+RecExporter::next_sample_(mpu_data_t* sample)
+{
+    if (!downsample_)
+        return reader_.next(sample);
+
+    // Feed the downsampler until it finishes a bucket
+    while (!downsampler_.next(sample)) {
+        mpu_data_t raw;
+        if (!reader_.next(&raw)) {
+            downsampler_.finish(); // Does nothing once the last bucket is out
+            return downsampler_.next(sample);
+        }
+        downsampler_.add(raw);
+    }
+    return true;
+}
+
+size_t
+RecExporter::header_(char* buf)
+{
+    switch (format_) {
+        case EXPORT_CSV:
+            return strlcpy(
+                buf,
+                "time,yaw,pitch,roll,accel_x,accel_y,accel_z,gyro_x,gyro_y,gyro_z\n",
+                EXPORT_CARRY_SIZE
+            );
+
+        case EXPORT_BINARY: {
+            export_bin_header_t header = {
+                EXPORT_BIN_MAGIC, EXPORT_BIN_VERSION, sizeof(export_bin_sample_t)
+            };
+            memcpy(buf, &header, sizeof(header));
+            return sizeof(header);
+        }
+
+        default:
+            return strlcpy(buf, "{\"data\":[", EXPORT_CARRY_SIZE);
+    }
+}
+
+size_t
+RecExporter::next_(char* buf)
+{
+    mpu_data_t sample;
+
+    switch (state_) {
+        case EXPORT_HEADER:
+            state_ = EXPORT_SAMPLES;
+            return header_(buf);
+
+        case EXPORT_SAMPLES:
+            if (next_sample_(&sample)) {
+                last_time_ = sample.time;
+                switch (format_) {
+                    case EXPORT_CSV:
+                        samples_++;
+                        return format_csv(buf, EXPORT_CARRY_SIZE, sample);
+
+                    case EXPORT_BINARY:
+                        samples_++;
+                        return format_binary(buf, sample);
+
+                    default:
+                        return format_json(buf, EXPORT_CARRY_SIZE, sample, !samples_++);
+                }
+            }
+            state_ = EXPORT_FOOTER;
+            [[fallthrough]];
+
+        case EXPORT_FOOTER:
+            state_ = EXPORT_DONE;
+            if (format_ == EXPORT_JSON)
+                return strlcpy(buf, "]}", EXPORT_CARRY_SIZE);
+            return next_(buf); // Nothing after the samples
+
+        default:
+            return 0;
+    }
+}
+
+bool
+RecExporter::compress()
+{
+#ifdef EXPORT_GZIP
+    free_gzip_();
+    gzip_ = gzip_pool.acquire();
+    if (!gzip_) {
+        log_w("Every compressor is in use, sending the export uncompressed");
+        return false;
+    }
+
+    gzip_->begin([this](uint8_t* buf, size_t len) { return fill_raw_(buf, len); });
+    syncs_ = 0;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool
+RecExporter::resume(const export_resume_t& point)
+{
+    if (downsample_)
+        return false;
+
+    state_ = EXPORT_SAMPLES;
+    carry_len_ = carry_pos_ = 0;
+    samples_ = point.samples;
+    produced_ = raw_bytes_ = point.raw;
+    bytes_ = point.out;
+    next_resume_ = point.raw + EXPORT_RESUME_INTERVAL;
+    resume_due_ = false;
+
+#ifdef EXPORT_GZIP
+    if (gzip_) {
+        gzip_sync_t sync = {point.raw, point.out, point.crc};
+        gzip_->begin(
+            [this](uint8_t* buf, size_t len) { return fill_raw_(buf, len); }, sync
+        );
+        syncs_ = 0;
+    }
+#endif
+
+    // The index gets us to the block, the window skips to the sample
+    return reader_.seek(point.time - reader_.start_time(), to_);
+}
+
+size_t
+RecExporter::fill(uint8_t* buf, size_t max_len)
+{
+    size_t written = gzip_ ? gzip_->fill(buf, max_len) : fill_raw_(buf, max_len);
+    bytes_ += written;
+    return written;
+}
+
+size_t
+RecExporter::fill_raw_(uint8_t* buf, size_t max_len)
+{
+#ifdef EXPORT_GZIP
+    // The compressor reached the resume point we asked it to sync at
+    if (gzip_ && gzip_->syncs() != syncs_) {
+        syncs_ = gzip_->syncs();
+        export_resume_t point = resume_due_at_;
+        point.out = gzip_->last_sync().out;
+        point.crc = gzip_->last_sync().crc;
+        add_resume_(point);
+    }
+#endif
+
+    size_t written = 0;
+
+    while (written < max_len) {
+        // Send whatever didn't fit last time first
+        if (carry_pos_ < carry_len_) {
+            size_t len = min(max_len - written, carry_len_ - carry_pos_);
+            memcpy(buf + written, carry_ + carry_pos_, len);
+            carry_pos_ += len;
+            written += len;
+            continue;
+        }
+
+        // Everything generated so far is out, so this is between two samples
+        if (resume_due_ && !resume_point_())
+            break;
+
+        // Skip the copy when there's definitely room
+        bool direct = max_len - written >= EXPORT_CARRY_SIZE;
+        size_t len = next_(direct ? reinterpret_cast<char*>(buf + written) : carry_);
+        if (!len)
+            break;
+
+        produced_ += len;
+        if (samples_ && state_ == EXPORT_SAMPLES && !downsample_
+            && produced_ >= next_resume_)
+            resume_due_ = true;
+
+        if (direct) {
+            written += len;
+        } else {
+            carry_len_ = len;
+            carry_pos_ = 0;
+        }
+    }
+
+    raw_bytes_ += written;
+    return written;
+}
+
+/**
+ * @brief Add the resume point that is due, now that we're between two samples.
+ *
+ * @return If the chunk can go on. Compressed exports end it, so the compressor
+ * can sync before anything after the resume point.
+ */
+bool
+RecExporter::resume_point_()
+{
+    resume_due_ = false;
+    next_resume_ = produced_ + EXPORT_RESUME_INTERVAL;
+
+    // Samples have increasing times, so the next one is at least a ms later
+    export_resume_t point = {produced_, produced_, 0, last_time_ + 1, samples_};
+
+#ifdef EXPORT_GZIP
+    if (gzip_) {
+        // Added once the compressor catches up (see fill_raw_())
+        resume_due_at_ = point;
+        gzip_->sync();
+        return false;
+    }
+#endif
+
+    add_resume_(point);
+    return true;
+}
+
+void
+RecExporter::add_resume_(const export_resume_t& point)
+{
+    if (resume_count_++ % resume_stride_)
+        return;
+
+    // Out of room, keep every other one from here on
+    if (resumes_len_ == EXPORT_RESUME_POINTS) {
+        for (size_t i = 0; i < EXPORT_RESUME_POINTS / 2; i++)
+            resumes_[i] = resumes_[2 * i];
+        resumes_len_ = EXPORT_RESUME_POINTS / 2;
+        resume_stride_ *= 2;
+
+        if ((resume_count_ - 1) % resume_stride_)
+            return;
+    }
+    resumes_[resumes_len_++] = point;
+}
+
+void
+RecExporter::free_gzip_()
+{
+#ifdef EXPORT_GZIP
+    gzip_pool.release(gzip_);
+#endif
+    gzip_ = nullptr;
+}
+
+void
+RecExporter::close()
+{
+    reader_.close();
+    free_gzip_(); // Give the compressor back
+}
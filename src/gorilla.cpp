@@ -0,0 +1,317 @@
+/**
+ * @file gorilla.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Gorilla-style compression for recorded samples.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "gorilla.hpp"
+
+#include <cstring>
+
+static inline uint8_t
+count_leading_zeros(uint32_t val)
+{
+    return val ? __builtin_clz(val) : 32;
+}
+
+static inline uint8_t
+count_trailing_zeros(uint32_t val)
+{
+    return val ? __builtin_ctz(val) : 32;
+}
+
+/******************************************************************************/
+
+void
+GorillaEncoder::begin(uint8_t* buf, size_t len)
+{
+    buf_ = buf;
+    cap_bits_ = len * 8;
+    bits_ = 0;
+    count_ = 0;
+}
+
+void
+GorillaEncoder::write_bits_(uint32_t val, uint8_t nbits)
+{
+    // Write MSB first, a byte (or less) at a time
+    while (nbits) {
+        size_t byte = bits_ / 8;
+        uint8_t used = bits_ % 8;
+        uint8_t n = nbits < 8 - used ? nbits : 8 - used;
+
+        uint8_t chunk = (val >> (nbits - n)) & ((1u << n) - 1);
+        if (!used)
+            buf_[byte] = 0;
+        buf_[byte] |= chunk << (8 - used - n);
+
+        bits_ += n;
+        nbits -= n;
+    }
+}
+
+void
+GorillaEncoder::encode_time_(uint64_t time)
+{
+    // Wrap around instead of overflowing, even for huge jumps
+    int64_t delta = (int64_t)(time - time_);
+    int64_t dod = (int64_t)((uint64_t)delta - (uint64_t)delta_);
+
+    if (dod == 0) {
+        write_bits_(0b0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        write_bits_(0b10, 2);
+        write_bits_(dod + 63, 7);
+    } else if (dod >= -255 && dod <= 256) {
+        write_bits_(0b110, 3);
+        write_bits_(dod + 255, 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        write_bits_(0b1110, 4);
+        write_bits_(dod + 2047, 12);
+    } else if (dod >= INT32_MIN && dod <= INT32_MAX) {
+        write_bits_(0b11110, 5);
+        write_bits_((uint32_t)dod, 32);
+    } else {
+        // Only when the ms time wraps around, or jumps by weeks
+        write_bits_(0b11111, 5);
+        write_bits_((uint64_t)dod >> 32, 32);
+        write_bits_((uint32_t)dod, 32);
+    }
+
+    time_ = time;
+    delta_ = delta;
+}
+
+void
+GorillaEncoder::encode_value_(size_t ch, uint32_t val)
+{
+    uint32_t xored = val ^ values_[ch];
+    values_[ch] = val;
+
+    if (!xored) {
+        write_bits_(0b0, 1);
+        return;
+    }
+
+    uint8_t leading = count_leading_zeros(xored);
+    uint8_t trailing = count_trailing_zeros(xored);
+
+    if (leading >= leading_[ch] && trailing >= trailing_[ch]) {
+        // Fits in the previous window, just store the meaningful bits
+        uint8_t len = 32 - leading_[ch] - trailing_[ch];
+        write_bits_(0b10, 2);
+        write_bits_(xored >> trailing_[ch], len);
+        return;
+    }
+
+    // New window
+    uint8_t len = 32 - leading - trailing;
+    write_bits_(0b11, 2);
+    write_bits_(leading, 5);
+    write_bits_(len - 1, 5);
+    write_bits_(xored >> trailing, len);
+
+    leading_[ch] = leading;
+    trailing_[ch] = trailing;
+}
+
+void
+GorillaEncoder::encode(uint32_t time, uint16_t time_us, const float* values)
+{
+    uint64_t us = (uint64_t)time * 1000 + time_us;
+
+    if (count_++ == 0) {
+        // First sample is stored as-is, the ms time first so it's easy to find
+        write_bits_(time, 32);
+        write_bits_(time_us, 10);
+        for (size_t ch = 0; ch < GORILLA_CHANNELS; ch++) {
+            memcpy(&values_[ch], &values[ch], 4);
+            write_bits_(values_[ch], 32);
+
+            // No previous window
+            leading_[ch] = 32;
+            trailing_[ch] = 32;
+        }
+
+        time_ = us;
+        delta_ = 0;
+        return;
+    }
+
+    encode_time_(us);
+    for (size_t ch = 0; ch < GORILLA_CHANNELS; ch++) {
+        uint32_t val;
+        memcpy(&val, &values[ch], 4);
+        encode_value_(ch, val);
+    }
+}
+
+/******************************************************************************/
+
+void
+GorillaDecoder::begin(const uint8_t* buf, size_t len, bool ms_only)
+{
+    ms_only_ = ms_only;
+    buf_ = buf;
+    len_bits_ = len * 8;
+    bits_ = 0;
+    count_ = 0;
+}
+
+bool
+GorillaDecoder::read_bits_(uint8_t nbits, uint32_t* val)
+{
+    if (bits_ + nbits > len_bits_)
+        return false;
+
+    uint32_t res = 0;
+    while (nbits) {
+        size_t byte = bits_ / 8;
+        uint8_t used = bits_ % 8;
+        uint8_t n = nbits < 8 - used ? nbits : 8 - used;
+
+        uint8_t chunk = (buf_[byte] >> (8 - used - n)) & ((1u << n) - 1);
+        res = (res << n) | chunk;
+
+        bits_ += n;
+        nbits -= n;
+    }
+
+    *val = res;
+    return true;
+}
+
+bool
+GorillaDecoder::decode_time_()
+{
+    // Count the leading 1s of the prefix (up to 4)
+    uint32_t bit;
+    uint8_t ones = 0;
+    while (ones < 4) {
+        if (!read_bits_(1, &bit))
+            return false;
+        if (!bit)
+            break;
+        ones++;
+    }
+
+    static const uint8_t widths[] = {0, 7, 9, 12};
+    static const int32_t biases[] = {0, 63, 255, 2047};
+
+    int64_t dod = 0;
+    uint32_t raw;
+    if (ones == 4) {
+        // 32 bits, or 64 for huge jumps (never in ms only times)
+        if (!ms_only_ && !read_bits_(1, &bit))
+            return false;
+        if (!read_bits_(32, &raw))
+            return false;
+
+        dod = (int32_t)raw;
+        if (!ms_only_ && bit) {
+            uint32_t low;
+            if (!read_bits_(32, &low))
+                return false;
+            dod = (int64_t)((uint64_t)raw << 32 | low);
+        }
+    } else if (ones) {
+        if (!read_bits_(widths[ones], &raw))
+            return false;
+        dod = (int32_t)raw - biases[ones];
+    }
+
+    // Wrap around like the encoder did
+    delta_ = (int64_t)((uint64_t)delta_ + (uint64_t)dod);
+    time_ += (uint64_t)delta_;
+    return true;
+}
+
+bool
+GorillaDecoder::decode_value_(size_t ch)
+{
+    uint32_t bit;
+    if (!read_bits_(1, &bit))
+        return false;
+    if (!bit)
+        return true; // Same as before
+
+    if (!read_bits_(1, &bit))
+        return false;
+
+    if (bit) {
+        // New window
+        uint32_t leading, len;
+        if (!read_bits_(5, &leading) || !read_bits_(5, &len))
+            return false;
+        len += 1;
+
+        leading_[ch] = leading;
+        trailing_[ch] = 32 - leading - len;
+    }
+
+    uint32_t meaningful;
+    uint8_t len = 32 - leading_[ch] - trailing_[ch];
+    if (!read_bits_(len, &meaningful))
+        return false;
+
+    values_[ch] ^= meaningful << trailing_[ch];
+    return true;
+}
+
+bool
+GorillaDecoder::decode(uint32_t* time, uint16_t* time_us, float* values)
+{
+    if (count_ == 0) {
+        uint32_t ms, us = 0;
+        if (!read_bits_(32, &ms) || (!ms_only_ && !read_bits_(10, &us)))
+            return false;
+        time_ = ms_only_ ? ms : (uint64_t)ms * 1000 + us;
+        for (size_t ch = 0; ch < GORILLA_CHANNELS; ch++) {
+            if (!read_bits_(32, &values_[ch]))
+                return false;
+        }
+        delta_ = 0;
+    } else {
+        if (!decode_time_())
+            return false;
+        for (size_t ch = 0; ch < GORILLA_CHANNELS; ch++) {
+            if (!decode_value_(ch))
+                return false;
+        }
+    }
+    count_++;
+
+    if (ms_only_) {
+        *time = time_;
+        *time_us = 0;
+    } else {
+        *time = time_ / 1000;
+        *time_us = time_ % 1000;
+    }
+    memcpy(values, values_, sizeof(values_));
+    return true;
+}
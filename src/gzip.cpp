@@ -0,0 +1,340 @@
+/**
+ * @file gzip.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Streaming gzip compression.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "gzip.hpp"
+
+#include <esp_rom_crc.h>
+
+#include <algorithm>
+#include <cstring>
+
+// Deflate length codes 257-285: shortest length and number of extra bits
+static const uint16_t len_base[] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,
+                                    15, 17, 19, 23, 27, 31, 35, 43, 51,  59,
+                                    67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t len_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                    2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+// Deflate distance codes 0-29: shortest distance and number of extra bits
+static const uint16_t dist_base[] = {1,    2,    3,    4,    5,    7,     9,     13,
+                                     17,   25,   33,   49,   65,   97,    129,   193,
+                                     257,  385,  513,  769,  1025, 1537,  2049,  3073,
+                                     4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t dist_extra[] = {0,  0,  0,  0,  1,  1,  2,  2,  3,  3,
+                                     4,  4,  5,  5,  6,  6,  7,  7,  8,  8,
+                                     9,  9,  10, 10, 11, 11, 12, 12, 13, 13};
+
+// Header of a gzip member: magic, deflate, no flags, no mtime, unknown OS
+static const uint8_t gzip_header[] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+
+// Length of the gzip trailer (CRC32 and length)
+#define GZIP_TRAILER_LEN 8
+
+static inline uint32_t
+reverse_bits(uint32_t val, uint8_t nbits)
+{
+    uint32_t out = 0;
+    for (uint8_t i = 0; i < nbits; i++, val >>= 1)
+        out = out << 1 | (val & 1);
+    return out;
+}
+
+static inline size_t
+hash3(const uint8_t* data)
+{
+    uint32_t val = data[0] << 16 | data[1] << 8 | data[2];
+    return (val * 2654435761u) >> (32 - GZIP_HASH_BITS);
+}
+
+/**
+ * @brief Find the deflate code for a length or distance.
+ */
+static inline size_t
+find_code(const uint16_t* base, size_t len, size_t val)
+{
+    size_t i = len - 1;
+    while (base[i] > val)
+        i--;
+    return i;
+}
+
+/******************************************************************************/
+
+void
+GzipEncoder::begin(gzip_source_t source)
+{
+    source_ = source;
+    memset(head_, 0, sizeof(head_));
+    memset(prev_, 0, sizeof(prev_));
+    len_ = pos_ = 0;
+    eof_ = sync_ = false;
+
+    bits_ = 0;
+    nbits_ = 0;
+    state_ = GZIP_HEADER;
+    idx_ = 0;
+
+    crc_ = in_size_ = out_size_ = 0;
+    last_sync_ = {};
+    syncs_ = 0;
+}
+
+void
+GzipEncoder::begin(gzip_source_t source, const gzip_sync_t& from)
+{
+    begin(source);
+
+    // The header went out before the sync point
+    state_ = GZIP_BLOCK;
+    in_size_ = from.in;
+    out_size_ = from.out;
+    crc_ = from.crc;
+    last_sync_ = from;
+}
+
+void
+GzipEncoder::put_bits_(uint32_t val, uint8_t nbits)
+{
+    bits_ |= (uint64_t)val << nbits_;
+    nbits_ += nbits;
+}
+
+void
+GzipEncoder::put_literal_(uint16_t lit)
+{
+    // Fixed Huffman codes, which are stored MSB first
+    if (lit < 144)
+        put_bits_(reverse_bits(0x30 + lit, 8), 8);
+    else if (lit < 256)
+        put_bits_(reverse_bits(0x190 + lit - 144, 9), 9);
+    else if (lit < 280)
+        put_bits_(reverse_bits(lit - 256, 7), 7);
+    else
+        put_bits_(reverse_bits(0xc0 + lit - 280, 8), 8);
+}
+
+void
+GzipEncoder::put_match_(size_t len, size_t dist)
+{
+    size_t code = find_code(len_base, sizeof(len_base) / sizeof(*len_base), len);
+    put_literal_(257 + code);
+    put_bits_(len - len_base[code], len_extra[code]);
+
+    code = find_code(dist_base, sizeof(dist_base) / sizeof(*dist_base), dist);
+    put_bits_(reverse_bits(code, 5), 5);
+    put_bits_(dist - dist_base[code], dist_extra[code]);
+}
+
+void
+GzipEncoder::read_()
+{
+    // Slide the window once the lookahead reaches the end
+    if (len_ == sizeof(window_)) {
+        memmove(window_, window_ + GZIP_WINDOW, GZIP_WINDOW);
+        len_ -= GZIP_WINDOW;
+        pos_ -= GZIP_WINDOW;
+
+        for (auto& pos : head_)
+            pos = pos > GZIP_WINDOW ? pos - GZIP_WINDOW : 0;
+        for (auto& pos : prev_)
+            pos = pos > GZIP_WINDOW ? pos - GZIP_WINDOW : 0;
+    }
+
+    size_t len = source_(window_ + len_, sizeof(window_) - len_);
+    if (!len) {
+        eof_ = !sync_; // Nothing more before the sync point isn't the end
+        return;
+    }
+
+    crc_ = esp_rom_crc32_le(crc_, window_ + len_, len);
+    in_size_ += len;
+    len_ += len;
+}
+
+void
+GzipEncoder::insert_(size_t pos)
+{
+    if (pos + GZIP_MIN_MATCH > len_)
+        return;
+
+    size_t hash = hash3(window_ + pos);
+    prev_[pos % GZIP_WINDOW] = head_[hash];
+    head_[hash] = pos + 1;
+}
+
+size_t
+GzipEncoder::find_match_(size_t* dist)
+{
+    size_t max_len = std::min<size_t>(len_ - pos_, GZIP_MAX_MATCH);
+    if (max_len < GZIP_MIN_MATCH)
+        return 0;
+
+    size_t best = 0;
+    size_t cand = head_[hash3(window_ + pos_)];
+
+    for (size_t chain = 0; cand && chain < GZIP_MAX_CHAIN; chain++) {
+        size_t match = cand - 1;
+        if (pos_ - match >= GZIP_WINDOW)
+            break; // Too far back, and the rest of the chain is further
+
+        size_t len = 0;
+        while (len < max_len && window_[match + len] == window_[pos_ + len])
+            len++;
+
+        if (len > best) {
+            best = len;
+            *dist = pos_ - match;
+            if (len == max_len)
+                break;
+        }
+
+        size_t next = prev_[match % GZIP_WINDOW];
+        if (next >= cand)
+            break; // Overwritten by a newer position
+        cand = next;
+    }
+
+    return best >= GZIP_MIN_MATCH ? best : 0;
+}
+
+void
+GzipEncoder::flush_()
+{
+    // End the block, then add an empty stored block to get to a byte boundary
+    put_literal_(256);
+    put_bits_(0, 1); // Not the last block
+    put_bits_(0, 2); // Stored
+    if (nbits_ % 8)
+        put_bits_(0, 8 - nbits_ % 8);
+    put_bits_(0xffff0000, 32); // Length 0, and its complement
+
+    // Nothing after this can refer back to before it
+    memset(head_, 0, sizeof(head_));
+    memset(prev_, 0, sizeof(prev_));
+    len_ = pos_ = 0;
+
+    sync_ = false;
+    last_sync_ = {in_size_, out_size_ + nbits_ / 8u, crc_};
+    syncs_++;
+}
+
+void
+GzipEncoder::step_()
+{
+    switch (state_) {
+        case GZIP_HEADER:
+            put_bits_(gzip_header[idx_++], 8);
+            if (idx_ == sizeof(gzip_header))
+                state_ = GZIP_BLOCK;
+            break;
+
+        case GZIP_BLOCK:
+            // A fixed-Huffman block that lasts until the next sync point
+            put_bits_(0, 1); // Not the last block
+            put_bits_(1, 2); // Fixed Huffman codes
+            state_ = GZIP_DATA;
+            break;
+
+        case GZIP_DATA:
+            // Don't read past a sync point until it's written
+            if (sync_ && pos_ == len_) {
+                flush_();
+                state_ = GZIP_BLOCK;
+                break;
+            }
+
+            // Keep a full match of lookahead
+            if (!sync_ && !eof_ && len_ - pos_ < GZIP_MAX_MATCH) {
+                read_();
+                break;
+            }
+
+            if (pos_ < len_) {
+                size_t dist;
+                size_t len = find_match_(&dist);
+                if (len) {
+                    put_match_(len, dist);
+                } else {
+                    put_literal_(window_[pos_]);
+                    len = 1;
+                }
+
+                for (size_t end = pos_ + len; pos_ < end; pos_++)
+                    insert_(pos_);
+                break;
+            }
+
+            // End the block, then add an empty last one
+            put_literal_(256);
+            put_bits_(1, 1);
+            put_bits_(1, 2);
+            put_literal_(256);
+            if (nbits_ % 8)
+                put_bits_(0, 8 - nbits_ % 8);
+
+            state_ = GZIP_TRAILER;
+            idx_ = 0;
+            break;
+
+        case GZIP_TRAILER:
+            // CRC32, then length, both little-endian
+            put_bits_((idx_ < 4 ? crc_ : in_size_) >> (idx_ % 4 * 8) & 0xff, 8);
+            if (++idx_ == GZIP_TRAILER_LEN)
+                state_ = GZIP_DONE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+size_t
+GzipEncoder::fill(uint8_t* buf, size_t max_len)
+{
+    size_t written = 0;
+
+    while (true) {
+        // Write out every whole byte
+        while (nbits_ >= 8 && written < max_len) {
+            buf[written++] = bits_;
+            bits_ >>= 8;
+            nbits_ -= 8;
+            out_size_++; // Counted as we go, for the sync points
+        }
+
+        // Each step adds at most 49 bits, so there's always room for one
+        if (written == max_len || (state_ == GZIP_DONE && nbits_ < 8))
+            break;
+
+        step_();
+    }
+
+    return written;
+}
@@ -0,0 +1,202 @@
+/**
+ * @file heap.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Heap fragmentation tracking and allocation checks.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "heap.hpp"
+
+#include "config.h"
+
+/******************************************************************************/
+
+// The last HEAP_SAMPLES samples, by number % HEAP_SAMPLES
+static heap_sample_t samples[HEAP_SAMPLES];
+
+// Number of samples taken
+static uint32_t num_samples = 0;
+
+// When the last one was taken
+static uint32_t last_sample_ms = 0;
+
+/******************************************************************************/
+
+static void
+take_sample(heap_sample_t* sample)
+{
+    sample->time = millis();
+    sample->free = ESP.getFreeHeap();
+    sample->largest = ESP.getMaxAllocHeap();
+    sample->min_free = ESP.getMinFreeHeap();
+}
+
+/**
+ * @brief How much of the free heap is in pieces smaller than the largest block.
+ *
+ * @return 0 for a single free block, getting closer to 1 as it fragments.
+ */
+static float
+fragmentation(const heap_sample_t& sample)
+{
+    return sample.free ? 1 - (float)sample.largest / sample.free : 0;
+}
+
+/******************************************************************************/
+
+void
+heap_loop()
+{
+    uint32_t now = millis();
+    if (num_samples && now - last_sample_ms < HEAP_SAMPLE_INTERVAL)
+        return;
+
+    take_sample(&samples[num_samples++ % HEAP_SAMPLES]);
+    last_sample_ms = now;
+}
+
+void
+heap_print_report()
+{
+    heap_sample_t now;
+    take_sample(&now);
+
+    log_i(
+        "Heap: %lu B free, largest block %lu B (%.0f%% fragmented), lowest %lu B",
+        now.free, now.largest, fragmentation(now) * 100, now.min_free
+    );
+
+    size_t len = min<uint32_t>(num_samples, HEAP_SAMPLES);
+    if (!len)
+        return;
+
+    const auto& first = samples[(num_samples - len) % HEAP_SAMPLES];
+    log_i(
+        "Since %lu s: free %+ld B, largest block %+ld B", first.time / 1000,
+        (long)(int32_t)(now.free - first.free),
+        (long)(int32_t)(now.largest - first.largest)
+    );
+
+    log_i("  uptime       free    largest  frag");
+    for (size_t i = 0; i < len; i++) {
+        const auto& s = samples[(num_samples - len + i) % HEAP_SAMPLES];
+        log_i(
+            "%8lu s %8lu B %8lu B %4.0f%%", s.time / 1000, s.free, s.largest,
+            fragmentation(s) * 100
+        );
+    }
+}
+
+/******************************************************************************/
+
+#ifdef HEAP_CHECK
+
+/*
+ * Built with -Wl,--wrap=malloc (and calloc and realloc), so every allocation
+ * goes through here first, including the ones in the Arduino core and
+ * libraries. Frees aren't counted, a hot path shouldn't get that far.
+ */
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+}
+
+// Tasks being watched, and their allocation counts
+static TaskHandle_t watched[HEAP_CHECK_TASKS];
+static volatile uint32_t allocs[HEAP_CHECK_TASKS];
+static portMUX_TYPE heap_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Count an allocation against the calling task, if it's being watched.
+ *
+ * In IRAM, like the allocator, since it can be called with the flash cache off.
+ */
+static void IRAM_ATTR
+count_alloc()
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (size_t i = 0; i < HEAP_CHECK_TASKS; i++) {
+        if (watched[i] && watched[i] == task) {
+            allocs[i]++;
+            return;
+        }
+    }
+}
+
+extern "C" void* IRAM_ATTR
+__wrap_malloc(size_t size)
+{
+    count_alloc();
+    return __real_malloc(size);
+}
+
+extern "C" void* IRAM_ATTR
+__wrap_calloc(size_t n, size_t size)
+{
+    count_alloc();
+    return __real_calloc(n, size);
+}
+
+extern "C" void* IRAM_ATTR
+__wrap_realloc(void* ptr, size_t size)
+{
+    count_alloc();
+    return __real_realloc(ptr, size);
+}
+
+void
+heap_check_watch()
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    bool found = false;
+
+    portENTER_CRITICAL(&heap_mux);
+    for (size_t i = 0; i < HEAP_CHECK_TASKS && !found; i++) {
+        if (!watched[i]) {
+            allocs[i] = 0;
+            watched[i] = task;
+            found = true;
+        }
+    }
+    portEXIT_CRITICAL(&heap_mux);
+
+    if (!found)
+        log_w("Can't watch %s, already watching too many tasks", pcTaskGetName(task));
+}
+
+uint32_t
+heap_check_allocs()
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (size_t i = 0; i < HEAP_CHECK_TASKS; i++) {
+        if (watched[i] == task)
+            return allocs[i];
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,363 @@
+/**
+ * @file jobs.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Background storage jobs.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "jobs.hpp"
+
+#include "config.h"
+#include "recording.hpp"
+#include "storage.hpp"
+#include "tasks.hpp"
+
+#include <algorithm>
+#include <vector>
+
+/******************************************************************************/
+
+// Recent jobs, by ID % JOBS_HISTORY
+static job_t jobs[JOBS_HISTORY];
+
+// ID of the last job submitted
+static uint32_t last_job_id = 0;
+
+// Guards the job table, which the worker and the web server both touch
+static portMUX_TYPE jobs_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// IDs of the jobs waiting for the worker
+static QueueHandle_t jobs_queue = nullptr;
+
+/******************************************************************************/
+
+static const char*
+job_type_str(JobType type)
+{
+    switch (type) {
+        case JOB_DELETE:
+            return "delete";
+        case JOB_CLEAR:
+            return "clear";
+        case JOB_RETENTION:
+            return "retention";
+        default:
+            return "unknown";
+    }
+}
+
+static const char*
+job_state_str(JobState state)
+{
+    switch (state) {
+        case JOB_QUEUED:
+            return "queued";
+        case JOB_RUNNING:
+            return "running";
+        case JOB_DONE:
+            return "done";
+        case JOB_FAILED:
+            return "failed";
+        default:
+            return "unknown";
+    }
+}
+
+/**
+ * @brief Apply a change to a job's status.
+ */
+template <typename F>
+static void
+job_update(uint32_t id, F&& update)
+{
+    portENTER_CRITICAL(&jobs_mux);
+    auto& job = jobs[id % JOBS_HISTORY];
+    if (job.id == id)
+        update(job);
+    portEXIT_CRITICAL(&jobs_mux);
+}
+
+/**
+ * @brief Remove one recording as part of a job.
+ *
+ * Yields afterwards, so a long job never hogs the flash or the CPU.
+ *
+ * @param freed If given, set to how many bytes of storage were released.
+ * @return If the recording was removed.
+ */
+static bool
+job_remove(uint32_t id, const char* name, size_t* freed = nullptr)
+{
+    size_t released = 0;
+    bool removed = storage_remove(name, &released);
+    if (removed)
+        log_i("Removed recording %s (%u B freed)", name, released);
+    else
+        log_w("Could not remove recording %s", name);
+
+    job_update(id, [&](job_t& job) {
+        if (removed) {
+            job.removed++;
+            job.freed += released;
+        } else {
+            job.failed++;
+        }
+    });
+
+    vTaskDelay(1);
+
+    if (freed)
+        *freed = released;
+    return removed;
+}
+
+/**
+ * @brief A recording, as far as jobs care.
+ */
+struct job_rec_t {
+    String name;
+    size_t size;
+    uint32_t seq; // Creation order, 0 for recordings from before version 6
+};
+
+/**
+ * @brief List all recordings, oldest first.
+ *
+ * Names can't be used for this, since placeholder names ("boot-...") sort after
+ * timestamps. Recordings without a sequence number come first, by name.
+ */
+static bool
+job_list(std::vector<job_rec_t>& recs)
+{
+    bool success = storage_list([&recs](const char* name, size_t size) {
+        recs.push_back({String(name), size, 0});
+    });
+
+    for (auto& rec : recs) {
+        RecFile file = storage_open(rec.name.c_str());
+        rec_header_t header;
+        if (file && rec_read_header(file, &header))
+            rec.seq = header.seq;
+        file.close();
+    }
+
+    std::sort(recs.begin(), recs.end(), [](const job_rec_t& a, const job_rec_t& b) {
+        if (a.seq != b.seq)
+            return a.seq < b.seq;
+        return a.name < b.name;
+    });
+    return success;
+}
+
+static void
+job_run_delete(const job_t& job)
+{
+    RecFile file = storage_open(job.name);
+    if (!file) {
+        log_w("Recording %s not found", job.name);
+        job_update(job.id, [](job_t& job) { job.failed++; });
+        return;
+    }
+
+    file.close();
+    job_remove(job.id, job.name);
+}
+
+static void
+job_run_clear(const job_t& job)
+{
+    std::vector<job_rec_t> recs;
+    if (!job_list(recs))
+        job_update(job.id, [](job_t& job) { job.failed++; });
+
+    // One at a time, so the web server gets a turn in between
+    for (const auto& rec : recs)
+        job_remove(job.id, rec.name.c_str());
+}
+
+static void
+job_run_retention(const job_t& job)
+{
+    std::vector<job_rec_t> recs;
+    if (!job_list(recs)) {
+        job_update(job.id, [](job_t& job) { job.failed++; });
+        return;
+    }
+
+    size_t count = recs.size();
+    uint64_t total = 0;
+    for (const auto& rec : recs)
+        total += rec.size;
+
+    for (const auto& rec : recs) {
+        bool too_many = REC_KEEP_LAST && count > REC_KEEP_LAST;
+        bool too_big = REC_MAX_BYTES && total > REC_MAX_BYTES;
+        if (!too_many && !too_big)
+            break;
+
+        // Removal fails for the recording in progress, which is fine
+        size_t freed;
+        if (job_remove(job.id, rec.name.c_str(), &freed))
+            count--;
+        total -= min<uint64_t>(total, freed);
+    }
+}
+
+static void
+jobs_task(void*)
+{
+    uint32_t id;
+    while (true) {
+        if (xQueueReceive(jobs_queue, &id, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        job_t job;
+        bool found = false;
+        job_update(id, [&](job_t& j) {
+            j.state = JOB_RUNNING;
+            j.start_ms = millis();
+            job = j;
+            found = true;
+        });
+        if (!found) // Pushed out of the history already
+            continue;
+
+        log_i("Running %s job %lu", job_type_str(job.type), id);
+        uint32_t start = micros();
+        switch (job.type) {
+            case JOB_DELETE:
+                job_run_delete(job);
+                break;
+
+            case JOB_CLEAR:
+                job_run_clear(job);
+                break;
+
+            case JOB_RETENTION:
+                job_run_retention(job);
+                break;
+        }
+        tasks_busy(TASK_STORAGE, micros() - start);
+
+        job_update(id, [&](job_t& j) {
+            j.state = j.failed ? JOB_FAILED : JOB_DONE;
+            j.end_ms = millis();
+            job = j;
+        });
+        log_i(
+            "Finished %s job %lu: %u removed, %u failed, %lu B freed in %lu ms",
+            job_type_str(job.type), id, job.removed, job.failed, job.freed,
+            job.end_ms - job.start_ms
+        );
+    }
+}
+
+/******************************************************************************/
+
+StaticJsonDocument<256>
+job_t::to_json() const
+{
+    StaticJsonDocument<256> doc;
+
+    doc["id"] = id;
+    doc["type"] = job_type_str(type);
+    doc["state"] = job_state_str(state);
+    if (type == JOB_DELETE)
+        doc["name"] = name;
+    doc["removed"] = removed;
+    doc["failed"] = failed;
+    doc["freed"] = freed;
+    if (state == JOB_DONE || state == JOB_FAILED)
+        doc["ms"] = end_ms - start_ms;
+
+    return doc;
+}
+
+bool
+jobs_setup()
+{
+    jobs_queue = xQueueCreate(JOBS_QUEUE_LEN, sizeof(uint32_t));
+    if (!jobs_queue) {
+        log_e("Could not create the storage job queue");
+        return false;
+    }
+
+    TaskHandle_t task;
+    BaseType_t res = xTaskCreatePinnedToCore(
+        jobs_task, "storage", JOBS_TASK_STACK, nullptr, JOBS_TASK_PRIORITY, &task,
+        TASKS_IO_CORE
+    );
+    if (res != pdPASS) {
+        log_e("Could not start the storage worker");
+        return false;
+    }
+    tasks_register(TASK_STORAGE, task, jobs_queue);
+
+    // Catch up on anything recorded before the rules changed
+    if (REC_KEEP_LAST || REC_MAX_BYTES)
+        jobs_submit(JOB_RETENTION);
+
+    return true;
+}
+
+uint32_t
+jobs_submit(JobType type, const char* name)
+{
+    if (!jobs_queue)
+        return 0;
+
+    portENTER_CRITICAL(&jobs_mux);
+    uint32_t id = ++last_job_id;
+    auto& job = jobs[id % JOBS_HISTORY];
+
+    memset(&job, 0, sizeof(job));
+    job.id = id;
+    job.type = type;
+    job.state = JOB_QUEUED;
+    if (name)
+        strlcpy(job.name, name, sizeof(job.name));
+    portEXIT_CRITICAL(&jobs_mux);
+
+    if (!tasks_send(TASK_STORAGE, &id)) {
+        log_w("Storage job queue full, dropping %s job", job_type_str(type));
+        job_update(id, [](job_t& job) { job.id = 0; });
+        return 0;
+    }
+
+    log_d("Queued %s job %lu", job_type_str(type), id);
+    return id;
+}
+
+bool
+jobs_status(uint32_t id, job_t* job)
+{
+    bool found = false;
+    job_update(id, [&](job_t& j) {
+        *job = j;
+        found = true;
+    });
+    return found && id;
+}
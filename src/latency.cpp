@@ -0,0 +1,128 @@
+/**
+ * @file latency.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Tracing the latency of live samples.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "latency.hpp"
+
+#include "config.h"
+
+#include <Arduino.h>
+#include <algorithm>
+
+static const char* const STAGE_NAMES[LATENCY_STAGES] = {
+    "acquire", "queue", "encode", "send", "total",
+};
+
+static volatile bool tracing = false;
+
+// How long the last LATENCY_WINDOW samples spent in each stage (in us).
+// Written by the data task, read by the web server.
+static uint32_t window[LATENCY_WINDOW][LATENCY_STAGES];
+static uint32_t traced = 0;
+static portMUX_TYPE latency_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/******************************************************************************/
+
+StaticJsonDocument<512>
+latency_summary_t::to_json() const
+{
+    StaticJsonDocument<512> doc;
+    doc["enabled"] = enabled;
+    doc["count"] = count;
+
+    JsonObject stages_json = doc.createNestedObject("stages");
+    for (size_t i = 0; i < LATENCY_STAGES; i++) {
+        JsonObject stage = stages_json.createNestedObject(STAGE_NAMES[i]);
+        stage["p50"] = stages[i].p50_us;
+        stage["p95"] = stages[i].p95_us;
+        stage["max"] = stages[i].max_us;
+    }
+    return doc;
+}
+
+/******************************************************************************/
+
+void
+latency_enable(bool enabled)
+{
+    portENTER_CRITICAL(&latency_mux);
+    if (enabled && !tracing)
+        traced = 0;
+    tracing = enabled;
+    portEXIT_CRITICAL(&latency_mux);
+}
+
+bool
+latency_enabled()
+{
+    return tracing;
+}
+
+void
+latency_record(const latency_trace_t& trace)
+{
+    uint32_t stages[LATENCY_STAGES] = {
+        (uint32_t)(trace.decoded_us - trace.isr_us),
+        (uint32_t)(trace.dequeued_us - trace.decoded_us),
+        (uint32_t)(trace.encoded_us - trace.dequeued_us),
+        (uint32_t)(trace.sent_us - trace.encoded_us),
+        (uint32_t)(trace.sent_us - trace.isr_us),
+    };
+
+    portENTER_CRITICAL(&latency_mux);
+    memcpy(window[traced % LATENCY_WINDOW], stages, sizeof(stages));
+    traced++;
+    portEXIT_CRITICAL(&latency_mux);
+}
+
+void
+latency_summary(latency_summary_t* summary)
+{
+    // Only the web server asks for summaries, and this is too big for its stack
+    static uint32_t copy[LATENCY_WINDOW][LATENCY_STAGES];
+
+    portENTER_CRITICAL(&latency_mux);
+    memcpy(copy, window, sizeof(copy));
+    summary->enabled = tracing;
+    summary->count = traced;
+    portEXIT_CRITICAL(&latency_mux);
+
+    size_t n = min<uint32_t>(summary->count, LATENCY_WINDOW);
+    for (size_t stage = 0; stage < LATENCY_STAGES; stage++) {
+        uint32_t col[LATENCY_WINDOW];
+        for (size_t i = 0; i < n; i++)
+            col[i] = copy[i][stage];
+        std::sort(col, col + n);
+
+        auto& out = summary->stages[stage];
+        out.p50_us = n ? col[n / 2] : 0;
+        out.p95_us = n ? col[n * 95 / 100] : 0;
+        out.max_us = n ? col[n - 1] : 0;
+    }
+}
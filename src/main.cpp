@@ -1,8 +1,18 @@
+#include "bench.hpp"
+#include "boot.hpp"
 #include "config.h"
 #include "connections.hpp"
 #include "data.hpp"
+#include "heap.hpp"
+#include "jobs.hpp"
+#include "metrics.hpp"
 #include "mpu.hpp"
+#include "replay.hpp"
+#include "serialstream.hpp"
 #include "server.hpp"
+#include "storage.hpp"
+#include "tasks.hpp"
+#include "timesync.hpp"
 #include "utils.hpp"
 
 #include <Arduino.h>
@@ -14,9 +24,6 @@
 #include <pgmspace.h>
 #include <WiFi.h>
 
-// Store whether our LED is on or not so we can blink it
-bool blinkState = false;
-
 // Double reset detector
 DoubleResetDetector drd(DRD_TIMEOUT_SEC, EEPROM_ADDR_DRD);
 
@@ -72,120 +79,237 @@ print_chip_debug_info()
 }
 
 void
-setup()
+print_sse_clients()
 {
-    // Initialize serial communication
-    Serial.begin(115200);
-    Serial.setDebugOutput(true);
-    while (!Serial) // Wait for initialization
-        ;
-
-    // Initial log
-    print_chip_debug_info();
-
-    /*
-     * Initialize EEPROM
-     */
-    log_i("Initializing EEPROM..");
+    sse_client_stats_t stats[SSE_MAX_CLIENTS];
+    size_t len = web_server_sse_clients(stats, SSE_MAX_CLIENTS);
 
-    if (!EEPROM.begin(EEPROM_SIZE)) {
-        log_e("Error initializing EEPROM, rebooting in 3 seconds...");
-        delay(3000);
-        ESP.restart();
+    log_i(
+        "%u SSE clients, %lu evicted, %u queued on average", len,
+        web_server_sse_evicted(), web_server_sse_avg_queued()
+    );
+    for (size_t i = 0; i < len; i++) {
+        const auto& c = stats[i];
+        log_i(
+            "%15s: up %6lu s, %7lu sent, %6lu dropped, %2u/%2u queued, lag %5lu ms",
+            IPAddress(c.ip).toString().c_str(), c.connected / 1000, c.sent, c.dropped,
+            c.queued, c.max_queued, c.lag
+        );
     }
-    log_i("EEPROM initialized successfully");
+}
 
-    /*
-     * Check for a double reset.
-     */
-    bool wifi_reset = false;
-    if (drd.check()) {
-        log_i("Starting reconfiguration as double reset occurred");
-        wifi_reset = true;
+void
+print_tasks()
+{
+    task_stats_t stats[TASK_COUNT];
+    size_t len = tasks_stats(stats, TASK_COUNT);
+
+    for (size_t i = 0; i < len; i++) {
+        const auto& t = stats[i];
+        log_i(
+            "%12s: core %2d, prio %2u, cpu %5.1f%%, stack free %5lu B, %8lu runs, "
+            "queue %2u/%2u (max %2u), %lu dropped",
+            t.name, t.core, t.priority, t.cpu * 100, t.stack_free, t.runs, t.queued,
+            t.queue_len, t.max_queued, t.dropped
+        );
+#ifdef HEAP_CHECK
+        if (t.alloc_runs)
+            log_w("%12s: %lu runs allocated", t.name, t.alloc_runs);
+#endif
     }
+}
+
+/**
+ * @brief Bring up WiFi, mDNS, the web server, and the time, in the background.
+ *
+ * None of it is needed to sample, so it's kept out of setup(). Nothing here
+ * reboots, it keeps retrying instead.
+ *
+ * @param param If WiFi should be reconfigured, as a bool*.
+ */
+void
+network_task(void* param)
+{
+    bool wifi_reset = *static_cast<bool*>(param);
 
     /*
      * Connect to WiFi
      */
-    log_i("Attempting to connect to WiFi...");
+    size_t stage = boot_stage_begin("wifi");
 
-    if (!wifi_connect(wifi_reset)) {
-        log_e("WiFi connection failed, rebooting in 3 seconds...");
-        delay(3000);
-        ESP.restart();
+    while (!wifi_connect(wifi_reset)) {
+        log_w("WiFi connection failed, retrying...");
+        wifi_reset = false;
     }
-    log_i("Wifi successfully connected!");
+    boot_stage_end(stage);
     wifi_print_status();
 
+    bool ok;
 #ifdef USE_mDNS
     /*
      * Start mDNS
      */
-    log_i("Attempting to start mDNS responder");
+    stage = boot_stage_begin("mdns");
 
-    if (mdns_setup())
-        log_i("mDNS setup successfully");
-    else
+    ok = mdns_setup();
+    if (!ok)
         log_w("mDNS setup failed! Nice hostnames will not be available.");
+    boot_stage_end(stage, ok);
 #endif
 
+    /*
+     * Setup web server
+     */
+    stage = boot_stage_begin("web server");
+
+    ok = web_server_setup();
+    if (!ok)
+        log_e("Error starting web server! The dashboard will be unavailable.");
+    boot_stage_end(stage, ok);
+
     /*
      * Sync time
      */
-    log_i("Syncing time with NTP...");
+    stage = boot_stage_begin("ntp");
+    timesync_setup();
     configTime(
         NTP_GMT_OFFSET_SEC, NTP_DST_OFFSET_SEC, NTP_SERVER_1, NTP_SERVER_2, NTP_SERVER_3
     );
-    while (iso8601_str() == "") // Keep trying to get time
+
+    struct tm tm;
+    while (!getLocalTime(&tm, NTP_SYNC_TIMEOUT)) // Keep trying to get time
         log_w("Time sync failed, retrying...");
+    boot_stage_end(stage);
 
     log_i("Time synced successfully, current time: %s", iso8601_str().c_str());
+    data_time_synced();
+
+    vTaskDelete(nullptr);
+}
+
+void
+setup()
+{
+    // Initialize serial communication
+    Serial.setTxBufferSize(SERIAL_TX_BUFFER);
+    Serial.begin(SERIAL_BAUD);
+    Serial.setDebugOutput(true);
+    while (!Serial) // Wait for initialization
+        ;
+
+    // Initial log
+    print_chip_debug_info();
+
+    // setup() runs on the Arduino loop task
+    tasks_register(TASK_LOOP, xTaskGetCurrentTaskHandle());
+
+    /*
+     * Initialize EEPROM
+     */
+    size_t stage = boot_stage_begin("eeprom");
+
+    if (!EEPROM.begin(EEPROM_SIZE)) {
+        log_e("Error initializing EEPROM, rebooting in 3 seconds...");
+        delay(3000);
+        ESP.restart();
+    }
+    boot_stage_end(stage);
+
+    /*
+     * Check for a double reset.
+     */
+    static bool wifi_reset = false;
+    if (drd.check()) {
+        log_i("Starting reconfiguration as double reset occurred");
+        wifi_reset = true;
+    }
 
     /*
      * Initialize LittleFS
      */
-    log_i("Mounting LittleFS...");
+    stage = boot_stage_begin("littlefs");
 
     if (!LittleFS.begin()) {
         log_e("Error mounting LittleFS, rebooting in 3 seconds...");
         delay(3000);
         ESP.restart();
     }
-    log_i("LittleFS mounted successfully!");
+    boot_stage_end(stage);
     log_d(
         "Used LittleFS space: %lu B/%lu B", LittleFS.usedBytes(), LittleFS.totalBytes()
     );
 
     /*
-     * Setup web server
+     * Setup recording storage
      */
-    log_i("Starting web server...");
+    stage = boot_stage_begin("storage");
 
-    if (!web_server_setup()) {
-        log_e("Error starting web server, rebooting in 3 seconds...");
+    if (!data_setup()) {
+        log_e("Error setting up data processing, rebooting in 3 seconds...");
+        delay(3000);
+        ESP.restart();
+    }
+
+    bool ok = storage_setup();
+    if (!ok)
+        log_w("Recording storage setup failed! Recordings may be unavailable.");
+
+    if (!jobs_setup())
+        log_w("Storage worker setup failed! Recordings cannot be deleted.");
+
+    if (!replay_setup())
+        log_w("Replay setup failed! Recordings cannot be replayed.");
+    boot_stage_end(stage, ok);
+
+    /*
+     * Bring up the network while the MPU calibrates
+     */
+    if (xTaskCreatePinnedToCore(
+            network_task, "network", BOOT_NET_TASK_STACK, &wifi_reset, 1, nullptr,
+            TASKS_IO_CORE
+        ) != pdPASS) {
+        log_e("Error starting the network task, rebooting in 3 seconds...");
         delay(3000);
         ESP.restart();
     }
-    log_i("Web server started successfully");
 
 #ifndef TEST_WEBSERVER
     /*
      * Configure the MPU6050
      */
-    log_i("Starting MPU6050 setup...");
+    stage = boot_stage_begin("mpu");
 
     if (!mpu_setup()) {
         log_e("MPU6050 setup failed, rebooting in 3 seconds...");
         delay(3000);
         ESP.restart();
     }
-    log_i("MPU6050 setup completed successfully!");
+    boot_stage_end(stage);
 #endif
 
     // configure LED for output
     pinMode(LED_PIN, OUTPUT);
     digitalWrite(LED_PIN, HIGH);
 
+    /*
+     * Start sampling
+     */
+    stage = boot_stage_begin("tasks");
+
+    if (!tasks_setup()) {
+        log_e("Error starting tasks, rebooting in 3 seconds...");
+        delay(3000);
+        ESP.restart();
+    }
+    boot_stage_end(stage);
+
+    log_i("Sampling started %lu ms after boot", millis());
+
+#if BOOT_RECORD_MS
+    // Named once the time is synced
+    data_start_recording(BOOT_RECORD_MS);
+#endif
+
     log_i("Setup completed successfully!");
 }
 
@@ -196,10 +320,28 @@ setup()
 void
 loop()
 {
+    uint32_t start = micros();
+
     // Check for serial input
-    if (Serial.available()) {
+    if (Serial.available() && serialstream_active()) {
+        // Keep the port clean while streaming, only listen for the stop command
+        if (Serial.read() == SERIALSTREAM_STOP)
+            serialstream_stop();
+    } else if (Serial.available()) {
         char cmd;
         switch (cmd = Serial.read()) {
+            case 'B':
+                serialstream_start();
+                break;
+
+            case 'b':
+                if (data_is_recording()) {
+                    log_w("Cannot benchmark while recording");
+                    break;
+                }
+                bench_storage();
+                break;
+
             case 'c':
                 log_i("Clearing WiFi settings and rebooting in 3 seconds!");
                 delay(3000);
@@ -209,22 +351,48 @@ loop()
 
             case 'C':
                 log_i("Clearing recordings");
-                data_clear_recordings();
+                jobs_submit(JOB_CLEAR);
                 break;
 
             case 'd':
                 print_chip_debug_info();
+                boot_print_report();
+                heap_print_report();
+                break;
+
+            case 'e':
+                if (data_is_recording()) {
+                    log_w("Cannot benchmark while recording");
+                    break;
+                }
+                bench_export();
                 break;
 
             case 'h':
-                Serial.println("Commands: (c)lear wifi settings, (C)lear recordings, "
-                               "(d)ebug info, start (r)ecroding, (R)estart, (h)elp");
+                Serial.println("Commands: (b)enchmark storage, "
+                               "(B)inary streaming, (c)lear wifi settings, "
+                               "(C)lear recordings, (d)ebug info, (e)xport benchmark, "
+                               "recalibrate the (m)pu, start (r)ecroding, (R)estart, "
+                               "(s)treaming clients, (t)ask stats, (h)elp");
+                break;
+
+            case 'm':
+                log_i("Recalibrating the MPU6050, keep it still!");
+                mpu_request_calibration();
                 break;
 
             case 'r':
                 data_start_recording(15000);
                 break;
 
+            case 's':
+                print_sse_clients();
+                break;
+
+            case 't':
+                print_tasks();
+                break;
+
             case 'R':
                 log_i("Restaring..");
                 delay(500);
@@ -240,72 +408,12 @@ loop()
     // Run the DRD loop
     drd.loop();
 
-    /*
-     * Gather data
-     */
-    mpu_data_t mpu_data;
-
-#ifdef TEST_WEBSERVER
-    JsonArray accelReal = doc.createNestedArray("accel");
-    accelReal.add((double)esp_random());
-    accelReal.add((double)esp_random());
-    accelReal.add((double)esp_random());
+    metrics_loop();
+    tasks_loop();
+    heap_loop();
 
-    JsonArray ypr = doc.createNestedArray("ypr");
-    ypr.add((double)esp_random());
-    ypr.add((double)esp_random());
-    ypr.add((double)esp_random());
+    tasks_busy(TASK_LOOP, micros() - start);
 
-    doc["temp"] = 65.6;
-
-    web_server_send_event("mpuData", doc);
-
-    delay(1000);
-#else
-    static unsigned long poll_miss_count = 0;
-
-    // if programming failed, don't try to do anything
-    if (!dmp_ready)
-        return;
-
-    // read a packet from FIFO
-    if (mpu_data_available()) { // Get the Latest packet
-        // Set timestamp ASAP
-        mpu_data.time = millis();
-
-        // Get yaw, pitch, and roll
-        mpu_get_ypr(mpu_data.ypr);
-
-        // Get real acceleration (i.e., no gravity)
-        mpu_get_real_accel(&mpu_data.accel);
-
-        // Get gyroscope reading
-        mpu_get_gyro(&mpu_data.gyro);
-
-        // Send off the data to be processed
-        data_process_measurement(mpu_data);
-
-        static auto last_sample_time = 0;
-        auto cur_time = millis();
-        auto sample_time = cur_time - last_sample_time;
-        last_sample_time = cur_time;
-
-        // log_d("Sample time: %lu ms", sample_time);
-        // log_d("Poll misses: %lu", poll_miss_count);
-
-        // blink LED to indicate activity
-        blinkState = !blinkState;
-        digitalWrite(LED_PIN, blinkState);
-
-        poll_miss_count = 0;
-
-#  if MPU_SAMPLE_RATE > 70   // We overflow the FIFO buffer and need to compensate
-        delay(MPU_SAMPLE_RATE - 12);
-#  elif MPU_SAMPLE_RATE > 10 // Default sample rate is 10ms
-        delay(MPU_SAMPLE_RATE - 2);
-#  endif
-    } else {
-        poll_miss_count++;
-    }
-#endif
+    // Sampling happens on its own task, so nothing here is in a hurry
+    delay(LOOP_INTERVAL);
 }
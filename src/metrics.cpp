@@ -0,0 +1,530 @@
+/**
+ * @file metrics.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Runtime performance counters.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "metrics.hpp"
+
+#include <IPAddress.h>
+#include <LittleFS.h>
+
+// Prefix of every metric name
+#define METRICS_PREFIX "swimstats_"
+
+static const uint32_t write_buckets[] = METRICS_WRITE_BUCKETS;
+
+static_assert(
+    sizeof(write_buckets) / sizeof(*write_buckets) == METRICS_WRITE_BUCKETS_LEN,
+    "METRICS_WRITE_BUCKETS_LEN must match METRICS_WRITE_BUCKETS"
+);
+
+// Counters, each only written by one task
+static metrics_t counters = {};
+static uint32_t last_sample_ms = 0;
+
+// Rate window
+static uint32_t window_start_ms = 0;
+static uint32_t window_loops = 0;
+static uint32_t window_samples = 0;
+
+// The network counters are updated from the async_tcp task too
+static portMUX_TYPE metrics_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/******************************************************************************/
+
+void
+metrics_loop()
+{
+    counters.loops++;
+
+    uint32_t now = millis();
+    uint32_t elapsed = now - window_start_ms;
+    if (elapsed >= 1000) {
+        counters.loop_rate = (counters.loops - window_loops) * 1000.0f / elapsed;
+        counters.sample_rate = (counters.samples - window_samples) * 1000.0f / elapsed;
+
+        window_start_ms = now;
+        window_loops = counters.loops;
+        window_samples = counters.samples;
+    }
+}
+
+void
+metrics_sample(uint32_t time)
+{
+    counters.samples++;
+
+    // The DMP only keeps the latest packet, so anything in between is lost
+    if (last_sample_ms && time > last_sample_ms + MPU_SAMPLE_RATE * 3 / 2) {
+        uint32_t gap = time - last_sample_ms;
+        counters.dropped += (gap + MPU_SAMPLE_RATE / 2) / MPU_SAMPLE_RATE - 1;
+    }
+    last_sample_ms = time;
+}
+
+void
+metrics_rec_write(uint32_t us)
+{
+    size_t i = 0;
+    while (i < METRICS_WRITE_BUCKETS_LEN && us > write_buckets[i])
+        i++;
+
+    counters.write_buckets[i]++;
+    counters.write_count++;
+    counters.write_sum_us += us;
+}
+
+void
+metrics_bytes_sent(MetricsChannel channel, size_t len)
+{
+    portENTER_CRITICAL(&metrics_mux);
+    counters.bytes_sent[channel] += len;
+    portEXIT_CRITICAL(&metrics_mux);
+}
+
+void
+metrics_get(metrics_t* metrics)
+{
+    portENTER_CRITICAL(&metrics_mux);
+    *metrics = counters;
+    portEXIT_CRITICAL(&metrics_mux);
+
+    metrics->uptime_ms = millis();
+    metrics->sse_evicted = web_server_sse_evicted();
+
+    metrics->heap_free = ESP.getFreeHeap();
+    metrics->heap_max_alloc = ESP.getMaxAllocHeap();
+    metrics->heap_min_free = ESP.getMinFreeHeap();
+    metrics->fs_used = LittleFS.usedBytes();
+    metrics->fs_total = LittleFS.totalBytes();
+
+    metrics->num_tasks = tasks_stats(metrics->tasks, TASK_COUNT);
+}
+
+/******************************************************************************/
+
+/**
+ * @brief Metric families, in the order they're written.
+ */
+enum {
+    FAMILY_UPTIME,
+    FAMILY_LOOPS,
+    FAMILY_LOOP_RATE,
+    FAMILY_SAMPLES,
+    FAMILY_DROPPED,
+    FAMILY_SAMPLE_RATE,
+    FAMILY_BYTES_SENT,
+    FAMILY_SSE_CLIENTS,
+    FAMILY_SSE_EVICTED,
+    FAMILY_SSE_QUEUED,
+    FAMILY_SSE_SENT,
+    FAMILY_SSE_DROPPED,
+    FAMILY_SSE_LAG,
+    FAMILY_REC_WRITE,
+    FAMILY_FS_USED,
+    FAMILY_FS_TOTAL,
+    FAMILY_HEAP_FREE,
+    FAMILY_HEAP_MAX_ALLOC,
+    FAMILY_HEAP_MIN_FREE,
+    FAMILY_TASK_CPU,
+    FAMILY_STACK_FREE,
+    FAMILY_TASK_QUEUED,
+    FAMILY_TASK_DROPPED,
+    FAMILY_DONE,
+};
+
+/**
+ * @brief Write the HELP and TYPE lines of a metric.
+ */
+static size_t
+family_header(char* buf, const char* name, const char* type, const char* help)
+{
+    return snprintf(
+        buf, METRICS_LINE_SIZE,
+        "# HELP " METRICS_PREFIX "%s %s\n"
+        "# TYPE " METRICS_PREFIX "%s %s\n",
+        name, help, name, type
+    );
+}
+
+/**
+ * @brief Write a metric with a single, unlabeled value.
+ */
+static size_t
+family_value(
+    char* buf, const char* name, const char* type, const char* help, double value
+)
+{
+    size_t len = family_header(buf, name, type, help);
+    return len
+           + snprintf(
+               buf + len, METRICS_LINE_SIZE - len, METRICS_PREFIX "%s %.10g\n", name,
+               value
+           );
+}
+
+/**
+ * @brief If a metric family has more than one value (or labels).
+ */
+static bool
+family_has_labels(uint8_t family)
+{
+    switch (family) {
+        case FAMILY_BYTES_SENT:
+        case FAMILY_SSE_QUEUED:
+        case FAMILY_SSE_SENT:
+        case FAMILY_SSE_DROPPED:
+        case FAMILY_SSE_LAG:
+        case FAMILY_REC_WRITE:
+        case FAMILY_TASK_CPU:
+        case FAMILY_STACK_FREE:
+        case FAMILY_TASK_QUEUED:
+        case FAMILY_TASK_DROPPED:
+            return true;
+        default:
+            return false;
+    }
+}
+
+size_t
+MetricsWriter::step_(char* buf)
+{
+    const auto& m = metrics_;
+
+    // Families without labels are written in one go
+    if (idx_ && !family_has_labels(family_))
+        return 0;
+
+    // Families with a line per live data client
+    const sse_client_stats_t* client =
+        idx_ && idx_ <= num_clients_ ? &clients_[idx_ - 1] : nullptr;
+
+    // Families with a line per task
+    const task_stats_t* task =
+        idx_ && idx_ <= m.num_tasks ? &m.tasks[idx_ - 1] : nullptr;
+
+    switch (family_) {
+        case FAMILY_UPTIME:
+            return family_value(
+                buf, "uptime_seconds", "gauge", "Time since boot.", m.uptime_ms / 1e3
+            );
+        case FAMILY_LOOPS:
+            return family_value(
+                buf, "loop_iterations_total", "counter", "Main loop iterations.",
+                m.loops
+            );
+        case FAMILY_LOOP_RATE:
+            return family_value(
+                buf, "loop_rate_hz", "gauge", "Main loop iterations per second.",
+                m.loop_rate
+            );
+        case FAMILY_SAMPLES:
+            return family_value(
+                buf, "samples_acquired_total", "counter", "Samples read from the MPU.",
+                m.samples
+            );
+        case FAMILY_DROPPED:
+            return family_value(
+                buf, "samples_dropped_total", "counter",
+                "Samples missed, from gaps in the sample times.", m.dropped
+            );
+        case FAMILY_SAMPLE_RATE:
+            return family_value(
+                buf, "sample_rate_hz", "gauge", "Samples read per second.",
+                m.sample_rate
+            );
+
+        case FAMILY_BYTES_SENT:
+            if (idx_ == 0)
+                return family_header(
+                    buf, "bytes_sent_total", "counter", "Bytes sent to clients."
+                );
+            if (idx_ == 1)
+                return snprintf(
+                    buf, METRICS_LINE_SIZE,
+                    METRICS_PREFIX "bytes_sent_total{channel=\"events\"} %lu\n"
+                    METRICS_PREFIX "bytes_sent_total{channel=\"exports\"} %lu\n",
+                    m.bytes_sent[METRICS_EVENTS], m.bytes_sent[METRICS_EXPORTS]
+                );
+            return 0;
+
+        case FAMILY_SSE_CLIENTS:
+            return family_value(
+                buf, "sse_clients", "gauge", "Connected live data clients.",
+                num_clients_
+            );
+        case FAMILY_SSE_EVICTED:
+            return family_value(
+                buf, "sse_evicted_total", "counter",
+                "Live data clients disconnected for falling behind.", m.sse_evicted
+            );
+
+        case FAMILY_SSE_QUEUED:
+            if (!idx_)
+                return family_header(
+                    buf, "sse_queued", "gauge", "Events waiting to be sent, per client."
+                );
+            if (client)
+                return snprintf(
+                    buf, METRICS_LINE_SIZE, METRICS_PREFIX "sse_queued{ip=\"%s\"} %u\n",
+                    IPAddress(client->ip).toString().c_str(), client->queued
+                );
+            return 0;
+
+        case FAMILY_SSE_SENT:
+            if (!idx_)
+                return family_header(
+                    buf, "sse_sent_total", "counter", "Events sent, per client."
+                );
+            if (client)
+                return snprintf(
+                    buf, METRICS_LINE_SIZE,
+                    METRICS_PREFIX "sse_sent_total{ip=\"%s\"} %lu\n",
+                    IPAddress(client->ip).toString().c_str(), client->sent
+                );
+            return 0;
+
+        case FAMILY_SSE_DROPPED:
+            if (!idx_)
+                return family_header(
+                    buf, "sse_dropped_total", "counter",
+                    "Events dropped because the queue was full, per client."
+                );
+            if (client)
+                return snprintf(
+                    buf, METRICS_LINE_SIZE,
+                    METRICS_PREFIX "sse_dropped_total{ip=\"%s\"} %lu\n",
+                    IPAddress(client->ip).toString().c_str(), client->dropped
+                );
+            return 0;
+
+        case FAMILY_SSE_LAG:
+            if (!idx_)
+                return family_header(
+                    buf, "sse_lag_seconds", "gauge",
+                    "Time since the queue was last empty, per client."
+                );
+            if (client)
+                return snprintf(
+                    buf, METRICS_LINE_SIZE,
+                    METRICS_PREFIX "sse_lag_seconds{ip=\"%s\"} %.3f\n",
+                    IPAddress(client->ip).toString().c_str(), client->lag / 1e3
+                );
+            return 0;
+
+        case FAMILY_REC_WRITE:
+            if (idx_ == 0)
+                return family_header(
+                    buf, "rec_write_seconds", "histogram",
+                    "Time taken to write a sample to a recording."
+                );
+            if (idx_ <= METRICS_WRITE_BUCKETS_LEN + 1) {
+                // Buckets are cumulative
+                uint32_t count = 0;
+                for (size_t i = 0; i < idx_; i++)
+                    count += m.write_buckets[i];
+
+                if (idx_ <= METRICS_WRITE_BUCKETS_LEN)
+                    return snprintf(
+                        buf, METRICS_LINE_SIZE,
+                        METRICS_PREFIX "rec_write_seconds_bucket{le=\"%g\"} %lu\n",
+                        write_buckets[idx_ - 1] / 1e6, count
+                    );
+                return snprintf(
+                    buf, METRICS_LINE_SIZE,
+                    METRICS_PREFIX "rec_write_seconds_bucket{le=\"+Inf\"} %lu\n"
+                    METRICS_PREFIX "rec_write_seconds_sum %.6f\n"
+                    METRICS_PREFIX "rec_write_seconds_count %lu\n",
+                    count, m.write_sum_us / 1e6, m.write_count
+                );
+            }
+            return 0;
+
+        case FAMILY_FS_USED:
+            return family_value(
+                buf, "littlefs_used_bytes", "gauge", "Space used on LittleFS.",
+                m.fs_used
+            );
+        case FAMILY_FS_TOTAL:
+            return family_value(
+                buf, "littlefs_total_bytes", "gauge", "Size of LittleFS.", m.fs_total
+            );
+        case FAMILY_HEAP_FREE:
+            return family_value(
+                buf, "heap_free_bytes", "gauge", "Free heap.", m.heap_free
+            );
+        case FAMILY_HEAP_MAX_ALLOC:
+            return family_value(
+                buf, "heap_largest_block_bytes", "gauge",
+                "Largest block that can be allocated.", m.heap_max_alloc
+            );
+        case FAMILY_HEAP_MIN_FREE:
+            return family_value(
+                buf, "heap_min_free_bytes", "gauge", "Lowest free heap since boot.",
+                m.heap_min_free
+            );
+
+        case FAMILY_TASK_CPU:
+            if (!idx_)
+                return family_header(
+                    buf, "task_cpu_ratio", "gauge",
+                    "Share of a core spent working over the last window, per task."
+                );
+
+            // Skip tasks that aren't measured
+            while (task && task->cpu < 0)
+                task = next_task_();
+            if (task)
+                return snprintf(
+                    buf, METRICS_LINE_SIZE,
+                    METRICS_PREFIX "task_cpu_ratio{task=\"%s\"} %.4f\n", task->name,
+                    task->cpu
+                );
+            return 0;
+
+        case FAMILY_STACK_FREE:
+            if (!idx_)
+                return family_header(
+                    buf, "task_stack_free_bytes", "gauge",
+                    "Least free stack space since the task started."
+                );
+            if (task)
+                return snprintf(
+                    buf, METRICS_LINE_SIZE,
+                    METRICS_PREFIX "task_stack_free_bytes{task=\"%s\"} %lu\n",
+                    task->name, task->stack_free
+                );
+            return 0;
+
+        case FAMILY_TASK_QUEUED:
+            if (!idx_)
+                return family_header(
+                    buf, "task_queue_depth", "gauge",
+                    "Items waiting for the task, per task with a queue."
+                );
+
+            // Skip tasks without a queue
+            while (task && !task->queue_len)
+                task = next_task_();
+            if (task)
+                return snprintf(
+                    buf, METRICS_LINE_SIZE,
+                    METRICS_PREFIX "task_queue_depth{task=\"%s\"} %u\n", task->name,
+                    task->queued
+                );
+            return 0;
+
+        case FAMILY_TASK_DROPPED:
+            if (!idx_)
+                return family_header(
+                    buf, "task_queue_dropped_total", "counter",
+                    "Items dropped because the queue was full, per task with a queue."
+                );
+
+            while (task && !task->queue_len)
+                task = next_task_();
+            if (task)
+                return snprintf(
+                    buf, METRICS_LINE_SIZE,
+                    METRICS_PREFIX "task_queue_dropped_total{task=\"%s\"} %lu\n",
+                    task->name, task->dropped
+                );
+            return 0;
+
+        default:
+            return 0;
+    }
+}
+
+const task_stats_t*
+MetricsWriter::next_task_()
+{
+    idx_++;
+    return idx_ <= metrics_.num_tasks ? &metrics_.tasks[idx_ - 1] : nullptr;
+}
+
+size_t
+MetricsWriter::next_(char* buf)
+{
+    while (family_ < FAMILY_DONE) {
+        size_t len = step_(buf);
+        if (len) {
+            idx_++;
+            return len;
+        }
+
+        // Done with this one
+        family_++;
+        idx_ = 0;
+    }
+    return 0;
+}
+
+void
+MetricsWriter::begin()
+{
+    metrics_get(&metrics_);
+    num_clients_ = web_server_sse_clients(clients_, SSE_MAX_CLIENTS);
+
+    carry_len_ = carry_pos_ = 0;
+    family_ = idx_ = 0;
+}
+
+size_t
+MetricsWriter::fill(uint8_t* buf, size_t max_len)
+{
+    size_t written = 0;
+
+    while (written < max_len) {
+        // Send whatever didn't fit last time first
+        if (carry_pos_ < carry_len_) {
+            size_t len = min(max_len - written, carry_len_ - carry_pos_);
+            memcpy(buf + written, carry_ + carry_pos_, len);
+            carry_pos_ += len;
+            written += len;
+            continue;
+        }
+
+        // Skip the copy when there's definitely room
+        char* out = reinterpret_cast<char*>(buf + written);
+        if (max_len - written >= METRICS_LINE_SIZE) {
+            size_t len = next_(out);
+            if (!len)
+                break;
+            written += len;
+            continue;
+        }
+
+        carry_len_ = next_(carry_);
+        carry_pos_ = 0;
+        if (!carry_len_)
+            break;
+    }
+
+    return written;
+}
@@ -33,10 +33,14 @@
  */
 #include "mpu.hpp"
 
+#include "calib.hpp"
 #include "config.h"
+#include "mpumath.hpp"
+#include "serialstream.hpp"
 
 #include <Arduino.h>
 #include <I2Cdev.h>
+#include <esp_timer.h>
 #include <MPU6050_6Axis_MotionApps612.h>
 #include <Wire.h>
 
@@ -50,6 +54,13 @@ uint16_t packet_size;    // expected DMP packet size (default is 42 bytes)
 uint16_t fifo_count;     // count of all bytes currently in FIFO
 uint8_t fifo_buffer[64]; // FIFO storage buffer
 
+// Offsets in use, read by the web server while the sampling task updates them
+static mpu_calib_t calib_state;
+static portMUX_TYPE calib_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Set to calibrate on the next sample
+static volatile bool calib_requested = false;
+
 // ================================================================
 // ===               INTERRUPT DETECTION ROUTINE                ===
 // ================================================================
@@ -57,10 +68,182 @@ uint8_t fifo_buffer[64]; // FIFO storage buffer
 // indicates whether MPU interrupt pin has gone high
 volatile bool mpu_interrupt = false;
 
+// Given on every interrupt, so the reader can sleep between packets
+static SemaphoreHandle_t mpu_data_sem = nullptr;
+
+// When the last packet was ready (in us since boot), and when the one in
+// fifo_buffer was
+static int64_t isr_us = 0;
+static int64_t packet_us = 0;
+static portMUX_TYPE isr_mux = portMUX_INITIALIZER_UNLOCKED;
+
 void IRAM_ATTR
 dmp_data_ready_isr()
 {
     mpu_interrupt = true;
+
+    // 64-bit writes aren't atomic
+    portENTER_CRITICAL_ISR(&isr_mux);
+    isr_us = esp_timer_get_time();
+    portEXIT_CRITICAL_ISR(&isr_mux);
+
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(mpu_data_sem, &woken);
+    if (woken)
+        portYIELD_FROM_ISR();
+}
+
+// ================================================================
+// ===                       CALIBRATION                        ===
+// ================================================================
+
+/**
+ * @brief Load offsets into the MPU6050.
+ *
+ * @param calib The offsets.
+ * @param band The band they're from.
+ */
+static void
+apply_offsets(const calib_t& calib, int band)
+{
+    mpu.setXAccelOffset(calib.accel[0]);
+    mpu.setYAccelOffset(calib.accel[1]);
+    mpu.setZAccelOffset(calib.accel[2]);
+    mpu.setXGyroOffset(calib.gyro[0]);
+    mpu.setYGyroOffset(calib.gyro[1]);
+    mpu.setZGyroOffset(calib.gyro[2]);
+
+    portENTER_CRITICAL(&calib_mux);
+    calib_state.offsets = calib;
+    calib_state.band = band;
+    portEXIT_CRITICAL(&calib_mux);
+}
+
+/**
+ * @brief Calibrate the MPU6050, and store the offsets for the current
+ * temperature.
+ *
+ * Takes a few seconds, and the MPU6050 has to be held still.
+ */
+static void
+calibrate()
+{
+    log_i("Calibrating DMP...");
+    uint32_t start = millis();
+
+    mpu.CalibrateAccel();
+    mpu.CalibrateGyro();
+    log_d("Calibration loops done"); // Ends the library's progress line
+
+    int16_t* offsets = mpu.GetActiveOffsets();
+    log_d("DMP Offsets:");
+    log_d(
+        "Accel:\t%.5f,\t%.5f,\t%.5f", (float)offsets[0], (float)offsets[1],
+        (float)offsets[2]
+    );
+    log_d(
+        "Gyro:\t%.5f,\t%.5f,\t%.5f", (float)offsets[3], (float)offsets[4],
+        (float)offsets[5]
+    );
+
+    calib_t calib;
+    memcpy(calib.accel, offsets, sizeof(calib.accel));
+    memcpy(calib.gyro, offsets + 3, sizeof(calib.gyro));
+    calib.temp = mpu_get_temp();
+
+    struct tm tm;
+    calib.time = getLocalTime(&tm, 0) ? time(nullptr) : 0;
+
+    size_t band = calib_band(calib.temp);
+    if (calib_store(calib))
+        log_i("Stored offsets for %.1f °C (band %u)", calib.temp, band);
+
+    portENTER_CRITICAL(&calib_mux);
+    calib_state.offsets = calib;
+    calib_state.band = band;
+    calib_state.temp = calib.temp;
+    calib_state.temp_band = band;
+    portEXIT_CRITICAL(&calib_mux);
+
+    log_i("Calibrated in %lu ms", millis() - start);
+}
+
+void
+mpu_calibration_loop(const VectorFloat& accel, const VectorFloat& gyro, bool recording)
+{
+    static uint32_t moved_ms = 0;
+    static uint32_t temp_checked_ms = 0;
+    uint32_t now = millis();
+
+    // Track how long we've been still
+    float accel_sq = accel.x * accel.x + accel.y * accel.y + accel.z * accel.z;
+    if (fabsf(gyro.x) > CALIB_STILL_DPS || fabsf(gyro.y) > CALIB_STILL_DPS
+        || fabsf(gyro.z) > CALIB_STILL_DPS
+        || accel_sq > CALIB_STILL_ACCEL * CALIB_STILL_ACCEL)
+        moved_ms = now;
+
+    // Switch offsets when the temperature changes bands
+    if (now - temp_checked_ms >= CALIB_TEMP_INTERVAL) {
+        temp_checked_ms = now;
+
+        float temp = mpu_get_temp();
+        size_t band = calib_band(temp);
+
+        portENTER_CRITICAL(&calib_mux);
+        size_t prev_band = calib_state.temp_band;
+        int cur_band = calib_state.band;
+        calib_state.temp = temp;
+        calib_state.temp_band = band;
+        portEXIT_CRITICAL(&calib_mux);
+
+        if (band != prev_band) {
+            calib_t calib;
+            int found = calib_find(temp, &calib);
+            if (found >= 0 && found != cur_band) {
+                log_i("Now %.1f °C, using the offsets from band %d", temp, found);
+                apply_offsets(calib, found);
+            }
+        }
+    }
+
+    portENTER_CRITICAL(&calib_mux);
+    bool pending = calib_state.band != (int)calib_state.temp_band;
+    portEXIT_CRITICAL(&calib_mux);
+
+    if (calib_requested) {
+        // The library prints its progress to Serial, which would corrupt the
+        // frames, so wait until streaming stops
+        if (serialstream_active())
+            return;
+        if (recording)
+            log_w("Calibrating while recording, samples will be dropped");
+    } else if (!pending || recording || now - moved_ms < CALIB_STILL_MS) {
+        return;
+    } else {
+        log_i("Still with no offsets for this temperature");
+    }
+
+    calib_requested = false;
+    calibrate();
+
+    // Throw out what piled up while calibrating
+    mpu.resetFIFO();
+    moved_ms = millis();
+}
+
+void
+mpu_request_calibration()
+{
+    calib_requested = true;
+}
+
+void
+mpu_get_calibration(mpu_calib_t* calib)
+{
+    portENTER_CRITICAL(&calib_mux);
+    *calib = calib_state;
+    calib->requested = calib_requested;
+    portEXIT_CRITICAL(&calib_mux);
 }
 
 // ================================================================
@@ -110,27 +293,40 @@ mpu_setup()
         return false;
     }
 
-    // Calibration Time: generate offsets and calibrate our MPU6050
-    log_i("Calibrating DMP...");
-    mpu.CalibrateAccel();
-    mpu.CalibrateGyro();
-    Serial.println();
-
-    int16_t* offsets = mpu.GetActiveOffsets();
-    log_d("DMP Offsets:");
-    log_d(
-        "Accel:\t%.5f,\t%.5f,\t%.5f", (float)offsets[0], (float)offsets[1],
-        (float)offsets[2]
-    );
-    log_d(
-        "Gyro:\t%.5f,\t%.5f,\t%.5f", (float)offsets[3], (float)offsets[4],
-        (float)offsets[5]
-    );
+    // Use the stored offsets, so we don't have to hold still at every boot
+    if (!calib_setup())
+        log_w("Calibration table unavailable! Calibrating at every boot.");
+
+    float temp = mpu_get_temp();
+    size_t band = calib_band(temp);
+    calib_t calib;
+    int found = calib_find(temp, &calib);
+
+    portENTER_CRITICAL(&calib_mux);
+    calib_state.temp = temp;
+    calib_state.temp_band = band;
+    portEXIT_CRITICAL(&calib_mux);
+
+    if (found >= 0) {
+        log_i("Using offsets from %.1f °C at %.1f °C", calib.temp, temp);
+        apply_offsets(calib, found);
+        if (found != (int)band)
+            log_w("No offsets for this temperature yet, calibrating once still");
+    } else {
+        log_w("No stored offsets, calibrating now. Keep the tracker still!");
+        calibrate();
+    }
 
     // turn on the DMP, now that it's ready
     log_i("Enabling DMP...");
     mpu.setDMPEnabled(true);
 
+    mpu_data_sem = xSemaphoreCreateBinary();
+    if (!mpu_data_sem) {
+        log_e("Could not create the data ready semaphore");
+        return false;
+    }
+
     // enable Arduino interrupt detection
     log_i(
         "Enabling interrupt detection (ESP32 external interrupt %d)...",
@@ -154,32 +350,31 @@ mpu_setup()
 bool
 mpu_data_available()
 {
-    return mpu.dmpGetCurrentFIFOPacket(fifo_buffer);
+    // We read the newest packet in the FIFO, which is the one the last interrupt
+    // was for. If another lands mid-read, we can be a packet off, but reads are
+    // short next to the sample period.
+    portENTER_CRITICAL(&isr_mux);
+    int64_t ready_us = isr_us;
+    portEXIT_CRITICAL(&isr_mux);
+
+    if (!mpu.dmpGetCurrentFIFOPacket(fifo_buffer))
+        return false;
+
+    // No interrupt yet, the best we can do is now
+    packet_us = ready_us ? ready_us : esp_timer_get_time();
+    return true;
+}
+
+int64_t
+mpu_packet_time()
+{
+    return packet_us;
 }
 
-/**
- * @brief Get the linear acceleration from the raw acceleration and gravity.
- *
- * Adapted from MPU6050::dmpGetLinearAccel, which uses the wrong multiplier for
- * gravity (8192 instead of 16384).
- *
- * See https://github.com/jrowberg/i2cdevlib/issues/152#issuecomment-682319598
- * for more details.
- *
- * @param v
- * @param vRaw
- * @param gravity
- * @return uint8_t
- */
-static uint8_t
-get_linear_accel(VectorInt16* v, VectorInt16* vRaw, VectorFloat* gravity)
+bool
+mpu_wait_data(uint32_t timeout_ms)
 {
-    // get rid of the gravity component (+1g = +16384 in standard DMP FIFO packet,
-    // sensitivity is 2g)
-    v->x = vRaw->x - gravity->x * 16384;
-    v->y = vRaw->y - gravity->y * 16384;
-    v->z = vRaw->z - gravity->z * 16384;
-    return 0;
+    return xSemaphoreTake(mpu_data_sem, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
 }
 
 void
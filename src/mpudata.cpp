@@ -0,0 +1,67 @@
+/**
+ * @file mpudata.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Serializing MPU samples.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "data.hpp"
+
+#include "timesync.hpp"
+
+StaticJsonDocument<MPU_DATA_JSON_SIZE>
+mpu_data_t::to_json() const
+{
+    StaticJsonDocument<MPU_DATA_JSON_SIZE> doc;
+
+    // Yaw, pitch, roll
+    // TODO(nino): send in radians or degrees?
+    JsonArray ypr_json = doc.createNestedArray("ypr");
+    ypr_json.add(degrees(ypr[0]));
+    ypr_json.add(degrees(ypr[1]));
+    ypr_json.add(degrees(ypr[2]));
+
+    // Real acceleration (w/o gravity)
+    JsonArray accel_json = doc.createNestedArray("accel");
+    accel_json.add(accel.x);
+    accel_json.add(accel.y);
+    accel_json.add(accel.z);
+
+    // Gyroscope
+    JsonArray gyro_json = doc.createNestedArray("gyro");
+    gyro_json.add(gyro.x);
+    gyro_json.add(gyro.y);
+    gyro_json.add(gyro.z);
+
+    // Time
+    doc["time"] = time;
+
+    int64_t epoch_us;
+    if (time_us && timesync_to_epoch(time_us, &epoch_us))
+        doc["epochUs"] = epoch_us;
+
+    return doc;
+}
@@ -0,0 +1,306 @@
+/**
+ * @file netbench.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Network throughput self-tests.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "netbench.hpp"
+
+#include "config.h"
+#include "server.hpp"
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// Size of the generated data pattern, repeated for downloads (in bytes)
+#define NET_BENCH_PATTERN_SIZE 1024
+
+// Largest synthetic event (in bytes)
+#define NET_BENCH_MAX_EVENT 1024
+
+// Stack size of the synthetic event task (in bytes)
+#define NET_BENCH_TASK_STACK 4096
+
+/**
+ * @brief The self-tests.
+ */
+enum NetBench {
+    NET_BENCH_DOWNLOAD,
+    NET_BENCH_UPLOAD,
+    NET_BENCH_EVENTS,
+    NET_BENCH_TESTS,
+};
+
+static const char* const test_names[] = {"download", "upload", "events"};
+
+// Results of the last run of each test
+static netbench_result_t results[NET_BENCH_TESTS] = {};
+static portMUX_TYPE results_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Download data, generated once
+static uint8_t* pattern = nullptr;
+
+// The upload in progress
+static uint32_t upload_start_ms = 0;
+static uint32_t upload_bytes = 0;
+
+/**
+ * @brief Parameters of the synthetic event test.
+ */
+struct events_params_t {
+    uint32_t rate;    // Events per second
+    uint32_t seconds; // How long to send them for
+    uint32_t size;    // Size of each event
+};
+
+static events_params_t events_params;
+static TaskHandle_t events_task_handle = nullptr;
+
+/******************************************************************************/
+
+static void
+save_result(NetBench test, const netbench_result_t& result)
+{
+    portENTER_CRITICAL(&results_mux);
+    results[test] = result;
+    portEXIT_CRITICAL(&results_mux);
+
+    float kb_per_s = result.ms ? result.bytes / 1.024f / result.ms : 0;
+    log_i(
+        "Network self-test %s: %lu B in %lu ms (%.1f KB/s), %lu events, %lu "
+        "dropped, %lu late",
+        test_names[test], result.bytes, result.ms, kb_per_s, result.events,
+        result.dropped, result.late
+    );
+}
+
+/**
+ * @brief Total events dropped for every live data client.
+ */
+static uint32_t
+sse_dropped()
+{
+    sse_client_stats_t stats[SSE_MAX_CLIENTS];
+    size_t len = web_server_sse_clients(stats, SSE_MAX_CLIENTS);
+
+    uint32_t dropped = 0;
+    for (size_t i = 0; i < len; i++)
+        dropped += stats[i].dropped;
+    return dropped;
+}
+
+static void
+events_task(void*)
+{
+    events_params_t params = events_params;
+    uint32_t count = params.rate * params.seconds;
+    uint32_t period_us = 1000000 / params.rate;
+
+    // {"seq":<n>,"time":<ms>,"pad":"xxx..."}, padded out to the requested size
+    static char msg[NET_BENCH_MAX_EVENT + 1];
+
+    netbench_result_t result = {};
+    uint32_t dropped = sse_dropped();
+    uint64_t start = esp_timer_get_time();
+
+    for (uint32_t seq = 0; seq < count; seq++) {
+        // Sleep until the event is due
+        int64_t wait_us = (int64_t)(start + (uint64_t)seq * period_us)
+                          - esp_timer_get_time();
+        if (wait_us >= 1000)
+            vTaskDelay(pdMS_TO_TICKS(wait_us / 1000));
+        else if (wait_us < -(int64_t)period_us)
+            result.late++;
+
+        int len = snprintf(
+            msg, sizeof(msg), "{\"seq\":%lu,\"time\":%lu,\"pad\":\"", seq, millis()
+        );
+        size_t pad = params.size > (size_t)len + 2 ? params.size - len - 2 : 0;
+        memset(msg + len, 'x', pad);
+        strcpy(msg + len + pad, "\"}");
+
+        web_server_send_event("bench", msg);
+        result.events++;
+        result.bytes += len + pad + 2;
+    }
+
+    result.ms = (esp_timer_get_time() - start) / 1000;
+    result.dropped = sse_dropped() - dropped;
+    result.done = true;
+    save_result(NET_BENCH_EVENTS, result);
+
+    events_task_handle = nullptr;
+    vTaskDelete(nullptr);
+}
+
+/******************************************************************************/
+
+StaticJsonDocument<160>
+netbench_result_t::to_json() const
+{
+    StaticJsonDocument<160> doc;
+
+    doc["bytes"] = bytes;
+    doc["ms"] = ms;
+    doc["kbPerSec"] = ms ? bytes / 1.024f / ms : 0;
+    doc["events"] = events;
+    doc["dropped"] = dropped;
+    doc["late"] = late;
+    doc["done"] = done;
+
+    return doc;
+}
+
+void
+netbench_download(AsyncWebServerRequest* req)
+{
+    long mb = req->hasParam("mb") ? req->getParam("mb")->value().toInt() : 1;
+    if (mb < 1 || mb > NET_BENCH_MAX_MB)
+        return req->send(
+            400, "text/plain", "mb must be 1 to " + String(NET_BENCH_MAX_MB) + "."
+        );
+
+    if (!pattern) {
+        pattern = (uint8_t*)malloc(NET_BENCH_PATTERN_SIZE);
+        if (!pattern)
+            return req->send(507, "text/plain", "Out of memory.");
+        for (size_t i = 0; i < NET_BENCH_PATTERN_SIZE; i++)
+            pattern[i] = i * 31 + 7; // Not all zeros, in case anything compresses
+    }
+
+    size_t total = mb * 1024 * 1024;
+    auto* res = req->beginResponse(
+        "application/octet-stream", total,
+        [total, start_ms = (uint32_t)0](uint8_t* buf, size_t max_len, size_t index
+        ) mutable -> size_t {
+            if (!index)
+                start_ms = millis();
+
+            size_t len = min(max_len, total - index);
+            for (size_t i = 0; i < len;) {
+                size_t offset = (index + i) % NET_BENCH_PATTERN_SIZE;
+                size_t n = min(len - i, (size_t)NET_BENCH_PATTERN_SIZE - offset);
+                memcpy(buf + i, pattern + offset, n);
+                i += n;
+            }
+
+            if (index + len == total) {
+                netbench_result_t result = {};
+                result.bytes = total;
+                result.ms = millis() - start_ms;
+                result.done = true;
+                save_result(NET_BENCH_DOWNLOAD, result);
+            }
+            return len;
+        }
+    );
+    res->addHeader("Cache-Control", "no-store");
+    req->send(res);
+}
+
+void
+netbench_upload_body(
+    AsyncWebServerRequest*, uint8_t*, size_t len, size_t index, size_t
+)
+{
+    if (!index) {
+        upload_start_ms = millis();
+        upload_bytes = 0;
+    }
+    upload_bytes += len; // And that's it
+}
+
+void
+netbench_upload(AsyncWebServerRequest* req)
+{
+    netbench_result_t result = {};
+    result.bytes = upload_bytes;
+    result.ms = upload_bytes ? millis() - upload_start_ms : 0;
+    result.done = true;
+    save_result(NET_BENCH_UPLOAD, result);
+
+    auto* res = req->beginResponseStream("application/json");
+    serializeJson(result.to_json(), *res);
+    req->send(res);
+}
+
+void
+netbench_events(AsyncWebServerRequest* req)
+{
+    if (events_task_handle)
+        return req->send(409, "text/plain", "Event test already running.");
+
+    events_params_t params = {100, 10, 200};
+    if (req->hasParam("rate"))
+        params.rate = req->getParam("rate")->value().toInt();
+    if (req->hasParam("seconds"))
+        params.seconds = req->getParam("seconds")->value().toInt();
+    if (req->hasParam("size"))
+        params.size = req->getParam("size")->value().toInt();
+
+    if (params.rate < 1 || params.rate > NET_BENCH_MAX_RATE
+        || params.seconds < 1 || params.seconds > NET_BENCH_MAX_SECONDS
+        || params.size > NET_BENCH_MAX_EVENT)
+        return req->send(
+            400, "text/plain",
+            "rate must be 1 to " + String(NET_BENCH_MAX_RATE) + ", seconds 1 to "
+                + String(NET_BENCH_MAX_SECONDS) + ", and size at most "
+                + String(NET_BENCH_MAX_EVENT) + "."
+        );
+
+    events_params = params;
+    portENTER_CRITICAL(&results_mux);
+    results[NET_BENCH_EVENTS] = {};
+    portEXIT_CRITICAL(&results_mux);
+
+    BaseType_t res = xTaskCreatePinnedToCore(
+        events_task, "netbench", NET_BENCH_TASK_STACK, nullptr, 1, &events_task_handle,
+        TASKS_IO_CORE
+    );
+    if (res != pdPASS)
+        return req->send(500, "text/plain", "Could not start the event test.");
+
+    req->send(202, "text/plain", "Event test started.");
+}
+
+void
+netbench_results(AsyncWebServerRequest* req)
+{
+    netbench_result_t copy[NET_BENCH_TESTS];
+    portENTER_CRITICAL(&results_mux);
+    memcpy(copy, results, sizeof(copy));
+    portEXIT_CRITICAL(&results_mux);
+
+    auto* res = req->beginResponseStream("application/json");
+    res->print('{');
+    for (size_t i = 0; i < NET_BENCH_TESTS; i++) {
+        res->printf("%s\"%s\":", i ? "," : "", test_names[i]);
+        serializeJson(copy[i].to_json(), *res);
+    }
+    res->print('}');
+    req->send(res);
+}
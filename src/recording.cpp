@@ -0,0 +1,693 @@
+/**
+ * @file recording.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Recording file format.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "recording.hpp"
+
+#include "timesync.hpp"
+
+#include <esp_rom_crc.h>
+#include <esp_system.h>
+
+// Smallest block worth starting before a boundary
+#ifdef REC_COMPRESS
+#  define REC_MIN_BLOCK (sizeof(rec_block_t) + GORILLA_MAX_SAMPLE_BITS / 8 + 1)
+#else
+#  define REC_MIN_BLOCK (sizeof(rec_block_t) + sizeof(rec_sample_t))
+#endif
+
+/**
+ * @brief Check if we can read a recording version.
+ */
+static bool
+known_version(uint16_t version)
+{
+    return version >= REC_VERSION_MIN && version <= REC_VERSION;
+}
+
+/**
+ * @brief Read a recording header, of any version we know.
+ *
+ * Leaves the file right after the header. Older headers get a sequence number
+ * of 0.
+ */
+static bool
+read_header(RecFile& file, rec_header_t* header)
+{
+    auto* buf = reinterpret_cast<uint8_t*>(header);
+    uint32_t len = offsetof(rec_header_t, seq);
+    if (!file.seek(0) || file.read(buf, len) != len || header->magic != REC_MAGIC
+        || !known_version(header->version))
+        return false;
+
+    header->seq = 0;
+    uint32_t rest = rec_header_size(header->version) - len;
+    return file.read(buf + len, rest) == rest;
+}
+
+/**
+ * @brief Compute the CRC of a block.
+ *
+ * @param id The recording ID.
+ * @param block The block header, followed by its payload.
+ */
+static uint32_t
+block_crc(uint32_t id, const uint8_t* block)
+{
+    auto* header = reinterpret_cast<const rec_block_t*>(block);
+
+    uint32_t crc = esp_rom_crc32_le(id, block, offsetof(rec_block_t, crc));
+    return esp_rom_crc32_le(crc, block + sizeof(rec_block_t), header->len);
+}
+
+/**
+ * @brief Read and validate the block at an offset.
+ *
+ * @param file The recording.
+ * @param id The recording ID.
+ * @param offset Where the block starts.
+ * @param buf Container to read the block to, REC_BLOCK_SIZE bytes.
+ * @return If there is a valid block at the offset.
+ */
+static bool
+read_block(RecFile& file, uint32_t id, uint32_t offset, uint8_t* buf)
+{
+    auto* header = reinterpret_cast<rec_block_t*>(buf);
+
+    if (!file.seek(offset)
+        || file.read(buf, sizeof(rec_block_t)) != sizeof(rec_block_t))
+        return false;
+
+    switch (header->magic) {
+        case REC_BLOCK_MAGIC:
+        case REC_COMPRESSED_MAGIC:
+        case REC_INDEX_MAGIC:
+        case REC_TIMESYNC_MAGIC:
+        case REC_PADDING_MAGIC:
+        case REC_TRAILER_MAGIC:
+            break;
+
+        default:
+            return false;
+    }
+
+    if (header->len > REC_BLOCK_SIZE - sizeof(rec_block_t)
+        || offset % REC_ALIGN + sizeof(rec_block_t) + header->len > REC_ALIGN)
+        return false;
+
+    if (header->magic == REC_PADDING_MAGIC) {
+        // The padding itself isn't worth reading, just check the header
+        return header->crc == esp_rom_crc32_le(id, buf, offsetof(rec_block_t, crc));
+    }
+
+    if (file.read(buf + sizeof(rec_block_t), header->len) != header->len)
+        return false;
+
+    return header->crc == block_crc(id, buf);
+}
+
+/**
+ * @brief Get the time of the first sample in a block.
+ */
+static uint32_t
+first_sample_time(const uint8_t* block)
+{
+    auto* header = reinterpret_cast<const rec_block_t*>(block);
+    auto* payload = block + sizeof(rec_block_t);
+
+    if (header->magic == REC_COMPRESSED_MAGIC) {
+        // The first time is stored as-is, MSB first
+        return (uint32_t)payload[0] << 24 | payload[1] << 16 | payload[2] << 8
+               | payload[3];
+    }
+
+    // Same place in every version
+    uint32_t time;
+    memcpy(&time, payload + offsetof(rec_sample_t, time), sizeof(time));
+    return time;
+}
+
+/**
+ * @brief Flatten a sample's values into channels for compression.
+ */
+static void
+sample_to_channels(const mpu_data_t& sample, float* channels)
+{
+    memcpy(channels, sample.ypr, sizeof(sample.ypr));
+    channels[3] = sample.accel.x;
+    channels[4] = sample.accel.y;
+    channels[5] = sample.accel.z;
+    channels[6] = sample.gyro.x;
+    channels[7] = sample.gyro.y;
+    channels[8] = sample.gyro.z;
+}
+
+/**
+ * @brief Rebuild a sample from decompressed channels.
+ */
+static void
+channels_to_sample(uint32_t time, const float* channels, mpu_data_t* sample)
+{
+    memcpy(sample->ypr, channels, sizeof(sample->ypr));
+    sample->accel = VectorFloat(channels[3], channels[4], channels[5]);
+    sample->gyro = VectorFloat(channels[6], channels[7], channels[8]);
+    sample->time = time;
+    sample->time_us = 0; // From another boot, so it can't be mapped to epoch time
+}
+
+/******************************************************************************/
+
+bool
+RecWriter::begin(RecFile file)
+{
+    file_ = file;
+    id_ = esp_random();
+    count_ = 0;
+    offset_ = 0;
+    last_sync_ = millis();
+    syncs_ = 0;
+    samples_ = 0;
+    encode_us_ = 0;
+
+    index_.block.count = 0;
+    index_.prev = REC_NO_OFFSET;
+    since_index_ = REC_INDEX_INTERVAL; // Always index the first block
+
+    rec_header_t header = {
+        REC_MAGIC, REC_VERSION, sizeof(rec_sample_t), id_, storage_next_seq()
+    };
+    auto* buf = reinterpret_cast<const uint8_t*>(&header);
+    if (!file_ || file_.write(buf, sizeof(header)) != sizeof(header))
+        return false;
+
+    offset_ += sizeof(header);
+    return true;
+}
+
+bool
+RecWriter::start_block_()
+{
+    // Don't start a tiny block right before a boundary
+    if (room_() < REC_MIN_BLOCK && !write_padding_())
+        return false;
+
+    capacity_ = min<size_t>(REC_BLOCK_SIZE, room_());
+
+#ifdef REC_COMPRESS
+    auto* payload = block_ + sizeof(rec_block_t);
+    encoder_.begin(payload, capacity_ - sizeof(rec_block_t));
+#endif
+    return true;
+}
+
+bool
+RecWriter::write(const mpu_data_t& sample)
+{
+    if (!count_ && (!write_timesync_() || !start_block_()))
+        return false;
+
+    uint32_t start = micros();
+    samples_++;
+
+#ifdef REC_COMPRESS
+    float channels[GORILLA_CHANNELS];
+    sample_to_channels(sample, channels);
+    encoder_.encode(sample.time, sample.time_us % 1000, channels);
+    encode_us_ += micros() - start;
+
+    bool full = ++count_ >= UINT16_MAX || !encoder_.has_room();
+#else
+    rec_sample_t raw;
+    sample_to_channels(sample, raw.channels);
+    raw.time = sample.time;
+    raw.time_us = sample.time_us % 1000;
+    raw.reserved = 0;
+
+    auto* payload = block_ + sizeof(rec_block_t);
+    memcpy(payload + count_ * sizeof(raw), &raw, sizeof(raw));
+    encode_us_ += micros() - start;
+
+    size_t next_len = sizeof(rec_block_t) + (count_ + 2) * sizeof(raw);
+    bool full = ++count_ >= UINT16_MAX || next_len > capacity_;
+#endif
+
+    if (full && !flush())
+        return false;
+
+    if (millis() - last_sync_ >= REC_SYNC_INTERVAL)
+        return sync();
+    return true;
+}
+
+bool
+RecWriter::write_block_(uint8_t* buf, size_t len)
+{
+    if (len > room_() && !write_padding_())
+        return false;
+
+    auto* header = reinterpret_cast<rec_block_t*>(buf);
+    header->crc = block_crc(id_, buf);
+
+    if (file_.write(buf, len) != len)
+        return false;
+
+    offset_ += len;
+    return true;
+}
+
+bool
+RecWriter::write_timesync_()
+{
+    // Only called between sample blocks, start_block_() sizes them to the room left
+    timesync_t sync;
+    if (!timesync_get(&sync) || sync.syncs == syncs_)
+        return true;
+
+    rec_timesync_t block;
+    block.block = {REC_TIMESYNC_MAGIC, 0, sizeof(block) - sizeof(rec_block_t), 0};
+    block.drift_ppb = sync.drift_ppb;
+    block.timer_us = sync.timer_us;
+    block.epoch_us = sync.epoch_us;
+
+    if (!write_block_(reinterpret_cast<uint8_t*>(&block), sizeof(block)))
+        return false;
+
+    syncs_ = sync.syncs;
+    return true;
+}
+
+bool
+RecWriter::write_padding_()
+{
+    static const uint8_t zeros[64] = {};
+
+    size_t room = room_();
+    if (room >= sizeof(rec_block_t)) {
+        uint32_t len = room - sizeof(rec_block_t);
+        rec_block_t header = {REC_PADDING_MAGIC, 0, len, 0};
+        auto* buf = reinterpret_cast<uint8_t*>(&header);
+        header.crc = esp_rom_crc32_le(id_, buf, offsetof(rec_block_t, crc));
+
+        if (file_.write(buf, sizeof(header)) != sizeof(header))
+            return false;
+        room -= sizeof(header);
+        offset_ += sizeof(header);
+    }
+
+    // Fill the rest with zeros
+    while (room) {
+        size_t len = min(room, sizeof(zeros));
+        if (file_.write(zeros, len) != len)
+            return false;
+        room -= len;
+        offset_ += len;
+    }
+    return true;
+}
+
+bool
+RecWriter::flush()
+{
+    if (!count_)
+        return true;
+
+    auto* block = reinterpret_cast<rec_block_t*>(block_);
+    block->count = count_;
+#ifdef REC_COMPRESS
+    block->magic = REC_COMPRESSED_MAGIC;
+    block->len = encoder_.size();
+#else
+    block->magic = REC_BLOCK_MAGIC;
+    block->len = count_ * sizeof(rec_sample_t);
+#endif
+    count_ = 0;
+
+    // Index this block if it's been long enough
+    bool indexed = since_index_ >= REC_INDEX_INTERVAL;
+    if (indexed) {
+        auto& entry = index_.entries[index_.block.count++];
+        entry.offset = offset_;
+        entry.time = first_sample_time(block_);
+
+        since_index_ = 0;
+    }
+    since_index_ += block->count;
+
+    // Always fits, start_block_() made sure of it
+    if (!write_block_(block_, sizeof(rec_block_t) + block->len))
+        return false;
+
+    if (indexed && index_.block.count >= REC_INDEX_ENTRIES)
+        return write_index_();
+    return true;
+}
+
+bool
+RecWriter::sync()
+{
+    last_sync_ = millis();
+
+    if (!flush())
+        return false;
+
+    file_.flush();
+    return true;
+}
+
+bool
+RecWriter::write_index_()
+{
+    if (!index_.block.count)
+        return true;
+
+    index_.block.magic = REC_INDEX_MAGIC;
+    index_.block.len =
+        sizeof(index_.prev) + index_.block.count * sizeof(rec_index_entry_t);
+
+    size_t len = sizeof(rec_block_t) + index_.block.len;
+    if (len > room_() && !write_padding_())
+        return false;
+
+    uint32_t offset = offset_;
+    if (!write_block_(reinterpret_cast<uint8_t*>(&index_), len))
+        return false;
+
+    index_.prev = offset;
+    index_.block.count = 0;
+    return true;
+}
+
+void
+RecWriter::close()
+{
+    if (!file_)
+        return;
+
+    if (!flush() || !write_index_()) {
+        log_e("Could not write the last blocks of %s", file_.name());
+        return file_.close();
+    }
+
+    rec_trailer_t trailer;
+    trailer.block = {REC_TRAILER_MAGIC, 0, sizeof(trailer.index), 0};
+    trailer.index = index_.prev;
+
+    if (!write_block_(reinterpret_cast<uint8_t*>(&trailer), sizeof(trailer)))
+        log_e("Could not write the trailer of %s", file_.name());
+
+    if (samples_) {
+        log_i(
+            "Wrote %lu samples to %s in %lu B: %.2f B/sample (%.1fx smaller than raw), "
+            "%.2f us/sample to encode",
+            samples_, file_.name(), offset_, offset_ / (float)samples_,
+            samples_ * sizeof(rec_sample_t) / (float)offset_,
+            encode_us_ / (float)samples_
+        );
+    }
+    file_.close();
+}
+
+/******************************************************************************/
+
+bool
+RecReader::begin(RecFile file)
+{
+    file_ = file;
+    count_ = idx_ = 0;
+    done_ = false;
+    from_ = 0;
+    to_ = UINT32_MAX;
+
+    if (!file_)
+        return false;
+
+    rec_header_t header;
+    if (!read_header(file_, &header)
+        || header.sample_size != rec_sample_size(header.version)) {
+        log_e("%s is not a recording (or is from another version)", file_.name());
+        return false;
+    }
+    id_ = header.id;
+    version_ = header.version;
+    data_start_ = file_.position();
+
+    // Peek at the first sample to find when the recording started
+    if (load_block_())
+        start_time_ = first_sample_time(block_);
+    else
+        done_ = true; // Empty recording
+
+    return true;
+}
+
+bool
+RecReader::load_block_()
+{
+    auto* block = reinterpret_cast<rec_block_t*>(block_);
+    auto* payload = block_ + sizeof(rec_block_t);
+
+    while (true) {
+        uint32_t offset = file_.position();
+        if (offset >= file_.size())
+            return false;
+
+        // Skip the zeros before a boundary
+        uint32_t room = REC_ALIGN - offset % REC_ALIGN;
+        if (room < sizeof(rec_block_t)) {
+            file_.seek(offset + room);
+            continue;
+        }
+
+        if (!read_block(file_, id_, offset, block_)) {
+            log_w("Invalid block in %s at %lu", file_.name(), offset);
+            return false;
+        }
+
+        if (block->magic == REC_BLOCK_MAGIC || block->magic == REC_COMPRESSED_MAGIC)
+            break;
+
+        // Skip over everything else
+        file_.seek(offset + sizeof(rec_block_t) + block->len);
+    }
+
+    compressed_ = block->magic == REC_COMPRESSED_MAGIC;
+    if (!compressed_ && block->len != block->count * rec_sample_size(version_))
+        return false;
+
+    if (compressed_)
+        decoder_.begin(payload, block->len, version_ < 7);
+
+    count_ = block->count;
+    idx_ = 0;
+    return count_ > 0;
+}
+
+uint32_t
+RecReader::find_block_(uint32_t time)
+{
+    // Find the last index block from the trailer
+    auto* trailer = reinterpret_cast<rec_trailer_t*>(block_);
+    size_t size = file_.size();
+
+    if (size < data_start_ + sizeof(rec_trailer_t)
+        || !read_block(file_, id_, size - sizeof(rec_trailer_t), block_)
+        || trailer->block.magic != REC_TRAILER_MAGIC) {
+        log_d("No seek index in %s, reading from the start", file_.name());
+        return data_start_;
+    }
+
+    // Walk back through the index blocks until we find the time
+    auto* index = reinterpret_cast<rec_index_block_t*>(block_);
+    uint32_t offset = trailer->index;
+
+    while (offset != REC_NO_OFFSET) {
+        if (!read_block(file_, id_, offset, block_)
+            || index->block.magic != REC_INDEX_MAGIC || !index->block.count
+            || index->block.count > REC_INDEX_ENTRIES) {
+            log_w("Invalid index block in %s at %lu", file_.name(), offset);
+            return data_start_;
+        }
+
+        if (index->entries[0].time <= time) {
+            // It's in this block, find the last entry at or before the time
+            size_t i = index->block.count - 1;
+            while (index->entries[i].time > time)
+                i--;
+            return index->entries[i].offset;
+        }
+        offset = index->prev;
+    }
+
+    return data_start_;
+}
+
+bool
+RecReader::seek(uint32_t from, uint32_t to)
+{
+    from_ = start_time_ + from;
+    to_ = to > UINT32_MAX - start_time_ ? UINT32_MAX : start_time_ + to;
+
+    count_ = idx_ = 0;
+    done_ = false;
+    return file_.seek(find_block_(from_));
+}
+
+bool
+RecReader::next(mpu_data_t* sample)
+{
+    while (!done_) {
+        if (idx_ >= count_ && !load_block_()) {
+            done_ = true;
+            break;
+        }
+
+        auto* payload = block_ + sizeof(rec_block_t);
+        if (compressed_) {
+            // Decode one sample at a time, right when it's needed
+            uint32_t time;
+            uint16_t time_us;
+            float channels[GORILLA_CHANNELS];
+            if (!decoder_.decode(&time, &time_us, channels)) {
+                log_w("Truncated compressed block in %s", file_.name());
+                done_ = true;
+                break;
+            }
+            channels_to_sample(time, channels, sample);
+            idx_++;
+        } else {
+            size_t size = rec_sample_size(version_);
+            rec_sample_t raw;
+            memcpy(&raw, payload + idx_++ * size, size);
+            channels_to_sample(raw.time, raw.channels, sample);
+        }
+
+        if (sample->time < from_)
+            continue;
+        if (sample->time > to_) {
+            done_ = true;
+            break;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool
+RecReader::end_time(uint32_t* time)
+{
+    // Jump to the last indexed block, then read to the end
+    from_ = 0;
+    to_ = UINT32_MAX;
+    count_ = idx_ = 0;
+    done_ = false;
+    if (!file_.seek(find_block_(UINT32_MAX)))
+        return false;
+
+    mpu_data_t sample;
+    bool found = false;
+    while (next(&sample)) {
+        *time = sample.time;
+        found = true;
+    }
+    return found;
+}
+
+int
+RecReader::available()
+{
+    return !done_ && (idx_ < count_ || file_.available() > 0);
+}
+
+void
+RecReader::close()
+{
+    file_.close();
+}
+
+/******************************************************************************/
+
+bool
+rec_read_header(RecFile& file, rec_header_t* header)
+{
+    bool valid = read_header(file, header);
+    file.seek(0);
+    return valid;
+}
+
+uint32_t
+rec_recover(RecFile& file, uint32_t max_len)
+{
+    static uint8_t buf[REC_BLOCK_SIZE]; // Too big for the stack
+
+    rec_header_t header;
+    if (!read_header(file, &header))
+        return 0;
+    uint32_t header_size = rec_header_size(header.version);
+
+    // Where the first block of a boundary is
+    auto boundary = [header_size](uint32_t i) -> uint32_t {
+        return i ? i * REC_ALIGN : header_size;
+    };
+
+    // Boundaries up to `good` start with a valid block, `bad` and after don't
+    uint32_t good = 0;
+    uint32_t bad = (max_len + REC_ALIGN - 1) / REC_ALIGN;
+    if (!read_block(file, header.id, boundary(0), buf))
+        return header_size;
+
+    while (bad - good > 1) {
+        uint32_t mid = good + (bad - good) / 2;
+        if (read_block(file, header.id, boundary(mid), buf))
+            good = mid;
+        else
+            bad = mid;
+    }
+
+    // Walk the blocks after the last good boundary
+    auto* block = reinterpret_cast<rec_block_t*>(buf);
+    uint32_t end = boundary(good);
+    uint32_t offset = end;
+
+    while (offset < max_len) {
+        uint32_t room = REC_ALIGN - offset % REC_ALIGN;
+        if (room < sizeof(rec_block_t)) {
+            offset += room;
+            continue;
+        }
+
+        if (!read_block(file, header.id, offset, buf))
+            break;
+
+        offset += sizeof(rec_block_t) + block->len;
+        end = offset;
+    }
+
+    log_i("%s is intact up to %lu B", file.name(), end);
+    return end;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file replay.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Recording replay over the live event stream.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "replay.hpp"
+
+#include "config.h"
+#include "data.hpp"
+#include "recording.hpp"
+#include "server.hpp"
+#include "storage.hpp"
+
+#include <Arduino.h>
+
+// How long to wait for the last replay to stop before starting a new one
+#define REPLAY_STOP_TIMEOUT_MS 500
+
+// The recording being replayed, only touched by the replay task once it starts
+static RecReader replay_reader;
+
+// Given to stop the replay task. Outlives the task, so stopping never races
+// with it exiting.
+static SemaphoreHandle_t replay_stop_sem = nullptr;
+
+static TaskHandle_t replay_task_handle = nullptr;
+static replay_status_t replay_cur = {};
+static portMUX_TYPE replay_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/******************************************************************************/
+
+/**
+ * @brief Tell clients a replay started or stopped.
+ */
+static void
+replay_send_state(const char* state)
+{
+    replay_status_t status;
+    replay_status(&status);
+
+    auto doc = status.to_json();
+    doc["state"] = state;
+    web_server_send_event("replay", doc);
+}
+
+static void
+replay_task(void*)
+{
+    replay_send_state("started");
+
+    float speed = replay_cur.speed;
+    uint32_t start_time = replay_reader.start_time();
+    TickType_t start = xTaskGetTickCount();
+    uint32_t first = UINT32_MAX;
+    bool stopped = false;
+
+    mpu_data_t sample;
+    while (replay_reader.next(&sample)) {
+        if (first == UINT32_MAX)
+            first = sample.time;
+
+        // Wait until the sample is due, or until we're told to stop
+        TickType_t due = start + pdMS_TO_TICKS((sample.time - first) / speed);
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = (int32_t)(due - now) > 0 ? due - now : 0;
+        if (xSemaphoreTake(replay_stop_sem, wait)) {
+            stopped = true;
+            break;
+        }
+
+        web_server_send_sample(sample, 0);
+
+        portENTER_CRITICAL(&replay_mux);
+        replay_cur.position = sample.time - start_time;
+        replay_cur.sent++;
+        portEXIT_CRITICAL(&replay_mux);
+    }
+    replay_reader.close();
+
+    log_i(
+        "Replay of \"%s\" %s after %lu samples", replay_cur.name,
+        stopped ? "stopped" : "finished", replay_cur.sent
+    );
+
+    portENTER_CRITICAL(&replay_mux);
+    replay_cur.running = false;
+    portEXIT_CRITICAL(&replay_mux);
+    replay_send_state(stopped ? "stopped" : "done");
+
+    replay_task_handle = nullptr;
+    vTaskDelete(nullptr);
+}
+
+/******************************************************************************/
+
+StaticJsonDocument<128>
+replay_status_t::to_json() const
+{
+    StaticJsonDocument<128> doc;
+
+    doc["running"] = running;
+    doc["name"] = name;
+    doc["speed"] = speed;
+    doc["position"] = position;
+    doc["sent"] = sent;
+
+    return doc;
+}
+
+bool
+replay_setup()
+{
+    replay_stop_sem = xSemaphoreCreateBinary();
+    if (!replay_stop_sem) {
+        log_e("Could not create the replay stop semaphore");
+        return false;
+    }
+    return true;
+}
+
+bool
+replay_start(const char* name, float speed, uint32_t from)
+{
+    if (!replay_stop_sem)
+        return false;
+
+    if (speed < 1 || speed > REPLAY_MAX_SPEED) {
+        log_e("Replay speed must be 1 to %u, not %.1f", REPLAY_MAX_SPEED, speed);
+        return false;
+    }
+
+    // Only one replay at a time
+    replay_stop();
+    for (uint32_t waited = 0; replay_task_handle; waited++) {
+        if (waited >= REPLAY_STOP_TIMEOUT_MS) {
+            log_e("The last replay didn't stop");
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    xSemaphoreTake(replay_stop_sem, 0); // Don't stop the new one right away
+
+    if (!replay_reader.begin(storage_open(name))) {
+        log_e("Could not open recording \"%s\" to replay", name);
+        replay_reader.close();
+        return false;
+    }
+    if (from && !replay_reader.seek(from)) {
+        log_e("Could not seek to %lu ms in \"%s\"", from, name);
+        replay_reader.close();
+        return false;
+    }
+
+    portENTER_CRITICAL(&replay_mux);
+    replay_cur = {};
+    replay_cur.running = true;
+    strlcpy(replay_cur.name, name, sizeof(replay_cur.name));
+    replay_cur.speed = speed;
+    replay_cur.position = from;
+    portEXIT_CRITICAL(&replay_mux);
+
+    BaseType_t res = xTaskCreatePinnedToCore(
+        replay_task, "replay", REPLAY_TASK_STACK, nullptr, REPLAY_TASK_PRIORITY,
+        &replay_task_handle, TASKS_IO_CORE
+    );
+    if (res != pdPASS) {
+        log_e("Could not start the replay task");
+        replay_cur.running = false;
+        replay_reader.close();
+        return false;
+    }
+
+    log_i("Replaying \"%s\" from %lu ms at %.1fx", name, from, speed);
+    return true;
+}
+
+void
+replay_stop()
+{
+    if (replay_task_handle)
+        xSemaphoreGive(replay_stop_sem);
+}
+
+bool
+replay_running()
+{
+    return replay_cur.running;
+}
+
+void
+replay_status(replay_status_t* status)
+{
+    portENTER_CRITICAL(&replay_mux);
+    *status = replay_cur;
+    portEXIT_CRITICAL(&replay_mux);
+}
@@ -0,0 +1,187 @@
+/**
+ * @file serialstream.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Binary sample streaming over the serial port.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "serialstream.hpp"
+
+#include "cobs.hpp"
+#include "config.h"
+#include "data.hpp"
+
+#include <Arduino.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+
+static volatile bool active = false;
+
+// Numbers the samples, including the dropped ones
+static uint32_t seq = 0;
+static uint32_t frames_sent = 0;
+static uint32_t frames_dropped = 0;
+
+// Held while a frame is going out, so stopping doesn't cut one in half
+static SemaphoreHandle_t stream_lock = nullptr;
+
+// Where ESP-IDF logs went before we silenced them
+static vprintf_like_t old_vprintf = nullptr;
+
+/******************************************************************************/
+
+/**
+ * @brief Drop ESP-IDF logs while streaming.
+ */
+static int
+discard_vprintf(const char*, va_list)
+{
+    return 0;
+}
+
+/**
+ * @brief Set a frame's CRC, encode it, and send it.
+ *
+ * @param frame The frame, which ends with its CRC.
+ * @param len The size of frame.
+ * @return If there was room to send it.
+ */
+static bool
+send_frame(uint8_t* frame, size_t len)
+{
+    uint32_t crc = esp_rom_crc32_le(0, frame, len - sizeof(crc));
+    memcpy(frame + len - sizeof(crc), &crc, sizeof(crc));
+
+    uint8_t buf[cobs_max_len(sizeof(serialstream_sample_t)) + 1];
+    size_t n = cobs_encode(frame, len, buf);
+    buf[n++] = 0;
+
+    if ((size_t)Serial.availableForWrite() < n)
+        return false;
+    Serial.write(buf, n);
+    return true;
+}
+
+/******************************************************************************/
+
+void
+serialstream_start()
+{
+    if (!stream_lock && !(stream_lock = xSemaphoreCreateMutex())) {
+        log_e("Could not create the serial stream lock");
+        return;
+    }
+    if (active)
+        return;
+
+    log_i(
+        "Streaming samples at %lu baud, send '%c' to stop", SERIALSTREAM_BAUD,
+        SERIALSTREAM_STOP
+    );
+    Serial.flush();
+
+    // Nothing but frames from here on
+    Serial.setDebugOutput(false);
+    old_vprintf = esp_log_set_vprintf(discard_vprintf);
+    Serial.updateBaudRate(SERIALSTREAM_BAUD);
+
+    xSemaphoreTake(stream_lock, portMAX_DELAY);
+    seq = frames_sent = frames_dropped = 0;
+
+    // Mark the start of the first frame, in case the baud change left garbage
+    Serial.write((uint8_t)0);
+
+    serialstream_hello_t hello;
+    hello.type = SERIALSTREAM_HELLO;
+    hello.version = SERIALSTREAM_VERSION;
+    hello.sample_rate = MPU_SAMPLE_RATE;
+    hello.baud = SERIALSTREAM_BAUD;
+    send_frame(reinterpret_cast<uint8_t*>(&hello), sizeof(hello));
+
+    active = true;
+    xSemaphoreGive(stream_lock);
+}
+
+void
+serialstream_stop()
+{
+    if (!active)
+        return;
+
+    xSemaphoreTake(stream_lock, portMAX_DELAY);
+    active = false;
+    xSemaphoreGive(stream_lock);
+
+    Serial.flush();
+    Serial.updateBaudRate(SERIAL_BAUD);
+    esp_log_set_vprintf(old_vprintf);
+    Serial.setDebugOutput(true);
+
+    log_i(
+        "Stopped streaming, %lu samples sent, %lu dropped", frames_sent, frames_dropped
+    );
+}
+
+bool
+serialstream_active()
+{
+    return active;
+}
+
+void
+serialstream_send(const mpu_data_t& meas)
+{
+    if (!active)
+        return;
+
+    // Stopping, this one doesn't count
+    if (xSemaphoreTake(stream_lock, 0) != pdTRUE)
+        return;
+    if (!active) {
+        xSemaphoreGive(stream_lock);
+        return;
+    }
+
+    serialstream_sample_t frame;
+    frame.type = SERIALSTREAM_SAMPLE;
+    frame.seq = seq++;
+    frame.time = meas.time;
+    for (size_t i = 0; i < 3; i++)
+        frame.ypr[i] = meas.ypr[i];
+    frame.accel[0] = meas.accel.x;
+    frame.accel[1] = meas.accel.y;
+    frame.accel[2] = meas.accel.z;
+    frame.gyro[0] = meas.gyro.x;
+    frame.gyro[1] = meas.gyro.y;
+    frame.gyro[2] = meas.gyro.z;
+
+    if (send_frame(reinterpret_cast<uint8_t*>(&frame), sizeof(frame)))
+        frames_sent++;
+    else
+        frames_dropped++;
+
+    xSemaphoreGive(stream_lock);
+}
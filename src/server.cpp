@@ -31,11 +31,25 @@
 #include "server.hpp"
 
 #include "data.hpp"
+#include "export.hpp"
+#include "jobs.hpp"
+#include "latency.hpp"
+#include "metrics.hpp"
+#include "mpu.hpp"
+#include "netbench.hpp"
+#include "pool.hpp"
+#include "replay.hpp"
+#include "storage.hpp"
+#include "tasks.hpp"
+#include "timesync.hpp"
 
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
 #include <ESPAsyncWebServer.h>
 #include <LittleFS.h>
+#include <esp_timer.h>
+
+#include <vector>
 
 // Server on port 80 (HTTP)
 static AsyncWebServer server(80);
@@ -43,43 +57,639 @@ static AsyncWebServer server(80);
 // Event source on /events
 static AsyncEventSource events("/events");
 
+// Closed recordings never change, so they can be cached forever
+#define CACHE_IMMUTABLE "public, max-age=31536000, immutable"
+
+// Number of export lengths and resume points to remember, for answering range
+// requests
+#define EXPORT_LEN_CACHE 8
+
+// Dashboard asset manifest, written by scripts/build_assets.py
+#define ASSETS_MANIFEST "/assets.json"
+
+// Longest event that can be sent from a JSON document (in bytes)
+#define SSE_MSG_SIZE 384
+
+// Room to leave in an event for a latency trace (see latency.hpp)
+#define SSE_TRACE_SIZE 48
+
+// Number of /metrics scrapes that can run at once
+#define METRICS_SLOTS 2
+
+// Most export output to generate and throw away per callback when skipping from
+// a resume point to the start of a range (in bytes)
+// Higher values resume faster, but block the other clients for longer.
+#define EXPORT_SKIP_BUDGET (32 * 1024)
+
+/**
+ * @brief The length and resume points of a complete export, by ETag.
+ */
+struct export_len_t {
+    String etag;
+    size_t len;
+    std::vector<export_resume_t> resumes;
+};
+
+// Lengths and resume points of recently completed exports
+static export_len_t export_lens[EXPORT_LEN_CACHE];
+static size_t export_lens_next = 0;
+
+/**
+ * @brief A dashboard file, from the asset manifest.
+ */
+struct asset_t {
+    String path;    // URL it's served at
+    String file;    // Where it is on LittleFS
+    String type;    // MIME type
+    String etag;    // Strong ETag of the stored bytes
+    bool gzip;      // If the stored file is gzipped
+    bool immutable; // If the name has a content hash in it
+};
+
+// Dashboard files
+static std::vector<asset_t> assets;
+
+// index.html, kept in RAM since every dashboard load starts with it
+static const asset_t* index_asset = nullptr;
+static uint8_t* index_data = nullptr;
+static size_t index_len = 0;
+
+/**
+ * @brief A live data client.
+ */
+struct sse_client_t {
+    AsyncEventSourceClient* client; // nullptr if the slot is free
+    sse_client_stats_t stats;
+    uint32_t connect_ms; // When the client connected
+    uint32_t drained_ms; // When the client's queue was last empty
+    uint32_t full_ms;    // When the client's queue filled up, 0 if it isn't full
+    bool evicting;       // If the client gets closed on its next poll
+
+    // Newest sample that didn't fit in the queue, sent once there's room
+    char pending[SSE_MSG_SIZE];
+    uint32_t pending_id; // Its event ID, 0 if there's none
+};
+
+// Connected live data clients
+// Clients disconnect on the async_tcp task, so the list is locked while
+// sending. The lock is recursive, since the JSON senders hold it while calling
+// web_server_send_event().
+static sse_client_t sse_clients[SSE_MAX_CLIENTS];
+static SemaphoreHandle_t sse_lock = nullptr;
+static uint32_t sse_evicted = 0;
+
+// Events are serialized here instead of a String per event, under sse_lock
+static char sse_msg[SSE_MSG_SIZE];
+
+// Exports and scrapes in progress
+static StaticPool<RecExporter, EXPORT_SLOTS> exporters;
+static StaticPool<MetricsWriter, METRICS_SLOTS> metrics_writers;
+
+/******************************************************************************/
+
+/**
+ * @brief Check if the client accepts gzipped responses.
+ *
+ * Looks for "gzip" in Accept-Encoding, unless it's refused with "q=0".
+ */
+static bool
+accepts_gzip(AsyncWebServerRequest* req)
+{
+    if (!req->hasHeader("Accept-Encoding"))
+        return false;
+
+    String header = req->header("Accept-Encoding");
+    header.toLowerCase();
+
+    int start = 0;
+    while (start < (int)header.length()) {
+        int end = header.indexOf(',', start);
+        if (end < 0)
+            end = header.length();
+
+        String coding = header.substring(start, end);
+        int params = coding.indexOf(';');
+        String name = coding.substring(0, params < 0 ? coding.length() : params);
+        name.trim();
+
+        if (name == "gzip" || name == "*") {
+            String q = params < 0 ? "" : coding.substring(params + 1);
+            q.replace(" ", "");
+            return !q.startsWith("q=") || q.substring(2).toFloat() > 0;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+/**
+ * @brief Check if a header lists an ETag, like If-None-Match does.
+ */
+static bool
+etag_matches(const String& header, const String& etag)
+{
+    return header == "*" || header.indexOf(etag) >= 0;
+}
+
+/**
+ * @brief Reply with a 304 if the client's copy is still current.
+ *
+ * @return If a 304 was sent.
+ */
+static bool
+send_not_modified(AsyncWebServerRequest* req, const String& etag)
+{
+    if (!req->hasHeader("If-None-Match")
+        || !etag_matches(req->header("If-None-Match"), etag))
+        return false;
+
+    auto* res = req->beginResponse(304);
+    res->addHeader("ETag", etag);
+    res->addHeader("Cache-Control", CACHE_IMMUTABLE);
+    req->send(res);
+    return true;
+}
+
+/**
+ * @brief Results of parsing a Range header.
+ */
+enum RangeResult {
+    RANGE_NONE,    // Send everything
+    RANGE_OK,      // Send the range
+    RANGE_INVALID, // The range can't be satisfied
+};
+
+/**
+ * @brief Parse a byte position from a Range header.
+ *
+ * Unlike String::toInt(), anything but digits is an error.
+ *
+ * @param str The position.
+ * @param pos Container to save the position to. Saturates at SIZE_MAX.
+ * @return If the position was valid.
+ */
+static bool
+parse_range_pos(const String& str, size_t* pos)
+{
+    if (!str.length())
+        return false;
+
+    uint64_t val = 0;
+    for (size_t i = 0; i < str.length(); i++) {
+        char c = str[i];
+        if (c < '0' || c > '9')
+            return false;
+        val = min<uint64_t>(val * 10 + (c - '0'), SIZE_MAX);
+    }
+
+    *pos = val;
+    return true;
+}
+
+/**
+ * @brief Parse a single-range Range header, e.g. "bytes=100-", "bytes=0-99", or
+ * "bytes=-100".
+ *
+ * Ignores the range if If-Range doesn't match the current ETag, or if there are
+ * multiple ranges. Malformed positions, like "bytes=abc-", are invalid.
+ *
+ * @param req The request.
+ * @param etag The ETag of the response, empty if it has none.
+ * @param size The length of the full response.
+ * @param start Container to save the offset of the first byte to.
+ * @param len Container to save the length of the range to.
+ * @return What to send.
+ */
+static RangeResult
+parse_range(
+    AsyncWebServerRequest* req, const String& etag, size_t size, size_t* start,
+    size_t* len
+)
+{
+    if (!req->hasHeader("Range") || !etag.length())
+        return RANGE_NONE;
+
+    // Only resume if the client has the same thing we do
+    if (req->hasHeader("If-Range") && req->header("If-Range") != etag)
+        return RANGE_NONE;
+
+    const String& range = req->header("Range");
+    int dash = range.indexOf('-');
+    if (!range.startsWith("bytes=") || dash < 0 || range.indexOf(',') >= 0)
+        return RANGE_NONE;
+
+    String first = range.substring(6, dash);
+    String last = range.substring(dash + 1);
+    first.trim();
+    last.trim();
+
+    size_t end = size - 1;
+    if (!first.length()) {
+        // The last N bytes
+        size_t suffix;
+        if (!parse_range_pos(last, &suffix) || !suffix || !size)
+            return RANGE_INVALID;
+        *start = size - min(suffix, size);
+    } else {
+        size_t last_pos = end;
+        if (!parse_range_pos(first, start)
+            || (last.length() && !parse_range_pos(last, &last_pos)))
+            return RANGE_INVALID;
+        end = min(last_pos, end);
+    }
+
+    if (*start >= size || end < *start)
+        return RANGE_INVALID;
+
+    *len = end - *start + 1;
+    return RANGE_OK;
+}
+
+/**
+ * @brief Reply with a 416 for an unsatisfiable range.
+ */
+static void
+send_range_not_satisfiable(AsyncWebServerRequest* req, size_t size)
+{
+    auto* res = req->beginResponse(416);
+    res->addHeader("Content-Range", "bytes */" + String(size));
+    req->send(res);
+}
+
+/**
+ * @brief Add the headers for a partial response.
+ */
+static void
+add_range_headers(AsyncWebServerResponse* res, size_t start, size_t len, size_t size)
+{
+    res->setCode(206);
+    res->addHeader(
+        "Content-Range", "bytes " + String(start) + "-" + String(start + len - 1) + "/"
+                             + String(size)
+    );
+}
+
+/**
+ * @brief Look up a previously completed export.
+ *
+ * @return The export, or nullptr if it isn't known.
+ */
+static const export_len_t*
+export_len_find(const String& etag)
+{
+    for (const auto& entry : export_lens) {
+        if (entry.len && entry.etag == etag)
+            return &entry;
+    }
+    return nullptr;
+}
+
+static void
+export_len_save(const String& etag, const RecExporter& exporter)
+{
+    if (export_len_find(etag))
+        return;
+
+    size_t len;
+    const export_resume_t* resumes = exporter.resume_points(&len);
+
+    export_lens[export_lens_next] = {
+        etag, exporter.bytes(), std::vector<export_resume_t>(resumes, resumes + len)
+    };
+    export_lens_next = (export_lens_next + 1) % EXPORT_LEN_CACHE;
+}
+
+/**
+ * @brief Load the dashboard asset manifest, and index.html into RAM.
+ *
+ * @return If the manifest was loaded.
+ */
+static bool
+assets_load()
+{
+    File manifest = LittleFS.open(ASSETS_MANIFEST);
+    if (!manifest)
+        return false;
+
+    DynamicJsonDocument doc(manifest.size() * 2);
+    DeserializationError err = deserializeJson(doc, manifest);
+    manifest.close();
+    if (err) {
+        log_e("Could not parse " ASSETS_MANIFEST ": %s", err.c_str());
+        return false;
+    }
+
+    for (JsonObject entry : doc["assets"].as<JsonArray>()) {
+        assets.push_back({
+            entry["path"].as<String>(),
+            entry["file"].as<String>(),
+            entry["type"].as<String>(),
+            entry["etag"].as<String>(),
+            entry["gzip"].as<bool>(),
+            entry["immutable"].as<bool>(),
+        });
+    }
+
+    for (const auto& asset : assets) {
+        if (asset.path == "/index.html")
+            index_asset = &asset;
+    }
+    if (!index_asset) {
+        log_w("No index.html in " ASSETS_MANIFEST);
+        return true;
+    }
+
+    File index = LittleFS.open(index_asset->file);
+    index_len = index.size();
+    index_data = index ? (uint8_t*)malloc(index_len) : nullptr;
+    if (!index_data || index.read(index_data, index_len) != index_len) {
+        log_w("Could not load index.html into RAM, serving it from flash");
+        free(index_data);
+        index_data = nullptr;
+    }
+    index.close();
+
+    log_i(
+        "Loaded %u dashboard assets, index.html is %u B", assets.size(), index_len
+    );
+    return true;
+}
+
+/**
+ * @brief Find a dashboard file by URL.
+ */
+static const asset_t*
+assets_find(const String& url)
+{
+    if (url == "/")
+        return index_asset;
+
+    for (const auto& asset : assets) {
+        if (asset.path == url)
+            return &asset;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Serves the dashboard files in the asset manifest.
+ *
+ * Hashed files never change, so they're cached forever. Everything else is
+ * revalidated with its ETag on every load, which costs a 304 and no flash reads.
+ */
+class AssetHandler : public AsyncWebHandler {
+ public:
+    bool
+    canHandle(AsyncWebServerRequest* req) override
+    {
+        if (req->method() != HTTP_GET || !assets_find(req->url()))
+            return false;
+
+        // Headers no handler asked for are dropped before handleRequest()
+        req->addInterestingHeader("If-None-Match");
+        return true;
+    }
+
+    void
+    handleRequest(AsyncWebServerRequest* req) override
+    {
+        const asset_t* asset = assets_find(req->url());
+        const char* cache_control = asset->immutable ? CACHE_IMMUTABLE : "no-cache";
+
+        if (req->hasHeader("If-None-Match")
+            && etag_matches(req->header("If-None-Match"), asset->etag)) {
+            auto* res = req->beginResponse(304);
+            res->addHeader("ETag", asset->etag);
+            res->addHeader("Cache-Control", cache_control);
+            return req->send(res);
+        }
+
+        AsyncWebServerResponse* res;
+        if (asset == index_asset && index_data)
+            res = req->beginResponse_P(200, asset->type, index_data, index_len);
+        else
+            res = req->beginResponse(LittleFS, asset->file, asset->type);
+
+        if (asset->gzip)
+            res->addHeader("Content-Encoding", "gzip");
+        res->addHeader("ETag", asset->etag);
+        res->addHeader("Cache-Control", cache_control);
+        req->send(res);
+    }
+};
+
+/**
+ * @brief Forget a live data client once it disconnects.
+ *
+ * Runs on the async_tcp task, in place of the library's own disconnect handler.
+ */
+static void
+sse_on_disconnect(void* arg, AsyncClient* tcp)
+{
+    auto* client = static_cast<AsyncEventSourceClient*>(arg);
+
+    xSemaphoreTakeRecursive(sse_lock, portMAX_DELAY);
+    for (auto& c : sse_clients) {
+        if (c.client == client) {
+            log_i(
+                "SSE client %s disconnected: %lu events sent, %lu dropped",
+                IPAddress(c.stats.ip).toString().c_str(), c.stats.sent,
+                c.stats.dropped
+            );
+            c.client = nullptr;
+        }
+    }
+
+    // Same as the library's handler, which this replaces
+    client->_onDisconnect();
+    delete tcp;
+    xSemaphoreGiveRecursive(sse_lock);
+}
+
+/**
+ * @brief Find the slot of a live data client.
+ *
+ * Must be called with sse_lock held.
+ */
+static sse_client_t*
+sse_find(AsyncEventSourceClient* client)
+{
+    for (auto& c : sse_clients) {
+        if (c.client == client)
+            return &c;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Send a client's pending sample, if its queue has room for it now.
+ *
+ * Must be called with sse_lock held.
+ */
+static void
+sse_flush_pending(sse_client_t& c)
+{
+    if (!c.pending_id || c.evicting || c.client->packetsWaiting() >= SSE_MAX_QUEUED)
+        return;
+
+    c.client->send(c.pending, "mpuData", c.pending_id);
+    c.stats.sent++;
+    metrics_bytes_sent(METRICS_EVENTS, strlen(c.pending));
+    c.pending_id = 0;
+    c.full_ms = 0;
+}
+
+/**
+ * @brief Send the pending sample as soon as the client acks part of its queue.
+ *
+ * Runs on the async_tcp task, in place of the library's own ack handler.
+ */
+static void
+sse_on_ack(void* arg, AsyncClient* tcp, size_t len, uint32_t time)
+{
+    auto* client = static_cast<AsyncEventSourceClient*>(arg);
+    client->_onAck(len, time); // Same as the library's handler
+
+    xSemaphoreTakeRecursive(sse_lock, portMAX_DELAY);
+    if (auto* c = sse_find(client))
+        sse_flush_pending(*c);
+    xSemaphoreGiveRecursive(sse_lock);
+}
+
+/**
+ * @brief Close the client if it's being evicted, or send its pending sample.
+ *
+ * Runs on the async_tcp task, in place of the library's own poll handler.
+ * Clients are only closed here, where nothing else can delete them, and without
+ * sse_lock held, since closing one disconnects it right away.
+ */
+static void
+sse_on_poll(void* arg, AsyncClient* tcp)
+{
+    auto* client = static_cast<AsyncEventSourceClient*>(arg);
+    client->_onPoll(); // Same as the library's handler
+
+    bool evict = false;
+    xSemaphoreTakeRecursive(sse_lock, portMAX_DELAY);
+    if (auto* c = sse_find(client)) {
+        evict = c->evicting;
+        sse_flush_pending(*c);
+    }
+    xSemaphoreGiveRecursive(sse_lock);
+
+    if (evict)
+        client->close();
+}
+
+/**
+ * @brief Start tracking a new live data client.
+ */
+static void
+sse_add_client(AsyncEventSourceClient* client)
+{
+    xSemaphoreTakeRecursive(sse_lock, portMAX_DELAY);
+    sse_client_t* slot = nullptr;
+    for (auto& c : sse_clients) {
+        if (!c.client) {
+            slot = &c;
+            break;
+        }
+    }
+
+    if (slot) {
+        uint32_t now = millis();
+        *slot = {};
+        slot->client = client;
+        slot->stats.ip = client->client()->remoteIP();
+        slot->connect_ms = slot->drained_ms = now;
+
+        // Find out when the client goes away, before the library deletes it
+        client->client()->onDisconnect(sse_on_disconnect, client);
+
+        // Send pending samples as soon as there's room, and evict from here
+        client->client()->onAck(sse_on_ack, client);
+        client->client()->onPoll(sse_on_poll, client);
+    } else {
+        log_w("Too many SSE clients, not sending live data to the new one");
+    }
+    xSemaphoreGiveRecursive(sse_lock);
+}
+
+static void
+send_replay_status(AsyncWebServerRequest* req)
+{
+    replay_status_t status;
+    replay_status(&status);
+
+    auto* res = req->beginResponseStream("application/json");
+    serializeJson(status.to_json(), *res);
+    req->send(res);
+}
+
 static void
-list_dir(String dir, AsyncWebServerRequest* req)
+send_latency(AsyncWebServerRequest* req)
 {
-    // Open dir
-    log_i("Opening directory \"%s\"", dir.c_str());
+    latency_summary_t summary;
+    latency_summary(&summary);
+
+    auto* res = req->beginResponseStream("application/json");
+    serializeJson(summary.to_json(), *res);
+    req->send(res);
+}
+
+static void
+send_calibration(AsyncWebServerRequest* req, int code = 200)
+{
+    mpu_calib_t state;
+    mpu_get_calibration(&state);
+
+    calib_t calibs[CALIB_BANDS];
+    bool stored[CALIB_BANDS];
+    size_t len = calib_list(calibs, stored, CALIB_BANDS);
 
-    File rec_dir = LittleFS.open(dir);
-    if (!rec_dir) {
-        // No files in directory - it doesn't exist
-        log_w("Directory %s does not exist", dir);
-        rec_dir.close();
-        return req->send(200, "application/json", "{\"files\":[]}");
+    DynamicJsonDocument doc(2048);
+    doc["temp"] = state.temp;
+    doc["tempBand"] = state.temp_band;
+    doc["requested"] = state.requested;
+    if (state.band >= 0) {
+        doc["band"] = state.band;
+        doc["offsets"] = state.offsets.to_json();
     }
 
-    if (!rec_dir.isDirectory()) {
-        log_e("Directory \"%s\" not a directory", dir.c_str());
-        rec_dir.close();
-        return req->send(500, "text/plain", "Could not open directory.");
+    auto bands = doc.createNestedArray("bands");
+    for (size_t i = 0; i < len; i++) {
+        if (!stored[i])
+            continue;
+        auto band = bands.createNestedObject();
+        band["band"] = i;
+        band["min"] = CALIB_BAND_MIN + i * CALIB_BAND_WIDTH;
+        band["offsets"] = calibs[i].to_json();
     }
 
+    auto* res = req->beginResponseStream("application/json");
+    res->setCode(code);
+    serializeJson(doc, *res);
+    req->send(res);
+}
+
+static void
+list_recordings(AsyncWebServerRequest* req)
+{
     // Allocate JSON
     log_d("Creating JSON document");
 
     DynamicJsonDocument doc(1024);
     auto files = doc.createNestedArray("files");
 
-    // Go through files
-    log_i("Walking files!");
+    // Go through recordings
+    log_i("Listing recordings!");
 
-    File f;
-    while (f = rec_dir.openNextFile()) {
-        char* filename = strdup(f.name());
-        log_d("Found file %s", filename);
-
-        files.add(filename);
-        f.close();
-    }
+    bool success = storage_list([&files](const char* name, size_t) {
+        log_d("Found recording %s", name);
+        files.add(String(name)); // Copy, the name may not outlive the callback
+    });
+    if (!success)
+        return req->send(500, "text/plain", "Could not list recordings.");
 
     // Check for overflow
     if (doc.overflowed()) {
@@ -92,71 +702,247 @@ list_dir(String dir, AsyncWebServerRequest* req)
     serializeJson(doc, *res);
     req->send(res);
 
-    log_i("Successfully listed directory");
+    log_i("Successfully listed recordings");
 }
 
 static void
-send_jsonified_data_file(String filename, AsyncWebServerRequest* req)
+send_raw_data_file(const String& name, AsyncWebServerRequest* req)
 {
-    // We should send the file converted to JSON
-    log_i("Opening file \"%s\"", filename.c_str());
+    log_i("Opening recording \"%s\"", name.c_str());
 
-    File file = LittleFS.open(filename);
-    if (!file || file.isDirectory()) {
-        log_e("Could not open recording file \"%s\"", filename);
-        file.close();
+    RecFile file = storage_open(name.c_str());
+    if (!file) {
+        log_e("Could not open recording file \"%s\"", name.c_str());
         return req->send(404, "text/plain", "Recording not found.");
     }
 
-    // Get file size
-    uint32_t num_points = file.size() / sizeof(mpu_data_t);
-    log_i("Found %lu datapoints in %s", num_points, filename.c_str());
+    // Closed recordings are identified by their random ID and length
+    size_t size = file.size();
+    String etag;
+    rec_header_t header;
+    if (!storage_is_recording(name.c_str()) && rec_read_header(file, &header))
+        etag = "\"" + String(header.id, HEX) + "-" + String(size, HEX) + "\"";
 
-    auto* res = req->beginChunkedResponse(
-        "application/json",
-        [file](uint8_t* buf, size_t max_len, size_t idx) mutable -> size_t {
-            // Write up to "maxLen" bytes into "buffer" and return the amount written.
-            // index equals the amount of bytes that have been already sent
-            // You will be asked for more data until 0 is returned
-            // Keep in mind that you can not delay or yield waiting for more data!
-            if (!file) // finished
-                return 0;
+    if (etag.length() && send_not_modified(req, etag)) {
+        file.close();
+        return;
+    }
 
-            size_t written = 0;
+    size_t start = 0, len = size;
+    switch (parse_range(req, etag, size, &start, &len)) {
+        case RANGE_INVALID:
+            file.close();
+            return send_range_not_satisfiable(req, size);
 
-            if (idx == 0) { // at start
-                const char header[] = "{\"data\":[";
-                size_t header_len = sizeof(header) - 1; // don't want NUL
+        case RANGE_OK:
+            log_i("Sending bytes %u-%u of %u", start, start + len - 1, size);
+            file.seek(start);
+            break;
 
-                memcpy(buf, header, header_len);
-                written += header_len;
-            }
+        default:
+            break;
+    }
 
-            if (!file.available()) {
-                buf[0] = ']';
-                buf[1] = '}';
-                log_d("Finished JSON, closing file");
+    auto* res = req->beginResponse(
+        "application/octet-stream", len,
+        [file](uint8_t* buf, size_t max_len, size_t) mutable -> size_t {
+            size_t len = file.read(buf, max_len);
+            if (!file.available())
                 file.close();
-                return 2;
-            }
+            return len;
+        }
+    );
+    if (len != size)
+        add_range_headers(res, start, len, size);
 
-            while (file.available()) {
-                mpu_data_t mpu_data;
-                file.read(reinterpret_cast<uint8_t*>(&mpu_data), sizeof(mpu_data));
-                auto doc = mpu_data.to_json();
+    res->addHeader("Accept-Ranges", "bytes");
+    if (etag.length()) {
+        res->addHeader("ETag", etag);
+        res->addHeader("Cache-Control", CACHE_IMMUTABLE);
+    } else {
+        res->addHeader("Cache-Control", "no-store"); // Still being recorded
+    }
+    res->addHeader("Content-Disposition", "attachment; filename=\"" + name + "\"");
+    req->send(res);
+}
+
+/**
+ * @brief Pick the export format from "?format=", then the Accept header.
+ *
+ * @return If the format was valid. Defaults to JSON if nothing was asked for.
+ */
+static bool
+negotiate_export_format(AsyncWebServerRequest* req, ExportFormat* format)
+{
+    *format = EXPORT_JSON;
 
-                size_t json_size = measureJson(doc) + 1; // json + comma
-                if (json_size > max_len - written)
-                    return written;
+    if (req->hasParam("format"))
+        return export_format_parse(req->getParam("format")->value(), format);
 
-                serializeJson(doc, buf + written, json_size);
-                written += json_size;
-                buf[written - 1] = ',';
-            }
-            log_d("Finished writing file");
-            return --written; // drop trailing comma
+    if (req->hasHeader("Accept")) {
+        const String& accept = req->header("Accept");
+        if (accept.indexOf("text/csv") >= 0)
+            *format = EXPORT_CSV;
+        else if (accept.indexOf("application/octet-stream") >= 0)
+            *format = EXPORT_BINARY;
+    }
+    return true;
+}
+
+static void
+send_exported_data_file(
+    const String& name, ExportFormat format, uint32_t from, uint32_t to,
+    uint16_t max_points, AsyncWebServerRequest* req
+)
+{
+    // We should send the file converted to JSON, CSV, or packed binary
+    log_i("Exporting recording \"%s\" as %s", name.c_str(), export_format_ext(format));
+
+    auto exporter = exporters.acquire_shared();
+    if (!exporter) {
+        log_w("Too many exports in progress, not exporting \"%s\"", name.c_str());
+        auto* res = req->beginResponse(
+            503, "text/plain", "Too many exports in progress, try again later."
+        );
+        res->addHeader("Retry-After", "5");
+        return req->send(res);
+    }
+
+    if (!exporter->begin(storage_open(name.c_str()), format)) {
+        log_e("Could not open recording file \"%s\"", name.c_str());
+        exporter->close();
+        return req->send(404, "text/plain", "Recording not found.");
+    }
+
+    // Compress on the fly for clients that can take it
+    bool gzip = accepts_gzip(req) && exporter->compress();
+
+    // The same recording and parameters always export the same bytes
+    String etag;
+    if (!storage_is_recording(name.c_str())) {
+        etag = "\"" + String(exporter->id(), HEX) + "-" + String(exporter->size(), HEX)
+               + "-" + export_format_ext(format) + "-" + String(from) + "-"
+               + String(to) + "-" + String(max_points) + (gzip ? "-gz" : "") + "\"";
+    }
+
+    if (etag.length() && send_not_modified(req, etag)) {
+        exporter->close();
+        return;
+    }
+
+    // Only send the requested part of the recording
+    if ((from || to != UINT32_MAX) && !exporter->seek(from, to)) {
+        log_e("Could not seek to %lu ms in \"%s\"", from, name.c_str());
+        exporter->close();
+        return req->send(500, "text/plain", "Could not seek in recording.");
+    }
+
+    // Only send a preview
+    if (max_points && !exporter->downsample(max_points)) {
+        log_e("Could not downsample \"%s\"", name.c_str());
+        exporter->close();
+        return req->send(500, "text/plain", "Could not downsample recording.");
+    }
+
+    // Ranges only work once we know how long the export is, from sending it
+    // in full before
+    const export_len_t* cached = etag.length() ? export_len_find(etag) : nullptr;
+    size_t size = cached ? cached->len : 0;
+    size_t start = 0, len = size;
+    RangeResult range = size ? parse_range(req, etag, size, &start, &len) : RANGE_NONE;
+    if (range == RANGE_INVALID) {
+        exporter->close();
+        return send_range_not_satisfiable(req, size);
+    }
+
+    AsyncWebServerResponse* res;
+    if (range == RANGE_OK) {
+        // Pick up from the last resume point before the range, if there is one
+        const export_resume_t* point = nullptr;
+        for (const auto& resume : cached->resumes) {
+            if (resume.out <= start)
+                point = &resume;
         }
-    );
+        if (point && !max_points && !exporter->resume(*point)) {
+            log_e("Could not resume export of \"%s\"", name.c_str());
+            exporter->close();
+            return req->send(500, "text/plain", "Could not seek in recording.");
+        }
+
+        log_i(
+            "Sending bytes %u-%u of %u, from %u", start, start + len - 1, size,
+            exporter->bytes()
+        );
+        size_t end = start + len;
+        res = req->beginResponse(
+            export_format_mime(format), len,
+            [exporter, start, end](uint8_t* buf, size_t max_len, size_t) -> size_t {
+                // Regenerate up to the start of the range, a bit at a time
+                if (exporter->bytes() < start) {
+                    size_t skip = 0;
+                    while (skip < EXPORT_SKIP_BUDGET && exporter->bytes() < start) {
+                        size_t len = min(max_len, start - exporter->bytes());
+                        if (!(len = exporter->fill(buf, len)))
+                            return 0; // Shorter than last time?
+                        skip += len;
+                    }
+                    return RESPONSE_TRY_AGAIN;
+                }
+
+                size_t len = exporter->fill(buf, max_len);
+                if (exporter->bytes() >= end)
+                    exporter->close();
+                metrics_bytes_sent(METRICS_EXPORTS, len);
+                return len;
+            }
+        );
+        add_range_headers(res, start, len, size);
+    } else {
+        uint32_t start_ms = millis();
+        res = req->beginChunkedResponse(
+            export_format_mime(format),
+            [exporter, etag, start_ms](uint8_t* buf, size_t max_len, size_t) -> size_t {
+                // Fills the whole chunk, carrying over whatever doesn't fit
+                size_t len = exporter->fill(buf, max_len);
+                metrics_bytes_sent(METRICS_EXPORTS, len);
+                if (!len) {
+                    log_i(
+                        "Exported %lu samples in %lu B (%lu B uncompressed, %.1f%%) "
+                        "in %lu ms, closing file",
+                        exporter->samples(), exporter->bytes(), exporter->raw_bytes(),
+                        exporter->raw_bytes() ? 100.0f * exporter->bytes()
+                                                    / exporter->raw_bytes()
+                                              : 0,
+                        millis() - start_ms
+                    );
+                    if (etag.length())
+                        export_len_save(etag, *exporter);
+                    exporter->close();
+                }
+                return len;
+            }
+        );
+    }
+
+    res->addHeader("Vary", "Accept, Accept-Encoding");
+    if (gzip)
+        res->addHeader("Content-Encoding", "gzip");
+    if (etag.length()) {
+        res->addHeader("ETag", etag);
+        res->addHeader("Cache-Control", CACHE_IMMUTABLE);
+        if (size)
+            res->addHeader("Accept-Ranges", "bytes");
+    } else {
+        res->addHeader("Cache-Control", "no-store"); // Still being recorded
+    }
+    if (format != EXPORT_JSON) {
+        // Name the download after the recording, e.g. "<name>.csv"
+        String filename = name.substring(0, name.lastIndexOf('.')) + "."
+                          + export_format_ext(format);
+        res->addHeader(
+            "Content-Disposition", "attachment; filename=\"" + filename + "\""
+        );
+    }
     req->send(res);
 
 #if 0
@@ -251,32 +1037,192 @@ web_server_setup()
     server.on("/recordings", HTTP_GET, [](AsyncWebServerRequest* req) {
         // Check if we should list the directory
         if (req->url().length() <= 12) // "/recordings" or "/recordings/"
-            return list_dir("/recs", req);
+            return list_recordings(req);
 
         // Send a specific file
-        String filename = "/recs/" + req->url().substring(12);
+        String name = req->url().substring(12);
 
         // Check if we should send the raw data file
         if (req->hasParam("raw")) {
             log_i("Raw file requested.");
-            return req->send(LittleFS, filename, "", true);
+            return send_raw_data_file(name, req);
+        }
+        // Time bounds, in ms since the start of the recording
+        uint32_t from = 0, to = UINT32_MAX;
+        if (req->hasParam("from"))
+            from = req->getParam("from")->value().toInt();
+        if (req->hasParam("to"))
+            to = req->getParam("to")->value().toInt();
+
+        // Downsample to at most this many points, for previews
+        uint16_t max_points = 0;
+        if (req->hasParam("maxPoints")) {
+            long val = req->getParam("maxPoints")->value().toInt();
+            if (val < 2)
+                return req->send(400, "text/plain", "maxPoints must be at least 2.");
+            max_points = min<long>(val, UINT16_MAX);
         }
-        return send_jsonified_data_file(filename, req);
+
+        ExportFormat format;
+        if (!negotiate_export_format(req, &format))
+            return req->send(400, "text/plain", "Format must be json, csv or bin.");
+
+        return send_exported_data_file(name, format, from, to, max_points, req);
+    });
+
+    server.on("/recordings", HTTP_POST, [](AsyncWebServerRequest* req) {
+        // Only /recordings/<name>/replay
+        String name = req->url().substring(12);
+        if (!name.endsWith("/replay"))
+            return req->send(404, "text/plain", "Not found.");
+        name = name.substring(0, name.length() - 7);
+
+        float speed = 1;
+        if (req->hasParam("speed")) {
+            speed = req->getParam("speed")->value().toFloat();
+            if (speed < 1 || speed > REPLAY_MAX_SPEED)
+                return req->send(
+                    400, "text/plain",
+                    "speed must be 1 to " + String(REPLAY_MAX_SPEED) + "."
+                );
+        }
+        uint32_t from = 0;
+        if (req->hasParam("from"))
+            from = req->getParam("from")->value().toInt();
+
+        // Still being written, and too close to the live data anyway
+        if (storage_is_recording(name.c_str()))
+            return req->send(409, "text/plain", "Recording in progress.");
+
+        if (!replay_start(name.c_str(), speed, from))
+            return req->send(404, "text/plain", "Could not replay recording.");
+
+        send_replay_status(req);
+    });
+
+    server.on("/replay", HTTP_GET, [](AsyncWebServerRequest* req) {
+        send_replay_status(req);
+    });
+
+    server.on("/replay", HTTP_DELETE, [](AsyncWebServerRequest* req) {
+        replay_stop();
+        send_replay_status(req);
     });
 
     server.on("/recordings", HTTP_DELETE, [](AsyncWebServerRequest* req) {
-        StaticJsonDocument<16> doc;
-        doc["success"] = data_clear_recordings();
+        // Deleting blocks on flash erases, so hand it to the storage worker
+        uint32_t job;
+        if (req->url().length() <= 12) // "/recordings" or "/recordings/"
+            job = jobs_submit(JOB_CLEAR);
+        else
+            job = jobs_submit(JOB_DELETE, req->url().substring(12).c_str());
+
+        if (!job)
+            return req->send(503, "text/plain", "Too many storage jobs, try again.");
+
+        StaticJsonDocument<32> doc;
+        doc["job"] = job;
 
         // Send it
         auto* res = req->beginResponseStream("application/json");
+        res->setCode(202);
+        res->addHeader("Location", "/jobs/" + String(job));
         serializeJson(doc, *res);
         req->send(res);
+    });
 
-        if (doc["success"])
-            log_i("Successfully cleared recordings");
-        else
-            log_e("Failed to clear recordings");
+    server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest* req) {
+        // Prometheus text format, written a line at a time
+        auto writer = metrics_writers.acquire_shared();
+        if (!writer)
+            return req->send(503, "text/plain", "Too many scrapes in progress.");
+        writer->begin();
+
+        auto* res = req->beginChunkedResponse(
+            "text/plain; version=0.0.4",
+            [writer](uint8_t* buf, size_t max_len, size_t) -> size_t {
+                return writer->fill(buf, max_len);
+            }
+        );
+        res->addHeader("Cache-Control", "no-store");
+        req->send(res);
+    });
+
+#ifdef NET_BENCH
+    /**
+     * Network self-tests
+     */
+    server.on("/bench/download", HTTP_GET, netbench_download);
+    server.on(
+        "/bench/upload", HTTP_POST, netbench_upload, nullptr, netbench_upload_body
+    );
+    server.on("/bench/events", HTTP_POST, netbench_events);
+    server.on("/bench", HTTP_GET, netbench_results);
+#endif
+
+    server.on("/calibration", HTTP_GET, [](AsyncWebServerRequest* req) {
+        send_calibration(req);
+    });
+
+    server.on("/calibration", HTTP_POST, [](AsyncWebServerRequest* req) {
+        // Runs on the sampling task, which owns the MPU
+        mpu_request_calibration();
+        send_calibration(req, 202);
+    });
+
+    server.on("/calibration", HTTP_DELETE, [](AsyncWebServerRequest* req) {
+        if (!calib_clear())
+            return req->send(500, "text/plain", "Could not clear the calibration.");
+        send_calibration(req);
+    });
+
+    server.on("/latency", HTTP_GET, [](AsyncWebServerRequest* req) {
+        send_latency(req);
+    });
+
+    server.on("/latency", HTTP_POST, [](AsyncWebServerRequest* req) {
+        latency_enable(true);
+        send_latency(req);
+    });
+
+    server.on("/latency", HTTP_DELETE, [](AsyncWebServerRequest* req) {
+        latency_enable(false);
+        send_latency(req);
+    });
+
+    server.on("/time", HTTP_GET, [](AsyncWebServerRequest* req) {
+        timesync_t sync;
+        timesync_get(&sync);
+
+        auto* res = req->beginResponseStream("application/json");
+        serializeJson(sync.to_json(), *res);
+        req->send(res);
+    });
+
+    server.on("/tasks", HTTP_GET, [](AsyncWebServerRequest* req) {
+        task_stats_t stats[TASK_COUNT];
+        size_t len = tasks_stats(stats, TASK_COUNT);
+
+        auto* res = req->beginResponseStream("application/json");
+        res->print('[');
+        for (size_t i = 0; i < len; i++) {
+            if (i)
+                res->print(',');
+            serializeJson(stats[i].to_json(), *res);
+        }
+        res->print(']');
+        req->send(res);
+    });
+
+    server.on("/jobs", HTTP_GET, [](AsyncWebServerRequest* req) {
+        job_t job;
+        uint32_t id = req->url().substring(6).toInt(); // After "/jobs/"
+        if (!jobs_status(id, &job))
+            return req->send(404, "text/plain", "Job not found.");
+
+        auto* res = req->beginResponseStream("application/json");
+        serializeJson(job.to_json(), *res);
+        req->send(res);
     });
 
     /**
@@ -285,23 +1231,29 @@ web_server_setup()
     // Redirect index.html to root
     server.rewrite("/index.html", "/");
 
-    // Get last modified time
-    File index = LittleFS.open("/index.html.gz");
-    time_t last_modified = index.getLastWrite();
-    index.close();
+    // Dashboard files from the manifest, with ETags and index.html in RAM
+    if (assets_load())
+        server.addHandler(new AssetHandler());
+    else
+        log_w("No " ASSETS_MANIFEST ", serving the dashboard without ETags");
 
-    // Setup static file handler
+    // Anything else on LittleFS
     server.serveStatic("/", LittleFS, "/")
         .setDefaultFile("index.html")
-        .setLastModified(gmtime(&last_modified))
         .setCacheControl("public, max-age=604800, no-cache, "
                          "stale-if-error=86400, stale-while-revalidate=86400");
 
     /**
      * Server-side events
      */
+    sse_lock = xSemaphoreCreateRecursiveMutex();
+    if (!sse_lock) {
+        log_e("Could not create the SSE client lock");
+        return false;
+    }
+
     events.onConnect([](AsyncEventSourceClient* client) {
-        IPAddress ip = client->client()->localIP();
+        IPAddress ip = client->client()->remoteIP();
 
         if (client->lastId())
             log_i(
@@ -314,9 +1266,30 @@ web_server_setup()
         // send event with message {"connected":true}, id current millis
         // and set reconnect delay to 1 second
         client->send("", NULL, millis(), 1000);
+
+        sse_add_client(client);
     });
     server.addHandler(&events);
 
+    server.on("/events/clients", HTTP_GET, [](AsyncWebServerRequest* req) {
+        sse_client_stats_t stats[SSE_MAX_CLIENTS];
+        size_t len = web_server_sse_clients(stats, SSE_MAX_CLIENTS);
+
+        // Write the array by hand, a document per client
+        auto* res = req->beginResponseStream("application/json");
+        res->printf(
+            "{\"evicted\":%lu,\"avgQueued\":%u,\"clients\":[", sse_evicted,
+            web_server_sse_avg_queued()
+        );
+        for (size_t i = 0; i < len; i++) {
+            if (i)
+                res->print(',');
+            serializeJson(stats[i].to_json(), *res);
+        }
+        res->print("]}");
+        req->send(res);
+    });
+
     /**
      * Start the server
      */
@@ -325,12 +1298,189 @@ web_server_setup()
     return true; // success
 }
 
+StaticJsonDocument<192>
+sse_client_stats_t::to_json() const
+{
+    StaticJsonDocument<192> doc;
+
+    doc["ip"] = IPAddress(ip).toString();
+    doc["connected"] = connected;
+    doc["sent"] = sent;
+    doc["dropped"] = dropped;
+    doc["queued"] = queued;
+    doc["maxQueued"] = max_queued;
+    doc["lag"] = lag;
+
+    return doc;
+}
+
+/**
+ * @brief Send an event to every live data client with room in its queue.
+ *
+ * Clients with SSE_MAX_QUEUED events already waiting skip the event, and ones
+ * that stay that way for SSE_EVICT_MS are evicted.
+ *
+ * @param latest If this is a sample. Clients that are full keep the newest one,
+ * and get it as soon as there's room, instead of skipping it.
+ */
+static void
+sse_send(const char* name, const char* msg, uint32_t id, bool latest)
+{
+    if (!sse_lock || !events.count())
+        return;
+
+    size_t msg_len = strlen(msg);
+    uint32_t now = millis();
+    if (!id)
+        id = now;
+    xSemaphoreTakeRecursive(sse_lock, portMAX_DELAY);
+    for (auto& c : sse_clients) {
+        if (!c.client || c.evicting)
+            continue;
+
+        // The older sample goes first, if there's room now
+        if (latest)
+            sse_flush_pending(c);
+
+        size_t queued = c.client->packetsWaiting();
+        c.stats.queued = queued;
+        c.stats.max_queued = max<uint16_t>(c.stats.max_queued, queued);
+        if (!queued)
+            c.drained_ms = now;
+
+        if (queued < SSE_MAX_QUEUED) {
+            c.full_ms = 0;
+            c.client->send(msg, name, id);
+            c.stats.sent++;
+            metrics_bytes_sent(METRICS_EVENTS, msg_len);
+            continue;
+        }
+
+        // The client isn't keeping up. Only the newest sample is worth sending
+        // once there's room, so it replaces any older one still pending.
+        if (latest && msg_len < sizeof(c.pending)) {
+            if (c.pending_id)
+                c.stats.dropped++;
+            memcpy(c.pending, msg, msg_len + 1);
+            c.pending_id = id;
+        } else {
+            c.stats.dropped++;
+        }
+
+        if (!c.full_ms) {
+            c.full_ms = now;
+        } else if (now - c.full_ms > SSE_EVICT_MS) {
+            log_w(
+                "Evicting SSE client %s: %u events queued for %lu ms, %lu dropped",
+                IPAddress(c.stats.ip).toString().c_str(), queued, now - c.full_ms,
+                c.stats.dropped
+            );
+            sse_evicted++;
+
+            // Stop sending to it, and close it on its next poll
+            c.evicting = true;
+            c.pending_id = 0;
+        }
+    }
+    xSemaphoreGiveRecursive(sse_lock);
+}
+
+void
+web_server_send_event(const char* name, const JsonDocument& json, uint32_t id)
+{
+    if (!sse_lock || !events.count())
+        return;
+
+    xSemaphoreTakeRecursive(sse_lock, portMAX_DELAY);
+    if (measureJson(json) < SSE_MSG_SIZE) {
+        serializeJson(json, sse_msg, SSE_MSG_SIZE);
+        web_server_send_event(name, sse_msg, id);
+    } else {
+        log_w("\"%s\" event is too long to send", name);
+    }
+    xSemaphoreGiveRecursive(sse_lock);
+}
+
+void
+web_server_send_sample(const mpu_data_t& meas, int64_t dequeued_us)
+{
+    if (!sse_lock || !events.count())
+        return;
+
+    // Samples that weren't just measured (e.g. replayed) can't be traced
+    bool trace = latency_enabled() && meas.time_us && dequeued_us;
+    auto doc = meas.to_json();
+
+    xSemaphoreTakeRecursive(sse_lock, portMAX_DELAY);
+    if (measureJson(doc) + SSE_TRACE_SIZE >= SSE_MSG_SIZE) {
+        log_w("\"mpuData\" event is too long to send");
+        xSemaphoreGiveRecursive(sse_lock);
+        return;
+    }
+    size_t len = serializeJson(doc, sse_msg, SSE_MSG_SIZE);
+
+    latency_trace_t t;
+    if (trace) {
+        t.isr_us = meas.time_us;
+        t.decoded_us = meas.time_us + meas.decoded_us;
+        t.dequeued_us = dequeued_us;
+        t.encoded_us = esp_timer_get_time();
+
+        // Now that it's encoded, swap the closing brace for the trace
+        snprintf(
+            sse_msg + len - 1, SSE_MSG_SIZE - len + 1, ",\"trace\":[%lu,%lu,%lu]}",
+            (uint32_t)(t.decoded_us - t.isr_us), (uint32_t)(t.dequeued_us - t.isr_us),
+            (uint32_t)(t.encoded_us - t.isr_us)
+        );
+    }
+
+    sse_send("mpuData", sse_msg, meas.time, true);
+
+    if (trace) {
+        t.sent_us = esp_timer_get_time();
+        latency_record(t);
+    }
+    xSemaphoreGiveRecursive(sse_lock);
+}
+
 void
-web_server_send_event(const char* name, const JsonDocument& json)
+web_server_send_event(const char* name, const char* msg, uint32_t id)
 {
-    String msg;
-    serializeJson(json, msg);
+    sse_send(name, msg, id, false);
+}
 
-    events.send(msg.c_str(), name, millis());
-    // log_d("Free heap: %lu B/%lu B", ESP.getFreeHeap(), ESP.getHeapSize());
+size_t
+web_server_sse_clients(sse_client_stats_t* stats, size_t max_len)
+{
+    if (!sse_lock)
+        return 0;
+
+    size_t len = 0;
+    uint32_t now = millis();
+
+    xSemaphoreTakeRecursive(sse_lock, portMAX_DELAY);
+    for (auto& c : sse_clients) {
+        if (!c.client || c.evicting || len >= max_len)
+            continue;
+
+        c.stats.connected = now - c.connect_ms;
+        c.stats.queued = c.client->packetsWaiting();
+        c.stats.lag = c.stats.queued ? now - c.drained_ms : 0;
+        stats[len++] = c.stats;
+    }
+    xSemaphoreGiveRecursive(sse_lock);
+
+    return len;
+}
+
+uint32_t
+web_server_sse_evicted()
+{
+    return sse_evicted;
+}
+
+size_t
+web_server_sse_avg_queued()
+{
+    return events.count() ? events.avgPacketsWaiting() : 0;
 }
@@ -0,0 +1,916 @@
+/**
+ * @file storage.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Recording storage backends.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "storage.hpp"
+
+#include "config.h"
+#include "recording.hpp"
+
+#include <esp_partition.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <unistd.h>
+
+// Directory of the LittleFS recordings
+#define REC_DIR "/recs"
+
+// Holds the name of the LittleFS recording in progress, so we can tell if we were
+// interrupted
+#define REC_OPEN_MARKER REC_DIR "/.open"
+
+// Where LittleFS is mounted in the VFS
+#define LITTLEFS_MOUNT "/littlefs"
+
+// Index entry states. Each state only clears bits of the previous one, so
+// entries can be updated in place without erasing the index sector.
+#define ENTRY_FREE    0xFF // Never written
+#define ENTRY_OPEN    0x7F // Currently (or was, if we crashed) being recorded
+#define ENTRY_CLOSED  0x3F // Recording completed
+#define ENTRY_DELETED 0x00 // Recording removed
+
+/**
+ * @brief An entry in the on-flash index of the raw recording partition.
+ */
+struct part_entry_t {
+    uint8_t state;      // ENTRY_*
+    uint8_t reserved[3];
+    uint32_t start;     // Partition offset of the first byte
+    uint32_t size;      // Length, in bytes
+    char name[32];      // Recording name (NUL-terminated)
+    uint32_t reserved2; // Pad to 48 bytes
+};
+
+static_assert(sizeof(part_entry_t) == 48, "Index entries must be 48 bytes");
+
+/**
+ * @brief Marks an index sector as complete, in the last bytes of the sector.
+ *
+ * The index is double-buffered. Compacting it writes the live entries to the
+ * other sector and then this footer, with a higher generation, so a crash part
+ * way through leaves the old index in charge.
+ */
+struct part_footer_t {
+    uint32_t magic;       // PART_INDEX_MAGIC
+    uint32_t gen;         // The sector with the highest generation is current
+    uint32_t reserved[2]; // Pad to 16 bytes
+};
+
+#define PART_INDEX_MAGIC 0x58444952 // "RIDX"
+
+// Where the footer is in each index sector
+#define PART_FOOTER_OFFSET (SPI_FLASH_SEC_SIZE - sizeof(part_footer_t))
+
+// Number of entries in an index sector
+#define PART_INDEX_LEN (PART_FOOTER_OFFSET / sizeof(part_entry_t))
+
+// Offset of the first data byte in the partition, after both index sectors
+#define PART_DATA_START (2 * SPI_FLASH_SEC_SIZE)
+
+// Recordings start on a sector, so their REC_ALIGN boundaries line up with sectors
+static_assert(REC_ALIGN % SPI_FLASH_SEC_SIZE == 0, "REC_ALIGN must be whole sectors");
+
+/******************************************************************************/
+
+// The raw recording partition, if there is one
+static const esp_partition_t* rec_part = nullptr;
+
+// Copy of the on-flash index
+static part_entry_t part_index[PART_INDEX_LEN];
+
+// Number of used entries in the index
+static size_t part_index_len = 0;
+
+// Which index sector is current, and its generation
+static size_t part_index_sector = 0;
+static uint32_t part_index_gen = 0;
+
+// Everything between the start of the recording in progress and this offset is
+// already erased
+static uint32_t part_erased_to = PART_DATA_START;
+
+// Name of the LittleFS recording being written, if any
+static char lfs_recording[32] = "";
+
+// Holds the recording sequence number
+static Preferences prefs;
+static uint32_t next_seq = 1;
+
+// Guards all of the above, which the sampling loop, the web server, and the
+// storage worker all touch
+static SemaphoreHandle_t storage_mutex = nullptr;
+
+/**
+ * @brief Holds the storage mutex while in scope.
+ */
+class StorageLock {
+ public:
+    StorageLock()
+    {
+        if (storage_mutex)
+            xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    }
+
+    ~StorageLock()
+    {
+        if (storage_mutex)
+            xSemaphoreGive(storage_mutex);
+    }
+};
+
+/******************************************************************************/
+
+static inline uint32_t
+align_up(uint32_t val, uint32_t align)
+{
+    return (val + align - 1) / align * align;
+}
+
+static bool
+part_write_entry_field(size_t slot, size_t field_offset, const void* val, size_t len)
+{
+    uint32_t addr = part_index_sector * SPI_FLASH_SEC_SIZE
+                  + slot * sizeof(part_entry_t) + field_offset;
+    return esp_partition_write(rec_part, addr, val, len) == ESP_OK;
+}
+
+static bool
+part_set_state(size_t slot, uint8_t state)
+{
+    part_index[slot].state = state;
+    return part_write_entry_field(slot, offsetof(part_entry_t, state), &state, 1);
+}
+
+static inline bool
+part_is_live(const part_entry_t& entry)
+{
+    return entry.state == ENTRY_OPEN || entry.state == ENTRY_CLOSED;
+}
+
+/**
+ * @brief Write the in-RAM index to the other index sector, and make it current.
+ */
+static bool
+part_write_index()
+{
+    size_t sector = 1 - part_index_sector;
+    uint32_t addr = sector * SPI_FLASH_SEC_SIZE;
+
+    if (esp_partition_erase_range(rec_part, addr, SPI_FLASH_SEC_SIZE) != ESP_OK)
+        return false;
+
+    if (part_index_len
+        && esp_partition_write(
+               rec_part, addr, part_index, part_index_len * sizeof(part_entry_t)
+           ) != ESP_OK)
+        return false;
+
+    // Written last, so the sector only counts once everything else is there
+    part_footer_t footer = {PART_INDEX_MAGIC, part_index_gen + 1, {0, 0}};
+    addr += PART_FOOTER_OFFSET;
+    if (esp_partition_write(rec_part, addr, &footer, sizeof(footer)) != ESP_OK)
+        return false;
+
+    part_index_sector = sector;
+    part_index_gen = footer.gen;
+    return true;
+}
+
+static bool
+part_reset()
+{
+    log_i("Starting a new recording partition index");
+
+    memset(part_index, 0xFF, sizeof(part_index));
+    part_index_len = 0;
+
+    return part_write_index();
+}
+
+/**
+ * @brief Load the current index sector.
+ */
+static bool
+part_load()
+{
+    int current = -1;
+    part_footer_t footers[2];
+    for (size_t i = 0; i < 2; i++) {
+        auto& footer = footers[i];
+        uint32_t addr = i * SPI_FLASH_SEC_SIZE + PART_FOOTER_OFFSET;
+        if (esp_partition_read(rec_part, addr, &footer, sizeof(footer)) != ESP_OK)
+            return false;
+
+        if (footer.magic == PART_INDEX_MAGIC
+            && (current < 0 || footer.gen > footers[current].gen))
+            current = i;
+    }
+
+    if (current < 0) {
+        log_w("No recording partition index");
+        return part_reset();
+    }
+    part_index_sector = current;
+    part_index_gen = footers[current].gen;
+
+    uint32_t addr = part_index_sector * SPI_FLASH_SEC_SIZE;
+    if (esp_partition_read(rec_part, addr, part_index, sizeof(part_index)) != ESP_OK)
+        return false;
+
+    for (part_index_len = 0; part_index_len < PART_INDEX_LEN; part_index_len++) {
+        const auto& entry = part_index[part_index_len];
+        if (entry.state == ENTRY_FREE)
+            break;
+
+        if (entry.start < PART_DATA_START || entry.start >= rec_part->size) {
+            log_e("Corrupt recording partition index, resetting");
+            return part_reset();
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Drop the deleted entries from the index, to free up their slots.
+ *
+ * Entries move, so this can't run while a recording is in progress.
+ *
+ * @return If any slots were freed.
+ */
+static bool
+part_compact()
+{
+    size_t live = 0;
+    for (size_t i = 0; i < part_index_len; i++) {
+        if (part_index[i].state == ENTRY_OPEN)
+            return false;
+        if (part_index[i].state == ENTRY_CLOSED)
+            live++;
+    }
+    if (live == part_index_len)
+        return false;
+
+    log_i("Compacting recording partition index (%u of %u live)", live, part_index_len);
+
+    size_t len = 0;
+    for (size_t i = 0; i < part_index_len; i++) {
+        if (part_index[i].state == ENTRY_CLOSED)
+            part_index[len++] = part_index[i];
+    }
+    memset(part_index + len, 0xFF, (PART_INDEX_LEN - len) * sizeof(part_entry_t));
+    part_index_len = len;
+
+    if (!part_write_index()) {
+        log_e("Could not compact recording partition index");
+        part_load(); // Back to what is on flash
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Get a free index slot, compacting the index if it is full.
+ *
+ * @return The slot, or -1 if there are none.
+ */
+static int
+part_alloc_slot()
+{
+    if (part_index_len >= PART_INDEX_LEN && !part_compact())
+        return -1;
+
+    return part_index_len;
+}
+
+static int
+part_find(const char* name)
+{
+    for (size_t i = 0; i < part_index_len; i++) {
+        const auto& entry = part_index[i];
+        if (part_is_live(entry) && strncmp(entry.name, name, sizeof(entry.name)) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Find where the first recording after an offset starts.
+ *
+ * @return The partition offset, or the partition size if there is none.
+ */
+static uint32_t
+part_next_start(uint32_t offset)
+{
+    uint32_t next = rec_part->size;
+    for (size_t i = 0; i < part_index_len; i++) {
+        const auto& entry = part_index[i];
+        if (part_is_live(entry) && entry.start > offset)
+            next = min(next, entry.start);
+    }
+    return next;
+}
+
+/**
+ * @brief Get the (sector aligned) end of the space a recording takes up.
+ *
+ * A recording in progress can grow up to the next recording, so it holds on to
+ * all of that space.
+ */
+static uint32_t
+part_entry_end(const part_entry_t& entry)
+{
+    if (entry.state == ENTRY_OPEN)
+        return part_next_start(entry.start);
+
+    return align_up(entry.start + entry.size, SPI_FLASH_SEC_SIZE);
+}
+
+/**
+ * @brief Find the largest free extent of the partition.
+ *
+ * Space is freed as soon as its recording is removed, so recordings fill the
+ * gaps left by older ones instead of only ever being added at the end.
+ *
+ * @param end Set to the end of the extent.
+ * @return The start of the extent.
+ */
+static uint32_t
+part_find_space(uint32_t* end)
+{
+    uint32_t best = PART_DATA_START;
+    *end = PART_DATA_START;
+
+    uint32_t offset = PART_DATA_START;
+    while (offset < rec_part->size) {
+        // Skip over the recording the offset is in, if any
+        bool used = false;
+        for (size_t i = 0; i < part_index_len && !used; i++) {
+            const auto& entry = part_index[i];
+            uint32_t entry_end = part_entry_end(entry);
+            if (part_is_live(entry) && entry.start <= offset && offset < entry_end) {
+                offset = entry_end;
+                used = true;
+            }
+        }
+        if (used)
+            continue;
+
+        uint32_t next = part_next_start(offset);
+        if (next - offset > *end - best) {
+            best = offset;
+            *end = next;
+        }
+        offset = next;
+    }
+    return best;
+}
+
+/**
+ * @brief Count the bytes taken up by recordings on the partition.
+ */
+static uint32_t
+part_used()
+{
+    uint32_t used = 0;
+    for (size_t i = 0; i < part_index_len; i++) {
+        if (part_index[i].state == ENTRY_CLOSED)
+            used += align_up(part_index[i].size, SPI_FLASH_SEC_SIZE);
+    }
+    return used;
+}
+
+/******************************************************************************/
+
+/**
+ * @brief Recover a partition recording that was never closed.
+ *
+ * Keeps everything up to the last intact block and closes it off.
+ */
+void
+part_recover(size_t slot)
+{
+    auto& entry = part_index[slot];
+
+    // Let the recovery read up to the next recording
+    RecFile rec;
+    uint32_t max_len = part_next_start(entry.start) - entry.start;
+    rec.backend_ = STORAGE_PARTITION;
+    rec.slot_ = slot;
+    rec.start_ = entry.start;
+    rec.size_ = max_len;
+    strlcpy(rec.name_, entry.name, sizeof(rec.name_));
+
+    uint32_t size = rec_recover(rec, max_len);
+
+    if (!size) {
+        log_w("Interrupted recording %s is unreadable, removing", entry.name);
+        part_set_state(slot, ENTRY_DELETED);
+        entry.size = 0;
+        return;
+    }
+    log_w("Closing interrupted recording %s (%lu B)", entry.name, size);
+
+    entry.size = size;
+    part_write_entry_field(slot, offsetof(part_entry_t, size), &size, 4);
+    part_set_state(slot, ENTRY_CLOSED);
+}
+
+/**
+ * @brief Recover the LittleFS recording that was being written when we were
+ * interrupted.
+ *
+ * LittleFS only keeps what was written before the last sync, so this cuts off any
+ * partial block after it.
+ */
+static void
+littlefs_recover()
+{
+    File marker = LittleFS.open(REC_OPEN_MARKER);
+    String name = marker ? marker.readString() : "";
+    marker.close();
+    LittleFS.remove(REC_OPEN_MARKER);
+
+    RecFile rec = storage_open(name.c_str());
+    if (!name.length() || !rec) {
+        log_w("Interrupted recording %s is missing", name.c_str());
+        return;
+    }
+
+    size_t size = rec.size();
+    uint32_t len = rec_recover(rec, size);
+    rec.close();
+
+    if (!len) {
+        log_w("Interrupted recording %s is unreadable, removing", name.c_str());
+        storage_remove(name.c_str());
+        return;
+    }
+    log_w("Closing interrupted recording %s (%lu B)", name.c_str(), len);
+
+    if (len < size) {
+        // fs::File can't truncate, go through the VFS
+        String path = LITTLEFS_MOUNT REC_DIR "/" + name;
+        if (truncate(path.c_str(), len) != 0)
+            log_w("Could not truncate %s, the reader will skip its tail", path.c_str());
+    }
+}
+
+/******************************************************************************/
+
+size_t
+RecFile::write(const uint8_t* buf, size_t len)
+{
+    if (backend_ == STORAGE_LITTLEFS)
+        return file_.write(buf, len);
+
+    if (!writable_)
+        return 0;
+
+    StorageLock lock;
+
+    // Don't run into the next recording
+    uint32_t addr = start_ + pos_;
+    if (addr + len > end_)
+        len = end_ - addr;
+
+    // Erase the sectors we're about to write to
+    if (addr + len > part_erased_to) {
+        uint32_t erase_len = align_up(addr + len - part_erased_to, SPI_FLASH_SEC_SIZE);
+        if (esp_partition_erase_range(rec_part, part_erased_to, erase_len) != ESP_OK) {
+            log_e("Erasing recording partition failed at %#x", part_erased_to);
+            return 0;
+        }
+        part_erased_to += erase_len;
+    }
+
+    if (esp_partition_write(rec_part, addr, buf, len) != ESP_OK) {
+        log_e("Writing recording partition failed at %#x", addr);
+        return 0;
+    }
+
+    pos_ += len;
+    size_ = max(size_, pos_);
+    part_index[slot_].size = size_; // Only in RAM until we're closed
+    return len;
+}
+
+size_t
+RecFile::read(uint8_t* buf, size_t len)
+{
+    if (backend_ == STORAGE_LITTLEFS)
+        return file_.read(buf, len);
+
+    if (slot_ < 0)
+        return 0;
+
+    len = min<size_t>(len, size_ - pos_);
+    if (esp_partition_read(rec_part, start_ + pos_, buf, len) != ESP_OK)
+        return 0;
+
+    pos_ += len;
+    return len;
+}
+
+bool
+RecFile::seek(uint32_t pos)
+{
+    if (backend_ == STORAGE_LITTLEFS)
+        return file_.seek(pos);
+
+    if (pos > size_)
+        return false;
+
+    pos_ = pos;
+    return true;
+}
+
+size_t
+RecFile::position() const
+{
+    return backend_ == STORAGE_LITTLEFS ? file_.position() : pos_;
+}
+
+size_t
+RecFile::size() const
+{
+    return backend_ == STORAGE_LITTLEFS ? file_.size() : size_;
+}
+
+int
+RecFile::available()
+{
+    if (backend_ == STORAGE_LITTLEFS)
+        return file_.available();
+
+    return slot_ >= 0 ? size_ - pos_ : 0;
+}
+
+void
+RecFile::flush()
+{
+    if (backend_ == STORAGE_LITTLEFS)
+        file_.flush();
+
+    // Partition writes go straight to flash
+}
+
+void
+RecFile::close()
+{
+    StorageLock lock;
+
+    if (backend_ == STORAGE_LITTLEFS) {
+        if (writable_) {
+            // Everything is on flash now, we weren't interrupted
+            LittleFS.remove(REC_OPEN_MARKER);
+            lfs_recording[0] = '\0';
+            writable_ = false;
+        }
+        return file_.close();
+    }
+
+    if (writable_) {
+        // Finalize the index entry
+        part_index[slot_].size = size_;
+        part_write_entry_field(slot_, offsetof(part_entry_t, size), &size_, 4);
+        part_set_state(slot_, ENTRY_CLOSED);
+
+        writable_ = false;
+    }
+    slot_ = -1;
+}
+
+const char*
+RecFile::name() const
+{
+    return backend_ == STORAGE_LITTLEFS ? file_.name() : name_;
+}
+
+RecFile::operator bool() const
+{
+    return backend_ == STORAGE_LITTLEFS ? (bool)file_ : slot_ >= 0;
+}
+
+/******************************************************************************/
+
+bool
+storage_setup()
+{
+    storage_mutex = xSemaphoreCreateMutex();
+
+    if (prefs.begin(REC_NVS_NAMESPACE))
+        next_seq = prefs.getUInt("seq", 1);
+    else
+        log_e("Could not open the recording sequence number");
+
+    if (LittleFS.exists(REC_OPEN_MARKER))
+        littlefs_recover();
+
+    rec_part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, REC_PARTITION_LABEL
+    );
+    if (!rec_part) {
+#ifdef REC_USE_PARTITION
+        log_w("No \"%s\" partition, only recording to LittleFS", REC_PARTITION_LABEL);
+#else
+        log_i("No \"%s\" partition, only recording to LittleFS", REC_PARTITION_LABEL);
+#endif
+        return true;
+    }
+    log_i(
+        "Found recording partition at %#x (%lu KB)", rec_part->address,
+        rec_part->size / 1024
+    );
+
+    if (!part_load()) {
+        log_e("Could not read recording partition index");
+        rec_part = nullptr;
+        return false;
+    }
+
+    // Only once the whole index is loaded, so we know where the next recording is
+    for (size_t i = 0; i < part_index_len; i++) {
+        if (part_index[i].state == ENTRY_OPEN)
+            part_recover(i);
+    }
+
+    log_i("%u recording partition entries, %lu B used", part_index_len, part_used());
+    return true;
+}
+
+bool
+storage_has_partition()
+{
+    return rec_part != nullptr;
+}
+
+RecFile
+storage_open(const char* name)
+{
+    StorageLock lock;
+
+    RecFile rec;
+
+    int slot;
+    if (rec_part && (slot = part_find(name)) >= 0) {
+        const auto& entry = part_index[slot];
+
+        rec.backend_ = STORAGE_PARTITION;
+        rec.slot_ = slot;
+        rec.start_ = entry.start;
+        rec.size_ = entry.size;
+        strlcpy(rec.name_, entry.name, sizeof(rec.name_));
+        return rec;
+    }
+
+    String path = REC_DIR "/" + String(name);
+    if (!LittleFS.exists(path))
+        return rec;
+
+    rec.backend_ = STORAGE_LITTLEFS;
+    rec.file_ = LittleFS.open(path);
+    if (rec.file_ && rec.file_.isDirectory())
+        rec.file_.close();
+
+    return rec;
+}
+
+RecFile
+storage_create(const char* name, StorageBackend backend)
+{
+    StorageLock lock;
+
+    RecFile rec;
+
+    if (backend == STORAGE_PARTITION && !rec_part) {
+        log_w("No recording partition, falling back to LittleFS");
+        backend = STORAGE_LITTLEFS;
+    }
+
+    if (backend == STORAGE_LITTLEFS) {
+        // Remember what we're recording, in case we get interrupted
+        File marker = LittleFS.open(REC_OPEN_MARKER, "w", true);
+        if (marker) {
+            marker.print(name);
+            marker.close();
+        }
+
+        rec.backend_ = STORAGE_LITTLEFS;
+        rec.file_ = LittleFS.open(REC_DIR "/" + String(name), "w", true);
+        rec.writable_ = (bool)rec.file_;
+        if (rec.writable_)
+            strlcpy(lfs_recording, name, sizeof(lfs_recording));
+        else
+            LittleFS.remove(REC_OPEN_MARKER);
+        return rec;
+    }
+
+    int slot = part_alloc_slot();
+    if (slot < 0) {
+        log_e("Recording partition index is full");
+        return rec;
+    }
+
+    uint32_t end;
+    uint32_t start = part_find_space(&end);
+    if (end - start < 2 * REC_ALIGN) {
+        log_e("Recording partition is full");
+        return rec;
+    }
+
+    auto& entry = part_index[slot];
+
+    memset(&entry, 0xFF, sizeof(entry));
+    entry.state = ENTRY_OPEN;
+    entry.start = start;
+    strlcpy(entry.name, name, sizeof(entry.name));
+
+    // The on-flash size stays erased until the recording is closed
+    if (!part_write_entry_field(slot, 0, &entry, sizeof(entry))) {
+        log_e("Could not write recording partition index");
+        memset(&entry, 0xFF, sizeof(entry));
+        return rec;
+    }
+    entry.size = 0;
+    part_index_len++;
+    part_erased_to = start;
+
+    rec.backend_ = STORAGE_PARTITION;
+    rec.slot_ = slot;
+    rec.start_ = start;
+    rec.end_ = end;
+    rec.writable_ = true;
+    strlcpy(rec.name_, entry.name, sizeof(rec.name_));
+    return rec;
+}
+
+bool
+storage_list(storage_list_cb_t cb)
+{
+    StorageLock lock;
+
+    for (size_t i = 0; rec_part && i < part_index_len; i++) {
+        const auto& entry = part_index[i];
+        if (entry.state == ENTRY_OPEN || entry.state == ENTRY_CLOSED)
+            cb(entry.name, entry.size);
+    }
+
+    File rec_dir = LittleFS.open(REC_DIR);
+    if (!rec_dir) // No recordings yet
+        return true;
+
+    if (!rec_dir.isDirectory()) {
+        log_e("Directory \"%s\" not a directory", REC_DIR);
+        rec_dir.close();
+        return false;
+    }
+
+    File f;
+    while (f = rec_dir.openNextFile()) {
+        if (f.name()[0] != '.') // Skip the open marker
+            cb(f.name(), f.size());
+        f.close();
+    }
+
+    rec_dir.close();
+    return true;
+}
+
+bool
+storage_is_recording(const char* name)
+{
+    StorageLock lock;
+
+    int slot;
+    if (rec_part && (slot = part_find(name)) >= 0)
+        return part_index[slot].state == ENTRY_OPEN;
+
+    return strcmp(name, lfs_recording) == 0;
+}
+
+bool
+storage_remove(const char* name, size_t* freed)
+{
+    StorageLock lock;
+
+    if (freed)
+        *freed = 0;
+
+    int slot;
+    if (rec_part && (slot = part_find(name)) >= 0) {
+        const auto& entry = part_index[slot];
+        if (entry.state == ENTRY_OPEN) {
+            log_w("Cannot remove %s while it is being recorded", name);
+            return false;
+        }
+        if (!part_set_state(slot, ENTRY_DELETED))
+            return false;
+
+        // Its space is free for the next recording from here on, unless an
+        // interrupted rename left another entry for it
+        bool shared = false;
+        for (size_t i = 0; i < part_index_len; i++) {
+            if (part_is_live(part_index[i]) && part_index[i].start == entry.start)
+                shared = true;
+        }
+        if (freed && !shared)
+            *freed = align_up(entry.size, SPI_FLASH_SEC_SIZE);
+        return true;
+    }
+
+    if (strcmp(name, lfs_recording) == 0) {
+        log_w("Cannot remove %s while it is being recorded", name);
+        return false;
+    }
+
+    // LittleFS works in whole blocks, and may share some with metadata
+    size_t used = LittleFS.usedBytes();
+    if (!LittleFS.remove(REC_DIR "/" + String(name)))
+        return false;
+
+    if (freed)
+        *freed = used - min(used, LittleFS.usedBytes());
+    return true;
+}
+
+bool
+storage_rename(const char* name, const char* new_name)
+{
+    StorageLock lock;
+
+    int slot;
+    if (rec_part && (slot = part_find(name)) >= 0) {
+        if (part_index[slot].state == ENTRY_OPEN) {
+            log_w("Cannot rename %s while it is being recorded", name);
+            return false;
+        }
+
+        // Compacting moves entries, so look the recording up again afterwards
+        int new_slot = part_alloc_slot();
+        if (new_slot < 0) {
+            log_e("Recording partition index is full");
+            return false;
+        }
+        slot = part_find(name);
+
+        auto& entry = part_index[new_slot];
+
+        entry = part_index[slot];
+        memset(entry.name, 0, sizeof(entry.name));
+        strlcpy(entry.name, new_name, sizeof(entry.name));
+
+        // Add the new entry before removing the old one, so a crash in between
+        // leaves a duplicate instead of losing the recording
+        if (!part_write_entry_field(new_slot, 0, &entry, sizeof(entry))) {
+            log_e("Could not write recording partition index");
+            memset(&entry, 0xFF, sizeof(entry));
+            return false;
+        }
+        part_index_len++;
+
+        return part_set_state(slot, ENTRY_DELETED);
+    }
+
+    if (strcmp(name, lfs_recording) == 0) {
+        log_w("Cannot rename %s while it is being recorded", name);
+        return false;
+    }
+    return LittleFS.rename(REC_DIR "/" + String(name), REC_DIR "/" + String(new_name));
+}
+
+uint32_t
+storage_next_seq()
+{
+    StorageLock lock;
+
+    uint32_t seq = next_seq++;
+    if (!prefs.putUInt("seq", next_seq))
+        log_w("Could not save the recording sequence number");
+    return seq;
+}
@@ -0,0 +1,331 @@
+/**
+ * @file tasks.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Task layout and per-task statistics.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "tasks.hpp"
+
+#include "config.h"
+#include "data.hpp"
+#include "heap.hpp"
+#include "metrics.hpp"
+#include "mpu.hpp"
+#include "serialstream.hpp"
+
+#include <esp_timer.h>
+
+/******************************************************************************/
+
+/**
+ * @brief Everything we keep track of for a task.
+ */
+struct task_slot_t {
+    const char* name;              // Used to find tasks we didn't start
+    TaskHandle_t task = nullptr;   // The task, if registered
+    QueueHandle_t queue = nullptr; // Queue it reads from, if any
+    uint16_t queue_len = 0;        // Size of the queue
+    uint16_t max_queued = 0;       // Most items waiting at once
+    uint32_t dropped = 0;          // Items that didn't fit
+    uint32_t runs = 0;             // Work items processed
+    uint32_t alloc_runs = 0;       // Work items that allocated
+    uint64_t busy_us = 0;          // Time spent working
+    uint64_t window_us = 0;        // busy_us at the start of the window
+    float cpu = 0;                 // Share of a core over the last window
+};
+
+// Every task, by TaskId
+static task_slot_t slots[TASK_COUNT] = {
+    {"acquire"}, {"data"}, {"storage"}, {"loopTask"}, {"asyncTcpSock"},
+};
+
+// The counters are updated from every task
+static portMUX_TYPE tasks_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Start of the CPU share window
+static uint32_t window_start_ms = 0;
+
+/******************************************************************************/
+
+/**
+ * @brief Read samples from the MPU and hand them to the data task.
+ */
+static void
+acquire_task(void*)
+{
+    bool blink_state = false;
+    heap_check_watch();
+
+    while (true) {
+        mpu_data_t mpu_data;
+
+#ifdef TEST_WEBSERVER
+        delay(1000);
+        uint32_t start = micros();
+        uint32_t allocs = heap_check_allocs();
+
+        mpu_data.time_us = esp_timer_get_time();
+        mpu_data.time = mpu_data.time_us / 1000;
+        for (size_t i = 0; i < 3; i++)
+            mpu_data.ypr[i] = esp_random() / (float)UINT32_MAX * PI;
+        mpu_data.accel = VectorFloat(esp_random() % 20, esp_random() % 20, 9.81);
+        mpu_data.gyro = VectorFloat(esp_random() % 100, esp_random() % 100, 0);
+#else
+        // Read a packet from the FIFO, sleeping until the next one if there isn't one
+        if (!mpu_data_available()) {
+            mpu_wait_data(MPU_SAMPLE_RATE);
+            continue;
+        }
+        uint32_t start = micros();
+        uint32_t allocs = heap_check_allocs();
+
+        // When the packet was ready, not when we got to it
+        mpu_data.time_us = mpu_packet_time();
+        mpu_data.time = mpu_data.time_us / 1000;
+
+        // Get yaw, pitch, and roll
+        mpu_get_ypr(mpu_data.ypr);
+
+        // Get real acceleration (i.e., no gravity)
+        mpu_get_real_accel(&mpu_data.accel);
+
+        // Get gyroscope reading
+        mpu_get_gyro(&mpu_data.gyro);
+#endif
+
+        mpu_data.decoded_us = esp_timer_get_time() - mpu_data.time_us;
+        metrics_sample(mpu_data.time);
+
+        // Send off the data to be processed
+        tasks_send(TASK_DATA, &mpu_data);
+        serialstream_send(mpu_data);
+
+        // blink LED to indicate activity
+        blink_state = !blink_state;
+        digitalWrite(LED_PIN, blink_state);
+
+        tasks_busy(TASK_ACQUIRE, micros() - start, heap_check_allocs() - allocs);
+
+#ifndef TEST_WEBSERVER
+        // Not counted above, calibrating takes seconds
+        mpu_calibration_loop(
+            mpu_data.accel, mpu_data.gyro, data_is_recording() || serialstream_active()
+        );
+
+#  if MPU_SAMPLE_RATE > 70   // We overflow the FIFO buffer and need to compensate
+        delay(MPU_SAMPLE_RATE - 12);
+#  elif MPU_SAMPLE_RATE > 10 // Default sample rate is 10ms
+        delay(MPU_SAMPLE_RATE - 2);
+#  endif
+#endif
+    }
+}
+
+/**
+ * @brief Stream or record the samples from the acquisition task.
+ */
+static void
+data_task(void*)
+{
+    QueueHandle_t queue = slots[TASK_DATA].queue;
+    mpu_data_t mpu_data;
+    heap_check_watch();
+
+    while (true) {
+        if (xQueueReceive(queue, &mpu_data, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        uint32_t start = micros();
+        uint32_t allocs = heap_check_allocs();
+        data_process_measurement(mpu_data);
+        tasks_busy(TASK_DATA, micros() - start, heap_check_allocs() - allocs);
+    }
+}
+
+/******************************************************************************/
+
+StaticJsonDocument<256>
+task_stats_t::to_json() const
+{
+    StaticJsonDocument<256> doc;
+
+    doc["name"] = name;
+    doc["core"] = core;
+    doc["priority"] = priority;
+    if (cpu >= 0)
+        doc["cpu"] = cpu;
+    doc["stackFree"] = stack_free;
+    doc["runs"] = runs;
+#ifdef HEAP_CHECK
+    doc["allocRuns"] = alloc_runs;
+#endif
+    if (queue_len) {
+        doc["queued"] = queued;
+        doc["maxQueued"] = max_queued;
+        doc["queueLen"] = queue_len;
+        doc["dropped"] = dropped;
+    }
+
+    return doc;
+}
+
+bool
+tasks_setup()
+{
+    QueueHandle_t queue = xQueueCreate(DATA_QUEUE_LEN, sizeof(mpu_data_t));
+    if (!queue) {
+        log_e("Could not create the sample queue");
+        return false;
+    }
+
+    TaskHandle_t task;
+    BaseType_t res = xTaskCreatePinnedToCore(
+        data_task, "data", DATA_TASK_STACK, nullptr, DATA_TASK_PRIORITY, &task,
+        TASKS_IO_CORE
+    );
+    if (res != pdPASS) {
+        log_e("Could not start the data task");
+        return false;
+    }
+    tasks_register(TASK_DATA, task, queue);
+
+    res = xTaskCreatePinnedToCore(
+        acquire_task, "acquire", ACQ_TASK_STACK, nullptr, ACQ_TASK_PRIORITY, &task,
+        TASKS_ACQ_CORE
+    );
+    if (res != pdPASS) {
+        log_e("Could not start the acquisition task");
+        return false;
+    }
+    tasks_register(TASK_ACQUIRE, task);
+
+    return true;
+}
+
+void
+tasks_register(TaskId id, TaskHandle_t task, QueueHandle_t queue)
+{
+    uint16_t queue_len =
+        queue ? uxQueueMessagesWaiting(queue) + uxQueueSpacesAvailable(queue) : 0;
+
+    portENTER_CRITICAL(&tasks_mux);
+    slots[id].task = task;
+    slots[id].queue = queue;
+    slots[id].queue_len = queue_len;
+    portEXIT_CRITICAL(&tasks_mux);
+}
+
+bool
+tasks_send(TaskId id, const void* item)
+{
+    auto& slot = slots[id];
+    if (!slot.queue)
+        return false;
+
+    bool ok = xQueueSend(slot.queue, item, 0) == pdTRUE;
+    uint16_t queued = uxQueueMessagesWaiting(slot.queue);
+
+    portENTER_CRITICAL(&tasks_mux);
+    if (!ok)
+        slot.dropped++;
+    if (queued > slot.max_queued)
+        slot.max_queued = queued;
+    portEXIT_CRITICAL(&tasks_mux);
+
+    return ok;
+}
+
+void
+tasks_busy(TaskId id, uint32_t us, uint32_t allocs)
+{
+    auto& slot = slots[id];
+    bool first = false;
+
+    portENTER_CRITICAL(&tasks_mux);
+    slot.runs++;
+    slot.busy_us += us;
+    if (allocs) {
+        first = !slot.alloc_runs;
+        slot.alloc_runs++;
+    }
+    portEXIT_CRITICAL(&tasks_mux);
+
+    if (first)
+        log_w("The %s task allocated %lu times in one run", slot.name, allocs);
+}
+
+void
+tasks_loop()
+{
+    uint32_t now = millis();
+    uint32_t elapsed = now - window_start_ms;
+    if (elapsed < TASKS_WINDOW_MS)
+        return;
+
+    portENTER_CRITICAL(&tasks_mux);
+    for (auto& slot : slots) {
+        slot.cpu = (slot.busy_us - slot.window_us) / (elapsed * 1e3f);
+        slot.window_us = slot.busy_us;
+    }
+    portEXIT_CRITICAL(&tasks_mux);
+
+    window_start_ms = now;
+}
+
+size_t
+tasks_stats(task_stats_t* stats, size_t max_len)
+{
+    size_t len = 0;
+
+    for (size_t i = 0; i < TASK_COUNT && len < max_len; i++) {
+        portENTER_CRITICAL(&tasks_mux);
+        task_slot_t slot = slots[i];
+        portEXIT_CRITICAL(&tasks_mux);
+
+        TaskHandle_t task = slot.task ? slot.task : xTaskGetHandle(slot.name);
+        if (!task)
+            continue;
+
+        auto& s = stats[len++];
+        s.name = slot.name;
+        BaseType_t core = xTaskGetAffinity(task);
+        s.core = core == tskNO_AFFINITY ? -1 : core;
+        s.priority = uxTaskPriorityGet(task);
+        // Tasks that never report any work aren't measured
+        s.cpu = slot.runs ? slot.cpu : -1;
+        // ESP-IDF reports the high water mark in bytes, not words
+        s.stack_free = uxTaskGetStackHighWaterMark(task);
+        s.runs = slot.runs;
+        s.alloc_runs = slot.alloc_runs;
+        s.dropped = slot.dropped;
+        s.queued = slot.queue ? uxQueueMessagesWaiting(slot.queue) : 0;
+        s.max_queued = slot.max_queued;
+        s.queue_len = slot.queue_len;
+    }
+
+    return len;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file timesync.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Mapping device time to epoch time.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "timesync.hpp"
+
+#include "config.h"
+
+#include <Arduino.h>
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+
+// Updated from the SNTP callback, read by the sampling and web server tasks
+static timesync_t sync_state = {};
+static portMUX_TYPE sync_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/******************************************************************************/
+
+int64_t
+timesync_t::to_epoch(int64_t t) const
+{
+    int64_t elapsed = t - timer_us;
+    return epoch_us + elapsed + elapsed * drift_ppb / 1000000000LL;
+}
+
+StaticJsonDocument<128>
+timesync_t::to_json() const
+{
+    StaticJsonDocument<128> doc;
+    doc["synced"] = syncs > 0;
+    doc["syncs"] = syncs;
+    doc["timerUs"] = timer_us;
+    doc["epochUs"] = epoch_us;
+    doc["driftPpb"] = drift_ppb;
+    return doc;
+}
+
+/******************************************************************************/
+
+/**
+ * @brief Take a new sync point, right after SNTP set the clock.
+ *
+ * Runs on the lwIP task.
+ */
+static void
+on_time_sync(struct timeval*)
+{
+    // gettimeofday() takes a lock, so bracket it instead of reading both clocks
+    // in a critical section
+    struct timeval tv;
+    int64_t before = esp_timer_get_time();
+    gettimeofday(&tv, nullptr);
+    int64_t timer_us = before + (esp_timer_get_time() - before) / 2;
+
+    timesync_t prev;
+    timesync_get(&prev);
+
+    timesync_t next = prev;
+    next.timer_us = timer_us;
+    next.epoch_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    next.syncs++;
+
+    // How far off the last mapping was, and over how long
+    int64_t elapsed = timer_us - prev.timer_us;
+    int64_t error_us = next.epoch_us - prev.to_epoch(timer_us);
+
+    if (!prev.syncs) {
+        log_i("Time synced, drift unknown until the next sync");
+    } else if (elapsed < (int64_t)TIMESYNC_MIN_INTERVAL * 1000) {
+        log_d("Time synced after only %lld ms, keeping the drift", elapsed / 1000);
+    } else {
+        // The device clock was off by error_us on top of the drift we assumed
+        int64_t ppb = prev.drift_ppb + error_us * 1000000000LL / elapsed;
+        if (llabs(ppb) > (int64_t)TIMESYNC_MAX_DRIFT_PPM * 1000) {
+            log_w("Clock stepped by %lld ms, resetting the drift", error_us / 1000);
+            next.drift_ppb = 0;
+        } else {
+            next.drift_ppb += (ppb - prev.drift_ppb) / TIMESYNC_DRIFT_SMOOTHING;
+            log_i(
+                "Time synced, %lld us off after %lld s, drift %.2f ppm", error_us,
+                elapsed / 1000000, next.drift_ppb / 1000.0
+            );
+        }
+    }
+
+    portENTER_CRITICAL(&sync_mux);
+    sync_state = next;
+    portEXIT_CRITICAL(&sync_mux);
+}
+
+/******************************************************************************/
+
+void
+timesync_setup()
+{
+    sntp_set_time_sync_notification_cb(on_time_sync);
+}
+
+bool
+timesync_get(timesync_t* sync)
+{
+    portENTER_CRITICAL(&sync_mux);
+    *sync = sync_state;
+    portEXIT_CRITICAL(&sync_mux);
+    return sync->syncs > 0;
+}
+
+bool
+timesync_to_epoch(int64_t timer_us, int64_t* epoch_us)
+{
+    timesync_t sync;
+    if (!timesync_get(&sync))
+        return false;
+
+    *epoch_us = sync.to_epoch(timer_us);
+    return true;
+}
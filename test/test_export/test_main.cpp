@@ -0,0 +1,340 @@
+/**
+ * @file test_main.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Chunked export tests.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "export.hpp"
+#include "recording.hpp"
+#include "storage.hpp"
+
+#include <esp_rom_crc.h>
+#include <native_shim.h>
+#include <unity.h>
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+
+// Samples in the test recording
+#define SAMPLES 3000
+
+// Samples with values that aren't finite
+#define NAN_SAMPLE 10
+#define INF_SAMPLE 20
+
+static RecWriter writer;
+static RecExporter exporter;
+static std::vector<mpu_data_t> samples;
+
+static mpu_data_t
+make_sample(size_t i)
+{
+    mpu_data_t sample = {};
+    sample.ypr[0] = sinf(i * 0.01f);
+    sample.ypr[1] = cosf(i * 0.013f);
+    sample.ypr[2] = i * 0.001f;
+    sample.accel = VectorFloat(i % 7, sinf(i), 9.81f);
+    sample.gyro = VectorFloat(0.1f * (i % 13), 0, -1);
+    sample.time_us = 2000000 + i * MPU_SAMPLE_RATE * 1000;
+    sample.time = sample.time_us / 1000;
+
+    if (i == NAN_SAMPLE)
+        sample.accel.x = NAN;
+    if (i == INF_SAMPLE)
+        sample.gyro.z = -INFINITY;
+    return sample;
+}
+
+/**
+ * @brief Export the test recording, a chunk at a time.
+ *
+ * @param format The export format.
+ * @param compress If the export should be gzipped.
+ * @param chunk The size of the chunks to ask for.
+ * @param from If given, the resume point to start from.
+ * @param points If given, filled with the export's resume points.
+ */
+static std::string
+export_all(
+    ExportFormat format, bool compress, size_t chunk = 1460,
+    const export_resume_t* from = nullptr, std::vector<export_resume_t>* points = nullptr
+)
+{
+    TEST_ASSERT_TRUE(exporter.begin(storage_open("test.dat"), format));
+    if (compress)
+        TEST_ASSERT_TRUE(exporter.compress());
+    if (from)
+        TEST_ASSERT_TRUE(exporter.resume(*from));
+
+    std::string out;
+    std::vector<uint8_t> buf(chunk);
+    size_t len;
+    while ((len = exporter.fill(buf.data(), chunk))) {
+        TEST_ASSERT_LESS_OR_EQUAL(chunk, len);
+        out.append(reinterpret_cast<char*>(buf.data()), len);
+    }
+
+    if (points) {
+        size_t count;
+        auto* list = exporter.resume_points(&count);
+        points->assign(list, list + count);
+    }
+    exporter.close();
+    return out;
+}
+
+static uint32_t
+get_u32(const std::string& str, size_t pos)
+{
+    uint32_t val;
+    memcpy(&val, str.data() + pos, sizeof(val));
+    return val;
+}
+
+/**
+ * @brief Decompress a gzip stream with zlib.
+ */
+static std::string
+gunzip(const std::string& gz)
+{
+    z_stream zs = {};
+    TEST_ASSERT_EQUAL(Z_OK, inflateInit2(&zs, 16 + MAX_WBITS)); // gzip wrapper
+    zs.next_in = (Bytef*)gz.data();
+    zs.avail_in = gz.size();
+
+    std::string out;
+    char buf[4096];
+    int ret;
+    do {
+        zs.next_out = (Bytef*)buf;
+        zs.avail_out = sizeof(buf);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        TEST_ASSERT_TRUE(ret == Z_OK || ret == Z_STREAM_END);
+        out.append(buf, sizeof(buf) - zs.avail_out);
+    } while (ret != Z_STREAM_END);
+
+    // Nothing after the end of the stream
+    TEST_ASSERT_EQUAL(0, zs.avail_in);
+    inflateEnd(&zs);
+    return out;
+}
+
+/**
+ * @brief Get a line of a CSV export.
+ */
+static std::string
+csv_line(const std::string& csv, size_t line)
+{
+    size_t start = 0;
+    while (line--)
+        start = csv.find('\n', start) + 1;
+    return csv.substr(start, csv.find('\n', start) - start);
+}
+
+/******************************************************************************/
+
+void
+setUp()
+{
+    native_shim_reset();
+    TEST_ASSERT_TRUE(storage_setup());
+
+    samples.clear();
+    TEST_ASSERT_TRUE(writer.begin(storage_create("test.dat", STORAGE_PARTITION)));
+    for (size_t i = 0; i < SAMPLES; i++) {
+        samples.push_back(make_sample(i));
+        TEST_ASSERT_TRUE(writer.write(samples.back()));
+    }
+    writer.close();
+}
+
+void
+tearDown()
+{
+}
+
+static void
+test_chunk_sizes()
+{
+    static const size_t chunks[] = {1, 13, EXPORT_CARRY_SIZE, 4096};
+
+    for (int format = EXPORT_JSON; format <= EXPORT_BINARY; format++) {
+        for (bool compress : {false, true}) {
+            auto expected = export_all((ExportFormat)format, compress);
+            for (size_t chunk : chunks)
+                TEST_ASSERT_TRUE(expected == export_all((ExportFormat)format, compress, chunk));
+        }
+    }
+}
+
+static void
+test_csv()
+{
+    auto csv = export_all(EXPORT_CSV, false);
+    TEST_ASSERT_EQUAL_STRING(
+        "time,yaw,pitch,roll,accel_x,accel_y,accel_z,gyro_x,gyro_y,gyro_z",
+        csv_line(csv, 0).c_str()
+    );
+    TEST_ASSERT_EQUAL(SAMPLES + 1, std::count(csv.begin(), csv.end(), '\n'));
+
+    // A sample in degrees
+    const auto& first = samples[1];
+    unsigned long time;
+    float yaw, pitch, roll;
+    sscanf(csv_line(csv, 2).c_str(), "%lu,%f,%f,%f", &time, &yaw, &pitch, &roll);
+    TEST_ASSERT_EQUAL_UINT32(first.time, time);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, degrees(first.ypr[0]), yaw);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, degrees(first.ypr[1]), pitch);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, degrees(first.ypr[2]), roll);
+
+    // Values that aren't finite are left empty
+    std::string line = csv_line(csv, NAN_SAMPLE + 1);
+    TEST_ASSERT_NOT_EQUAL(std::string::npos, line.find(",,"));
+    line = csv_line(csv, INF_SAMPLE + 1);
+    TEST_ASSERT_EQUAL_CHAR(',', line.back());
+}
+
+static void
+test_json()
+{
+    auto json = export_all(EXPORT_JSON, false);
+    TEST_ASSERT_EQUAL(0, json.find("{\"data\":[{\"ypr\":["));
+    TEST_ASSERT_EQUAL(json.size() - 2, json.rfind("]}"));
+
+    size_t count = 0;
+    for (size_t pos = 0; (pos = json.find("\"time\":", pos)) != std::string::npos; pos++)
+        count++;
+    TEST_ASSERT_EQUAL(SAMPLES, count);
+
+    // Values that aren't finite are null, which is still valid JSON
+    TEST_ASSERT_EQUAL(2, [&] {
+        size_t nulls = 0;
+        for (size_t pos = 0; (pos = json.find("null", pos)) != std::string::npos; pos++)
+            nulls++;
+        return nulls;
+    }());
+    TEST_ASSERT_EQUAL(std::string::npos, json.find("nan"));
+    TEST_ASSERT_EQUAL(std::string::npos, json.find("inf"));
+}
+
+static void
+test_binary()
+{
+    auto bin = export_all(EXPORT_BINARY, false);
+    TEST_ASSERT_EQUAL(
+        sizeof(export_bin_header_t) + SAMPLES * sizeof(export_bin_sample_t), bin.size()
+    );
+    TEST_ASSERT_EQUAL_HEX32(EXPORT_BIN_MAGIC, get_u32(bin, 0));
+
+    for (size_t i = 0; i < SAMPLES; i++) {
+        export_bin_sample_t packed;
+        memcpy(
+            &packed, bin.data() + sizeof(export_bin_header_t) + i * sizeof(packed),
+            sizeof(packed)
+        );
+        TEST_ASSERT_EQUAL_UINT32(samples[i].time, packed.time);
+        TEST_ASSERT_EQUAL_MEMORY(&samples[i].accel, packed.accel, sizeof(packed.accel));
+    }
+}
+
+static void
+test_gzip()
+{
+    for (int format = EXPORT_JSON; format <= EXPORT_BINARY; format++) {
+        auto raw = export_all((ExportFormat)format, false);
+        auto gz = export_all((ExportFormat)format, true);
+
+        // The gzip trailer has the CRC and length of what was compressed
+        TEST_ASSERT_EQUAL_HEX8(0x1f, gz[0]);
+        TEST_ASSERT_EQUAL_HEX8(0x8b, (uint8_t)gz[1]);
+        TEST_ASSERT_EQUAL_HEX32(
+            esp_rom_crc32_le(0, (const uint8_t*)raw.data(), raw.size()),
+            get_u32(gz, gz.size() - 8)
+        );
+        TEST_ASSERT_EQUAL_UINT32(raw.size(), get_u32(gz, gz.size() - 4));
+        TEST_ASSERT_LESS_THAN(raw.size(), gz.size());
+
+        // And the deflate stream itself decodes to it
+        TEST_ASSERT_TRUE(gunzip(gz) == raw);
+    }
+}
+
+static void
+test_resume()
+{
+    for (int format = EXPORT_JSON; format <= EXPORT_BINARY; format++) {
+        for (bool compress : {false, true}) {
+            std::vector<export_resume_t> points;
+            auto full = export_all((ExportFormat)format, compress, 1460, nullptr, &points);
+            TEST_ASSERT_GREATER_THAN(0, points.size());
+
+            // Every resume point picks up exactly where the full export was
+            for (const auto& point : points) {
+                auto tail = export_all((ExportFormat)format, compress, 1000, &point);
+                TEST_ASSERT_TRUE(full.compare(point.out, std::string::npos, tail) == 0);
+            }
+        }
+    }
+}
+
+static void
+test_seek()
+{
+    uint32_t from = 20000, to = 40000;
+    TEST_ASSERT_TRUE(exporter.begin(storage_open("test.dat"), EXPORT_BINARY));
+    TEST_ASSERT_TRUE(exporter.seek(from, to));
+
+    size_t bytes = 0, len;
+    uint8_t buf[1460];
+    while ((len = exporter.fill(buf, sizeof(buf))))
+        bytes += len;
+    exporter.close();
+
+    size_t expected = 0;
+    for (const auto& s : samples) {
+        uint32_t t = s.time - samples.front().time;
+        expected += t >= from && t <= to;
+    }
+    TEST_ASSERT_EQUAL(
+        sizeof(export_bin_header_t) + expected * sizeof(export_bin_sample_t), bytes
+    );
+}
+
+int
+main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_chunk_sizes);
+    RUN_TEST(test_csv);
+    RUN_TEST(test_json);
+    RUN_TEST(test_binary);
+    RUN_TEST(test_gzip);
+    RUN_TEST(test_resume);
+    RUN_TEST(test_seek);
+    return UNITY_END();
+}
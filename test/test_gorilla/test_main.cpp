@@ -0,0 +1,253 @@
+/**
+ * @file test_main.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Gorilla compression round-trip tests.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "config.h"
+#include "gorilla.hpp"
+
+#include <unity.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief A sample, the way the encoder takes it.
+ */
+struct sample_t {
+    uint32_t time;
+    uint16_t time_us;
+    float values[GORILLA_CHANNELS];
+};
+
+static uint32_t rand_state;
+
+static uint32_t
+next_rand()
+{
+    rand_state = rand_state * 1664525 + 1013904223;
+    return rand_state;
+}
+
+static float
+from_bits(uint32_t bits)
+{
+    float val;
+    memcpy(&val, &bits, sizeof(val));
+    return val;
+}
+
+/**
+ * @brief Make a sample at a time, in us.
+ */
+static sample_t
+make_sample(uint64_t time_us, size_t i)
+{
+    sample_t s;
+    s.time = time_us / 1000;
+    s.time_us = time_us % 1000;
+    for (size_t c = 0; c < GORILLA_CHANNELS; c++)
+        s.values[c] = sinf(i * 0.05f + c) * (c + 1);
+    return s;
+}
+
+/**
+ * @brief Compress samples into blocks, the way recordings do, then check that
+ * they decode to exactly the same bits.
+ *
+ * @param samples The samples.
+ * @param block_size The size of the blocks.
+ * @return How many blocks there were.
+ */
+static size_t
+round_trip(const std::vector<sample_t>& samples, size_t block_size)
+{
+    std::vector<std::vector<uint8_t>> blocks;
+    std::vector<size_t> counts;
+
+    GorillaEncoder enc;
+    std::vector<uint8_t> buf(block_size);
+    enc.begin(buf.data(), block_size);
+    size_t count = 0;
+
+    for (const auto& s : samples) {
+        if (!enc.has_room()) {
+            TEST_ASSERT_LESS_OR_EQUAL(block_size, enc.size());
+            blocks.emplace_back(buf.begin(), buf.begin() + enc.size());
+            counts.push_back(count);
+            enc.begin(buf.data(), block_size);
+            count = 0;
+        }
+        enc.encode(s.time, s.time_us, s.values);
+        count++;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(block_size, enc.size());
+    blocks.emplace_back(buf.begin(), buf.begin() + enc.size());
+    counts.push_back(count);
+
+    GorillaDecoder dec;
+    size_t i = 0;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        dec.begin(blocks[b].data(), blocks[b].size());
+        for (size_t n = 0; n < counts[b]; n++, i++) {
+            sample_t out;
+            TEST_ASSERT_TRUE(dec.decode(&out.time, &out.time_us, out.values));
+            TEST_ASSERT_EQUAL_UINT32(samples[i].time, out.time);
+            TEST_ASSERT_EQUAL_UINT16(samples[i].time_us, out.time_us);
+            TEST_ASSERT_EQUAL_MEMORY(samples[i].values, out.values, sizeof(out.values));
+        }
+    }
+    TEST_ASSERT_EQUAL(samples.size(), i);
+    return blocks.size();
+}
+
+/******************************************************************************/
+
+void
+setUp()
+{
+    rand_state = 1;
+}
+
+void
+tearDown()
+{
+}
+
+static void
+test_special_values()
+{
+    static const float specials[] = {
+        NAN, -NAN, from_bits(0x7fc00001), from_bits(0x7f800001), // NaN payloads
+        0.0f, -0.0f, INFINITY, -INFINITY, FLT_MIN / 2, FLT_MAX, -FLT_MAX, 1.0f,
+    };
+    const size_t n_specials = sizeof(specials) / sizeof(*specials);
+
+    std::vector<sample_t> samples;
+    for (size_t i = 0; i < 500; i++) {
+        auto s = make_sample(1000000 + i * MPU_SAMPLE_RATE * 1000, i);
+        for (size_t c = 0; c < GORILLA_CHANNELS; c++) {
+            if ((i + c) % 3 == 0)
+                s.values[c] = specials[(i * 7 + c) % n_specials];
+        }
+        samples.push_back(s);
+    }
+    round_trip(samples, 1 << 16);
+}
+
+static void
+test_time_jumps()
+{
+    std::vector<sample_t> samples;
+    uint64_t time = 5000000;
+
+    for (size_t i = 0; i < 1000; i++) {
+        if (i == 100)
+            time += 10ull * 24 * 3600 * 1000000; // 10 days, past any dod bucket
+        if (i == 200)
+            time = 4294967290ull * 1000 + 999; // The ms counter wraps around
+        if (i == 300)
+            time += 2000000; // A 2 s stall
+        if (i == 400)
+            time -= MPU_SAMPLE_RATE * 1000 + 1; // Back in time
+        if (i >= 500 && i < 510)
+            time -= MPU_SAMPLE_RATE * 1000; // The same time again
+
+        // Every MPU_SAMPLE_RATE ms, with some interrupt latency
+        time += MPU_SAMPLE_RATE * 1000 + next_rand() % 300;
+        samples.push_back(make_sample(time, i));
+    }
+    round_trip(samples, 1 << 16);
+}
+
+static void
+test_block_boundaries()
+{
+    std::vector<sample_t> samples;
+    for (size_t i = 0; i < 5000; i++)
+        samples.push_back(make_sample(2000000 + i * MPU_SAMPLE_RATE * 1000 + i % 37, i));
+
+    // Recording-sized blocks, and blocks that fit only a sample or two
+    TEST_ASSERT_GREATER_THAN(10, round_trip(samples, REC_BLOCK_SIZE));
+    TEST_ASSERT_GREATER_THAN(1000, round_trip(samples, GORILLA_MAX_SAMPLE_BITS / 8 + 8));
+}
+
+static void
+test_worst_case()
+{
+    // Random bits and time jumps, so every sample takes close to the maximum
+    std::vector<sample_t> samples;
+    uint64_t time = 0;
+    for (size_t i = 0; i < 2000; i++) {
+        time += (uint64_t)next_rand() << 16 | next_rand() >> 16;
+        sample_t s;
+        s.time = time / 1000;
+        s.time_us = time % 1000;
+        for (size_t c = 0; c < GORILLA_CHANNELS; c++)
+            s.values[c] = from_bits(next_rand());
+        samples.push_back(s);
+    }
+
+    // has_room() must keep every sample within the block
+    round_trip(samples, REC_BLOCK_SIZE);
+    round_trip(samples, GORILLA_MAX_SAMPLE_BITS / 8 + 1);
+}
+
+static void
+test_end_of_block()
+{
+    uint8_t buf[REC_BLOCK_SIZE];
+    GorillaEncoder enc;
+    enc.begin(buf, sizeof(buf));
+
+    auto s = make_sample(1000000, 0);
+    enc.encode(s.time, s.time_us, s.values);
+    enc.encode(s.time + 1, s.time_us, s.values);
+
+    // Nothing past the last sample, even with padding bits left
+    GorillaDecoder dec;
+    dec.begin(buf, enc.size());
+    sample_t out;
+    TEST_ASSERT_TRUE(dec.decode(&out.time, &out.time_us, out.values));
+    TEST_ASSERT_TRUE(dec.decode(&out.time, &out.time_us, out.values));
+    TEST_ASSERT_FALSE(dec.decode(&out.time, &out.time_us, out.values));
+}
+
+int
+main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_special_values);
+    RUN_TEST(test_time_jumps);
+    RUN_TEST(test_block_boundaries);
+    RUN_TEST(test_worst_case);
+    RUN_TEST(test_end_of_block);
+    return UNITY_END();
+}
@@ -0,0 +1,117 @@
+/**
+ * @file test_main.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief mpu_data_t::to_json() tests.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "data.hpp"
+#include "timesync.hpp"
+
+#include <native_shim.h>
+#include <unity.h>
+
+static mpu_data_t
+make_sample()
+{
+    mpu_data_t sample = {};
+    sample.ypr[0] = PI / 2;
+    sample.ypr[1] = -PI / 4;
+    sample.ypr[2] = 0;
+    sample.accel = VectorFloat(0.5f, -1.25f, 9.81f);
+    sample.gyro = VectorFloat(0.01f, 0.02f, -0.03f);
+    sample.time = 123456;
+    sample.time_us = 123456789;
+    return sample;
+}
+
+/******************************************************************************/
+
+void
+setUp()
+{
+}
+
+void
+tearDown()
+{
+}
+
+static void
+test_values()
+{
+    auto sample = make_sample();
+    auto doc = sample.to_json();
+
+    // Angles are sent in degrees
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 90, doc["ypr"][0].as<float>());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, -45, doc["ypr"][1].as<float>());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0, doc["ypr"][2].as<float>());
+
+    TEST_ASSERT_EQUAL_FLOAT(sample.accel.x, doc["accel"][0].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(sample.accel.y, doc["accel"][1].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(sample.accel.z, doc["accel"][2].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(sample.gyro.x, doc["gyro"][0].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(sample.gyro.y, doc["gyro"][1].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(sample.gyro.z, doc["gyro"][2].as<float>());
+    TEST_ASSERT_EQUAL_UINT32(sample.time, doc["time"].as<unsigned long>());
+}
+
+static void
+test_no_epoch_before_sync()
+{
+    auto doc = make_sample().to_json();
+    TEST_ASSERT_FALSE(doc.containsKey("epochUs"));
+}
+
+static void
+test_epoch_after_sync()
+{
+    timesync_setup();
+    native_shim_time_sync();
+
+    timesync_t sync;
+    TEST_ASSERT_TRUE(timesync_get(&sync));
+
+    auto sample = make_sample();
+    auto doc = sample.to_json();
+    TEST_ASSERT_TRUE(doc.containsKey("epochUs"));
+    TEST_ASSERT_EQUAL_INT64(sync.to_epoch(sample.time_us), doc["epochUs"].as<int64_t>());
+
+    // Samples without a device time (e.g. replayed ones) never get one
+    sample.time_us = 0;
+    TEST_ASSERT_FALSE(sample.to_json().containsKey("epochUs"));
+}
+
+int
+main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_values);
+    RUN_TEST(test_no_epoch_before_sync); // Before any sync
+    RUN_TEST(test_epoch_after_sync);
+    return UNITY_END();
+}
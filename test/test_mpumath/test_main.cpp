@@ -0,0 +1,88 @@
+/**
+ * @file test_main.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief get_linear_accel() tests.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "mpumath.hpp"
+
+#include <unity.h>
+
+void
+setUp()
+{
+}
+
+void
+tearDown()
+{
+}
+
+static void
+test_at_rest()
+{
+    // Flat and still: the raw acceleration is all gravity, 1g = 16384
+    VectorInt16 raw(0, 0, 16384), out;
+    VectorFloat gravity(0, 0, 1);
+    TEST_ASSERT_EQUAL(0, get_linear_accel(&out, &raw, &gravity));
+    TEST_ASSERT_EQUAL_INT(0, out.x);
+    TEST_ASSERT_EQUAL_INT(0, out.y);
+    TEST_ASSERT_EQUAL_INT(0, out.z);
+}
+
+static void
+test_moving()
+{
+    // Tilted, and pushed along x
+    VectorInt16 raw(8192 + 1000, 0, 14189), out;
+    VectorFloat gravity(0.5f, 0, 0.8660254f);
+    get_linear_accel(&out, &raw, &gravity);
+    TEST_ASSERT_EQUAL_INT(1000, out.x);
+    TEST_ASSERT_EQUAL_INT(0, out.y);
+    TEST_ASSERT_INT_WITHIN(1, 0, out.z);
+}
+
+static void
+test_upside_down()
+{
+    VectorInt16 raw(-200, 300, -16384), out;
+    VectorFloat gravity(0, 0, -1);
+    get_linear_accel(&out, &raw, &gravity);
+    TEST_ASSERT_EQUAL_INT(-200, out.x);
+    TEST_ASSERT_EQUAL_INT(300, out.y);
+    TEST_ASSERT_EQUAL_INT(0, out.z);
+}
+
+int
+main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_at_rest);
+    RUN_TEST(test_moving);
+    RUN_TEST(test_upside_down);
+    return UNITY_END();
+}
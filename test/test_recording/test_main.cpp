@@ -0,0 +1,221 @@
+/**
+ * @file test_main.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Recording round trip tests, on both storage backends.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "recording.hpp"
+#include "storage.hpp"
+
+#include <native_shim.h>
+#include <unity.h>
+
+#include <vector>
+
+// Samples per test recording, enough for several blocks and index entries
+#define SAMPLES 5000
+
+static RecWriter writer;
+static RecReader reader;
+
+/**
+ * @brief Make a sample that changes a bit every time, like a real one.
+ */
+static mpu_data_t
+make_sample(size_t i)
+{
+    mpu_data_t sample = {};
+    sample.ypr[0] = sinf(i * 0.01f);
+    sample.ypr[1] = cosf(i * 0.013f);
+    sample.ypr[2] = i * 0.001f;
+    sample.accel = VectorFloat(i % 7, sinf(i), 9.81f);
+    sample.gyro = VectorFloat(0.1f * (i % 13), 0, -1);
+
+    // Every MPU_SAMPLE_RATE ms, with some interrupt latency
+    sample.time_us = 2000000 + i * MPU_SAMPLE_RATE * 1000 + i % 37;
+    sample.time = sample.time_us / 1000;
+    return sample;
+}
+
+/**
+ * @brief Record SAMPLES samples.
+ *
+ * @param close If the recording should be closed, or left like after a crash.
+ */
+static std::vector<mpu_data_t>
+record(const char* name, StorageBackend backend, bool close = true)
+{
+    std::vector<mpu_data_t> samples;
+    TEST_ASSERT_TRUE(writer.begin(storage_create(name, backend)));
+    for (size_t i = 0; i < SAMPLES; i++) {
+        samples.push_back(make_sample(i));
+        TEST_ASSERT_TRUE(writer.write(samples.back()));
+    }
+    if (close)
+        writer.close();
+    return samples;
+}
+
+/**
+ * @brief Check that a read sample is exactly the one that was written.
+ */
+static void
+assert_same(const mpu_data_t& expected, const mpu_data_t& actual)
+{
+    TEST_ASSERT_EQUAL_UINT32(expected.time, actual.time);
+    TEST_ASSERT_EQUAL_MEMORY(expected.ypr, actual.ypr, sizeof(expected.ypr));
+    TEST_ASSERT_EQUAL_MEMORY(&expected.accel, &actual.accel, sizeof(expected.accel));
+    TEST_ASSERT_EQUAL_MEMORY(&expected.gyro, &actual.gyro, sizeof(expected.gyro));
+}
+
+/**
+ * @brief Read a whole recording back and compare it to what was written.
+ */
+static void
+assert_round_trip(const char* name, const std::vector<mpu_data_t>& samples)
+{
+    TEST_ASSERT_TRUE(reader.begin(storage_open(name)));
+    TEST_ASSERT_EQUAL_UINT32(samples.front().time, reader.start_time());
+
+    mpu_data_t sample;
+    size_t count = 0;
+    while (reader.next(&sample)) {
+        TEST_ASSERT_LESS_THAN(samples.size(), count);
+        assert_same(samples[count++], sample);
+    }
+    TEST_ASSERT_EQUAL(samples.size(), count);
+
+    uint32_t end;
+    TEST_ASSERT_TRUE(reader.end_time(&end));
+    TEST_ASSERT_EQUAL_UINT32(samples.back().time, end);
+    reader.close();
+}
+
+/******************************************************************************/
+
+void
+setUp()
+{
+    native_shim_reset();
+    TEST_ASSERT_TRUE(storage_setup());
+}
+
+void
+tearDown()
+{
+}
+
+static void
+test_round_trip_partition()
+{
+    auto samples = record("part.dat", STORAGE_PARTITION);
+    assert_round_trip("part.dat", samples);
+}
+
+static void
+test_round_trip_littlefs()
+{
+    auto samples = record("lfs.dat", STORAGE_LITTLEFS);
+    assert_round_trip("lfs.dat", samples);
+}
+
+static void
+test_seek_window()
+{
+    auto samples = record("seek.dat", STORAGE_PARTITION);
+    uint32_t start = samples.front().time;
+
+    // A window from the middle, where the index has to skip blocks
+    uint32_t from = 30000, to = 31000;
+    TEST_ASSERT_TRUE(reader.begin(storage_open("seek.dat")));
+    TEST_ASSERT_TRUE(reader.seek(from, to));
+
+    mpu_data_t sample;
+    size_t count = 0;
+    while (reader.next(&sample)) {
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(start + from, sample.time);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(start + to, sample.time);
+        count++;
+    }
+    reader.close();
+
+    size_t expected = 0;
+    for (const auto& s : samples)
+        expected += s.time >= start + from && s.time <= start + to;
+    TEST_ASSERT_EQUAL(expected, count);
+}
+
+static void
+test_recover_interrupted()
+{
+    auto samples = record("crash.dat", STORAGE_PARTITION, false);
+    TEST_ASSERT_TRUE(storage_is_recording("crash.dat"));
+
+    // Reboot without closing it, everything flushed so far should be there
+    TEST_ASSERT_TRUE(storage_setup());
+    TEST_ASSERT_FALSE(storage_is_recording("crash.dat"));
+
+    TEST_ASSERT_TRUE(reader.begin(storage_open("crash.dat")));
+    mpu_data_t sample;
+    size_t count = 0;
+    while (reader.next(&sample))
+        assert_same(samples[count++], sample);
+    reader.close();
+
+    TEST_ASSERT_GREATER_THAN(0, count);
+    TEST_ASSERT_LESS_OR_EQUAL(samples.size(), count);
+}
+
+static void
+test_header()
+{
+    record("header.dat", STORAGE_PARTITION);
+    record("header2.dat", STORAGE_PARTITION);
+
+    rec_header_t first, second;
+    RecFile file = storage_open("header.dat");
+    TEST_ASSERT_TRUE(rec_read_header(file, &first));
+    file = storage_open("header2.dat");
+    TEST_ASSERT_TRUE(rec_read_header(file, &second));
+
+    TEST_ASSERT_EQUAL_UINT16(REC_VERSION, first.version);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(rec_sample_t), first.sample_size);
+    TEST_ASSERT_NOT_EQUAL(first.id, second.id);
+    TEST_ASSERT_GREATER_THAN_UINT32(first.seq, second.seq);
+}
+
+int
+main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_partition);
+    RUN_TEST(test_round_trip_littlefs);
+    RUN_TEST(test_seek_window);
+    RUN_TEST(test_recover_interrupted);
+    RUN_TEST(test_header);
+    return UNITY_END();
+}
@@ -0,0 +1,408 @@
+/**
+ * @file capture.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Capture binary sample streams from a tethered tracker.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "../include/cobs.hpp"
+#include "../include/config.h"
+#include "../include/serialstream.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+#ifdef __APPLE__
+#  include <IOKit/serial/ioss.h>
+#  include <sys/ioctl.h>
+#endif
+
+/*
+ * Switches a tracker to binary streaming (see include/serialstream.hpp), writes
+ * every sample to a CSV file, and reports what was lost when stopped. The CSV
+ * has the same columns and units as CSV exports, plus the sequence numbers.
+ *
+ *     tools/bin/capture /dev/ttyUSB0 -o session.csv -s 60
+ *
+ * Lost samples are counted from the gaps in the sequence numbers, so they're
+ * exact no matter where they were lost: dropped on the tracker because the
+ * port couldn't keep up, or corrupted on the wire and thrown out here.
+ */
+
+// Baud rate of the console, to send the start command at
+#define CONSOLE_BAUD 115200
+
+// Frames send angles in radians, CSV files have degrees
+#define RAD_TO_DEG 57.29577951308232f
+
+// Longest frame we'll buffer before giving up on finding its end
+#define MAX_FRAME 512
+
+static volatile sig_atomic_t stop = 0;
+
+/**
+ * @brief Capture statistics.
+ */
+struct stats_t {
+    uint64_t bytes = 0;      // Bytes read from the port
+    uint32_t samples = 0;    // Good sample frames
+    uint32_t lost = 0;       // Samples missing from the sequence
+    uint32_t bad_cobs = 0;   // Frames that weren't valid COBS
+    uint32_t bad_crc = 0;    // Frames with the wrong length or CRC
+    uint32_t late = 0;       // Samples more than 1.5 periods after the last one
+    uint32_t restarts = 0;   // Times the sequence went backwards
+    uint32_t first_seq = 0;  // First sequence number
+    uint32_t last_seq = 0;   // Last sequence number
+    uint32_t first_time = 0; // First sample time (in ms)
+    uint32_t last_time = 0;  // Last sample time (in ms)
+};
+
+/******************************************************************************/
+
+/**
+ * @brief CRC-32, the same one as esp_rom_crc32_le(0, ...).
+ */
+static uint32_t
+crc32(const uint8_t* buf, size_t len)
+{
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; k++)
+                crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+            table[i] = crc;
+        }
+    }
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++)
+        crc = table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+/**
+ * @brief Check a decoded frame's length and CRC.
+ */
+template <typename T>
+static bool
+frame_valid(const uint8_t* buf, size_t len)
+{
+    if (len != sizeof(T))
+        return false;
+
+    uint32_t crc;
+    memcpy(&crc, buf + len - sizeof(crc), sizeof(crc));
+    return crc == crc32(buf, len - sizeof(crc));
+}
+
+/**
+ * @brief Set the port's baud rate.
+ */
+static bool
+set_baud(int fd, uint32_t baud)
+{
+    struct termios tio;
+    if (tcgetattr(fd, &tio))
+        return false;
+
+#ifdef __APPLE__
+    // Only the standard rates go through termios, set the rest with an ioctl
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B9600);
+    if (tcsetattr(fd, TCSANOW, &tio))
+        return false;
+    speed_t speed = baud;
+    return ioctl(fd, IOSSIOSPEED, &speed) == 0;
+#else
+    speed_t speed;
+    switch (baud) {
+        case 115200:
+            speed = B115200;
+            break;
+        case 230400:
+            speed = B230400;
+            break;
+        case 460800:
+            speed = B460800;
+            break;
+        case 921600:
+            speed = B921600;
+            break;
+        case 1500000:
+            speed = B1500000;
+            break;
+        case 2000000:
+            speed = B2000000;
+            break;
+        default:
+            fprintf(stderr, "Unsupported baud rate %u\n", baud);
+            return false;
+    }
+
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, speed);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 1; // Wake up every 100 ms to check for Ctrl-C
+    return tcsetattr(fd, TCSANOW, &tio) == 0;
+#endif
+}
+
+/**
+ * @brief Handle a decoded frame.
+ */
+static void
+handle_frame(const uint8_t* buf, size_t len, FILE* out, stats_t& stats, uint16_t& rate)
+{
+    switch (buf[0]) {
+        case SERIALSTREAM_HELLO: {
+            if (!frame_valid<serialstream_hello_t>(buf, len)) {
+                stats.bad_crc++;
+                return;
+            }
+
+            serialstream_hello_t hello;
+            memcpy(&hello, buf, sizeof(hello));
+            if (hello.version != SERIALSTREAM_VERSION)
+                fprintf(
+                    stderr, "Tracker streams version %u, expected %u\n", hello.version,
+                    SERIALSTREAM_VERSION
+                );
+            rate = hello.sample_rate;
+            fprintf(stderr, "Streaming a sample every %u ms\n", rate);
+            break;
+        }
+
+        case SERIALSTREAM_SAMPLE: {
+            if (!frame_valid<serialstream_sample_t>(buf, len)) {
+                stats.bad_crc++;
+                return;
+            }
+
+            serialstream_sample_t s;
+            memcpy(&s, buf, sizeof(s));
+
+            if (!stats.samples) {
+                stats.first_seq = s.seq;
+                stats.first_time = s.time;
+            } else if (s.seq <= stats.last_seq) {
+                // The tracker restarted streaming
+                stats.restarts++;
+                stats.first_seq = s.seq;
+            } else {
+                stats.lost += s.seq - stats.last_seq - 1;
+                if (rate && (s.time - stats.last_time) * 2 > rate * 3u)
+                    stats.late++;
+            }
+            stats.samples++;
+            stats.last_seq = s.seq;
+            stats.last_time = s.time;
+
+            fprintf(
+                out, "%u,%u,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g\n", s.seq,
+                s.time, s.ypr[0] * RAD_TO_DEG, s.ypr[1] * RAD_TO_DEG,
+                s.ypr[2] * RAD_TO_DEG, s.accel[0], s.accel[1], s.accel[2], s.gyro[0],
+                s.gyro[1], s.gyro[2]
+            );
+            break;
+        }
+
+        default:
+            stats.bad_crc++;
+            break;
+    }
+}
+
+static void
+print_report(const stats_t& stats, double secs)
+{
+    uint32_t expected = stats.samples + stats.lost;
+
+    fprintf(stderr, "\n");
+    fprintf(
+        stderr, "%u samples in %.1f s (%.1f/s), %.1f KB/s\n", stats.samples, secs,
+        stats.samples / secs, stats.bytes / 1024.0 / secs
+    );
+    fprintf(
+        stderr, "%u lost (%.3f%%), %u late\n", stats.lost,
+        expected ? 100.0 * stats.lost / expected : 0.0, stats.late
+    );
+    fprintf(
+        stderr, "%u bad frames (%u COBS, %u length/CRC)\n",
+        stats.bad_cobs + stats.bad_crc, stats.bad_cobs, stats.bad_crc
+    );
+    if (stats.restarts)
+        fprintf(stderr, "Stream restarted %u times\n", stats.restarts);
+}
+
+static void
+usage(const char* prog)
+{
+    fprintf(
+        stderr,
+        "Usage: %s <port> [-o out.csv] [-s seconds]\n"
+        "\n"
+        "  -o  CSV file to write (default: capture-<time>.csv)\n"
+        "  -s  Stop after this many seconds (default: on Ctrl-C)\n",
+        prog
+    );
+}
+
+/******************************************************************************/
+
+int
+main(int argc, char** argv)
+{
+    std::string out_path;
+    uint32_t seconds = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:s:h")) != -1) {
+        switch (opt) {
+            case 'o':
+                out_path = optarg;
+                break;
+            case 's':
+                seconds = strtoul(optarg, nullptr, 10);
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char* port = argv[optind];
+
+    if (out_path.empty()) {
+        char name[64];
+        time_t now = time(nullptr);
+        strftime(name, sizeof(name), "capture-%Y%m%d-%H%M%S.csv", localtime(&now));
+        out_path = name;
+    }
+
+    int fd = open(port, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open %s: %s\n", port, strerror(errno));
+        return 1;
+    }
+
+    FILE* out = fopen(out_path.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "Could not open %s: %s\n", out_path.c_str(), strerror(errno));
+        return 1;
+    }
+    fprintf(
+        out, "seq,time,yaw,pitch,roll,accel_x,accel_y,accel_z,gyro_x,gyro_y,gyro_z\n"
+    );
+
+    // Ask for the stream at the console rate, then follow it to the stream rate
+    if (!set_baud(fd, CONSOLE_BAUD)) {
+        fprintf(stderr, "Could not configure %s: %s\n", port, strerror(errno));
+        return 1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    if (write(fd, "B", 1) != 1) {
+        fprintf(stderr, "Could not write to %s: %s\n", port, strerror(errno));
+        return 1;
+    }
+    tcdrain(fd);
+    usleep(50 * 1000);
+    if (!set_baud(fd, SERIALSTREAM_BAUD)) {
+        fprintf(
+            stderr, "Could not switch %s to %u baud: %s\n", port, SERIALSTREAM_BAUD,
+            strerror(errno)
+        );
+        return 1;
+    }
+
+    signal(SIGINT, [](int) { stop = 1; });
+    fprintf(stderr, "Capturing to %s, Ctrl-C to stop\n", out_path.c_str());
+
+    stats_t stats;
+    uint16_t rate = 0;
+    std::vector<uint8_t> frame;
+    uint8_t buf[4096];
+    uint8_t decoded[MAX_FRAME];
+    bool synced = false; // Skip everything before the first delimiter
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    now = start;
+
+    auto elapsed = [&] {
+        return now.tv_sec - start.tv_sec + (now.tv_nsec - start.tv_nsec) / 1e9;
+    };
+    while (!stop && (!seconds || elapsed() < seconds)) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (n < 0 && errno != EINTR) {
+            fprintf(stderr, "Read failed: %s\n", strerror(errno));
+            break;
+        }
+
+        for (ssize_t i = 0; i < n; i++) {
+            stats.bytes++;
+            if (buf[i]) {
+                if (synced && frame.size() < MAX_FRAME)
+                    frame.push_back(buf[i]);
+                continue;
+            }
+
+            // End of a frame
+            if (synced && !frame.empty()) {
+                size_t len = frame.size() < MAX_FRAME
+                                 ? cobs_decode(frame.data(), frame.size(), decoded)
+                                 : 0;
+                if (len)
+                    handle_frame(decoded, len, out, stats, rate);
+                else
+                    stats.bad_cobs++;
+            }
+            frame.clear();
+            synced = true;
+        }
+    }
+
+    // Back to the console
+    if (write(fd, "X", 1) == 1)
+        tcdrain(fd);
+    close(fd);
+    fclose(out);
+
+    print_report(stats, elapsed() > 0 ? elapsed() : 1);
+    return stats.lost || stats.bad_cobs || stats.bad_crc ? 3 : 0;
+}
@@ -0,0 +1,631 @@
+/**
+ * @file convert.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Convert recordings to CSV or columnar files, in parallel.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "../include/gorilla.hpp"
+#include "../include/recformat.hpp"
+
+#include <esp_rom_crc.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <map>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/*
+ * Converts recordings for analysis, many at a time:
+ *
+ *     tools/bin/convert -o out/ -f columns -j 8 recordings/
+ *
+ * Takes raw recordings (.dat from GET /recordings/<name>?raw, see
+ * recformat.hpp) and binary exports (.bin from ?format=bin, see export.hpp), or
+ * directories of them. Each one becomes:
+ *
+ * - csv: <name>.csv, with a header row.
+ * - columns: a <name>/ directory with one little-endian file per channel
+ *   (time.u32, yaw.f32, ...) and a columns.txt listing them. In numpy, that's
+ *   np.fromfile("yaw.f32", "<f4").
+ *
+ * Units match the exports: yaw/pitch/roll in degrees, acceleration in m/s^2,
+ * and time in ms since boot. On top of the recorded channels, it adds:
+ *
+ * - epoch_us: when each sample was taken, in us since the epoch, if the
+ *   recording has time sync blocks. Recordings from several trackers can be
+ *   lined up with it. Recordings from before version 7 only have ms times, so
+ *   their samples are placed in the middle of the ms.
+ * - accel_mag, gyro_mag: the magnitude of each vector.
+ * - world_accel_x/y/z: the acceleration rotated into the world frame with the
+ *   yaw/pitch/roll (Z-Y-X), so x/y are horizontal and z is up.
+ *
+ * Inputs are memory-mapped, and the derived channels are computed a column at a
+ * time, in loops the compiler can vectorize.
+ */
+
+// Must match EXPORT_BIN_MAGIC and export_bin_sample_t in export.hpp
+#define EXPORT_BIN_MAGIC 0x58455753 // "SWEX"
+#define EXPORT_BIN_HEADER_SIZE 8
+#define EXPORT_BIN_SAMPLE_SIZE 40
+
+#define RAD_TO_DEG 57.29577951308232f
+
+/**
+ * @brief A converted recording, a column per channel.
+ */
+struct columns_t {
+    std::vector<uint32_t> time;
+    std::vector<uint16_t> time_us;           // us past `time`, for epoch_us
+    std::vector<float> ch[GORILLA_CHANNELS]; // ypr, accel, gyro
+
+    // Time sync blocks, and the number of samples before each one
+    std::vector<std::pair<size_t, rec_timesync_t>> syncs;
+
+    // Derived
+    std::vector<int64_t> epoch_us; // Empty without time syncs
+    std::vector<float> accel_mag, gyro_mag;
+    std::vector<float> world[3];
+
+    void
+    push(uint32_t t, uint16_t t_us, const float* values)
+    {
+        time.push_back(t);
+        time_us.push_back(t_us);
+        for (size_t c = 0; c < GORILLA_CHANNELS; c++)
+            ch[c].push_back(values[c]);
+    }
+
+    size_t size() const { return time.size(); }
+};
+
+static const char* const CHANNEL_NAMES[GORILLA_CHANNELS] = {
+    "yaw",     "pitch",  "roll",   "accel_x", "accel_y",
+    "accel_z", "gyro_x", "gyro_y", "gyro_z",
+};
+
+/**
+ * @brief The result of converting one file.
+ */
+struct job_result_t {
+    std::string path;
+    size_t samples = 0;
+    size_t bytes = 0;
+    std::string error;   // Why it couldn't be converted
+    std::string warning; // Converted, but something was off
+};
+
+/******************************************************************************/
+
+/**
+ * @brief Read a recording, stopping at the first invalid block like RecReader.
+ */
+static bool
+parse_recording(const uint8_t* data, size_t size, columns_t& cols, job_result_t& res)
+{
+    rec_header_t header;
+    memcpy(&header, data, offsetof(rec_header_t, seq));
+    if (header.version < REC_VERSION_MIN || header.version > REC_VERSION
+        || header.sample_size != rec_sample_size(header.version)) {
+        res.error = "recording version " + std::to_string(header.version)
+                    + ", expected " + std::to_string(REC_VERSION);
+        return false;
+    }
+
+    GorillaDecoder decoder;
+    size_t offset = rec_header_size(header.version);
+
+    // Older recordings only have the ms, so use the middle of it
+    bool has_us = header.version >= 7;
+    const uint16_t no_us = 500;
+
+    while (offset + sizeof(rec_block_t) <= size) {
+        // Skip the zeros before a boundary
+        size_t room = REC_ALIGN - offset % REC_ALIGN;
+        if (room < sizeof(rec_block_t)) {
+            offset += room;
+            continue;
+        }
+
+        rec_block_t block;
+        memcpy(&block, data + offset, sizeof(block));
+        const uint8_t* payload = data + offset + sizeof(block);
+
+        bool valid = block.len <= REC_BLOCK_SIZE - sizeof(rec_block_t)
+                     && room >= sizeof(rec_block_t) + block.len
+                     && offset + sizeof(rec_block_t) + block.len <= size;
+        if (valid) {
+            uint32_t crc = esp_rom_crc32_le(
+                header.id, data + offset, offsetof(rec_block_t, crc)
+            );
+            if (block.magic != REC_PADDING_MAGIC)
+                crc = esp_rom_crc32_le(crc, payload, block.len);
+            valid = crc == block.crc;
+        }
+        if (!valid) {
+            res.warning = "invalid block at " + std::to_string(offset) + ", "
+                          + std::to_string(size - offset) + " bytes skipped";
+            break;
+        }
+
+        if (block.magic == REC_BLOCK_MAGIC) {
+            size_t sample_size = rec_sample_size(header.version);
+            if (block.len != block.count * sample_size) {
+                res.warning = "bad sample block at " + std::to_string(offset);
+                break;
+            }
+            for (size_t i = 0; i < block.count; i++) {
+                rec_sample_t s;
+                memcpy(&s, payload + i * sample_size, sample_size);
+                cols.push(s.time, has_us ? s.time_us : no_us, s.channels);
+            }
+        } else if (block.magic == REC_COMPRESSED_MAGIC) {
+            decoder.begin(payload, block.len, !has_us);
+            uint32_t time;
+            uint16_t time_us;
+            float values[GORILLA_CHANNELS];
+            size_t decoded = 0;
+            while (decoded < block.count && decoder.decode(&time, &time_us, values)) {
+                cols.push(time, has_us ? time_us : no_us, values);
+                decoded++;
+            }
+            if (decoded < block.count) {
+                res.warning = "truncated block at " + std::to_string(offset);
+                break;
+            }
+        } else if (block.magic == REC_TIMESYNC_MAGIC) {
+            rec_timesync_t sync;
+            if (block.len != sizeof(sync) - sizeof(rec_block_t)) {
+                res.warning = "bad time sync block at " + std::to_string(offset);
+                break;
+            }
+            memcpy(&sync, data + offset, sizeof(sync));
+            cols.syncs.emplace_back(cols.size(), sync);
+        }
+
+        offset += sizeof(rec_block_t) + block.len;
+    }
+
+    // Recordings store radians, exports degrees
+    for (size_t c = 0; c < 3; c++)
+        for (auto& v : cols.ch[c])
+            v *= RAD_TO_DEG;
+    return true;
+}
+
+/**
+ * @brief Read a binary export.
+ */
+static bool
+parse_export(const uint8_t* data, size_t size, columns_t& cols, job_result_t& res)
+{
+    uint16_t sample_size;
+    memcpy(&sample_size, data + 6, sizeof(sample_size));
+    if (size < EXPORT_BIN_HEADER_SIZE || sample_size != EXPORT_BIN_SAMPLE_SIZE) {
+        res.error = "unknown export sample size";
+        return false;
+    }
+
+    size_t count = (size - EXPORT_BIN_HEADER_SIZE) / EXPORT_BIN_SAMPLE_SIZE;
+    if ((size - EXPORT_BIN_HEADER_SIZE) % EXPORT_BIN_SAMPLE_SIZE)
+        res.warning = "truncated last sample";
+
+    const uint8_t* p = data + EXPORT_BIN_HEADER_SIZE;
+    for (size_t i = 0; i < count; i++, p += EXPORT_BIN_SAMPLE_SIZE) {
+        uint32_t time;
+        float values[GORILLA_CHANNELS];
+        memcpy(&time, p, sizeof(time));
+        memcpy(values, p + sizeof(time), sizeof(values));
+        cols.push(time, 500, values); // Exports only have the ms
+    }
+    return true;
+}
+
+/**
+ * @brief Map the sample times to epoch time with the time sync blocks.
+ *
+ * Each sample uses the last sync before it, or the first one if there's none.
+ */
+static void
+map_epoch(columns_t& cols)
+{
+    if (cols.syncs.empty())
+        return;
+
+    cols.epoch_us.resize(cols.size());
+    size_t next = 0; // The first sync that comes after the sample
+    for (size_t i = 0; i < cols.size(); i++) {
+        while (next < cols.syncs.size() && cols.syncs[next].first <= i)
+            next++;
+        const rec_timesync_t& sync = cols.syncs[next ? next - 1 : 0].second;
+
+        int64_t dt = (int64_t)cols.time[i] * 1000 + cols.time_us[i] - sync.timer_us;
+        cols.epoch_us[i] = sync.epoch_us + dt + dt * sync.drift_ppb / 1000000000;
+    }
+}
+
+/**
+ * @brief Compute the derived channels.
+ */
+static void
+derive(columns_t& cols)
+{
+    size_t n = cols.size();
+    const float *yaw = cols.ch[0].data(), *pitch = cols.ch[1].data(),
+                *roll = cols.ch[2].data();
+    const float *ax = cols.ch[3].data(), *ay = cols.ch[4].data(),
+                *az = cols.ch[5].data();
+    const float *gx = cols.ch[6].data(), *gy = cols.ch[7].data(),
+                *gz = cols.ch[8].data();
+
+    cols.accel_mag.resize(n);
+    cols.gyro_mag.resize(n);
+    for (auto& w : cols.world)
+        w.resize(n);
+    float* accel_mag = cols.accel_mag.data();
+    float* gyro_mag = cols.gyro_mag.data();
+    float *wx = cols.world[0].data(), *wy = cols.world[1].data(),
+          *wz = cols.world[2].data();
+
+    for (size_t i = 0; i < n; i++) {
+        accel_mag[i] = sqrtf(ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+        gyro_mag[i] = sqrtf(gx[i] * gx[i] + gy[i] * gy[i] + gz[i] * gz[i]);
+    }
+
+    // R = Rz(yaw) * Ry(pitch) * Rx(roll), applied to the body acceleration
+    for (size_t i = 0; i < n; i++) {
+        float cy = cosf(yaw[i] / RAD_TO_DEG), sy = sinf(yaw[i] / RAD_TO_DEG);
+        float cp = cosf(pitch[i] / RAD_TO_DEG), sp = sinf(pitch[i] / RAD_TO_DEG);
+        float cr = cosf(roll[i] / RAD_TO_DEG), sr = sinf(roll[i] / RAD_TO_DEG);
+
+        wx[i] = cy * cp * ax[i] + (cy * sp * sr - sy * cr) * ay[i]
+                + (cy * sp * cr + sy * sr) * az[i];
+        wy[i] = sy * cp * ax[i] + (sy * sp * sr + cy * cr) * ay[i]
+                + (sy * sp * cr - cy * sr) * az[i];
+        wz[i] = -sp * ax[i] + cp * sr * ay[i] + cp * cr * az[i];
+    }
+}
+
+/**
+ * @brief Get every column, in output order.
+ */
+static std::vector<std::pair<std::string, const std::vector<float>*>>
+float_columns(const columns_t& cols)
+{
+    std::vector<std::pair<std::string, const std::vector<float>*>> out;
+    for (size_t c = 0; c < GORILLA_CHANNELS; c++)
+        out.emplace_back(CHANNEL_NAMES[c], &cols.ch[c]);
+    out.emplace_back("accel_mag", &cols.accel_mag);
+    out.emplace_back("gyro_mag", &cols.gyro_mag);
+    out.emplace_back("world_accel_x", &cols.world[0]);
+    out.emplace_back("world_accel_y", &cols.world[1]);
+    out.emplace_back("world_accel_z", &cols.world[2]);
+    return out;
+}
+
+static bool
+write_csv(const std::string& path, const columns_t& cols)
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f)
+        return false;
+
+    auto columns = float_columns(cols);
+    bool epoch = !cols.epoch_us.empty();
+    fputs(epoch ? "time,epoch_us" : "time", f);
+    for (const auto& col : columns)
+        fprintf(f, ",%s", col.first.c_str());
+    fputc('\n', f);
+
+    // Format a row at a time into one buffer, so stdio isn't called per value
+    std::string row;
+    char num[32];
+    for (size_t i = 0; i < cols.size(); i++) {
+        row.clear();
+        row += std::to_string(cols.time[i]);
+        if (epoch) {
+            row += ',';
+            row += std::to_string(cols.epoch_us[i]);
+        }
+        for (const auto& col : columns) {
+            int len = snprintf(num, sizeof(num), ",%.7g", (*col.second)[i]);
+            row.append(num, len);
+        }
+        row += '\n';
+        fwrite(row.data(), 1, row.size(), f);
+    }
+    return fclose(f) == 0;
+}
+
+static bool
+write_column(const std::string& path, const void* data, size_t len)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(data, 1, len, f) == len;
+    return fclose(f) == 0 && ok;
+}
+
+static bool
+write_columns(const std::string& dir, const columns_t& cols)
+{
+    if (mkdir(dir.c_str(), 0755) && errno != EEXIST)
+        return false;
+
+    FILE* list = fopen((dir + "/columns.txt").c_str(), "w");
+    if (!list)
+        return false;
+
+    bool ok = write_column(
+        dir + "/time.u32", cols.time.data(), cols.size() * sizeof(uint32_t)
+    );
+    fprintf(list, "time.u32 %zu\n", cols.size());
+
+    if (!cols.epoch_us.empty()) {
+        ok &= write_column(
+            dir + "/epoch_us.i64", cols.epoch_us.data(), cols.size() * sizeof(int64_t)
+        );
+        fprintf(list, "epoch_us.i64 %zu\n", cols.size());
+    }
+
+    for (const auto& col : float_columns(cols)) {
+        ok &= write_column(
+            dir + "/" + col.first + ".f32", col.second->data(),
+            col.second->size() * sizeof(float)
+        );
+        fprintf(list, "%s.f32 %zu\n", col.first.c_str(), col.second->size());
+    }
+    return fclose(list) == 0 && ok;
+}
+
+/**
+ * @brief Name the output after the input, without the extension.
+ */
+static std::string
+output_name(const std::string& path)
+{
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    return name.substr(0, name.find_last_of('.'));
+}
+
+/**
+ * @brief Convert one file.
+ */
+static void
+convert(const std::string& path, const std::string& dir, bool csv, job_result_t& res)
+{
+    res.path = path;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st)) {
+        res.error = strerror(errno);
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+    res.bytes = st.st_size;
+    if (st.st_size < (off_t)offsetof(rec_header_t, seq)) {
+        res.error = "too small";
+        close(fd);
+        return;
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        res.error = strerror(errno);
+        return;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    auto* data = static_cast<const uint8_t*>(map);
+
+    columns_t cols;
+    uint32_t magic;
+    memcpy(&magic, data, sizeof(magic));
+
+    bool ok;
+    if (magic == REC_MAGIC) {
+        ok = parse_recording(data, st.st_size, cols, res);
+    } else if (magic == EXPORT_BIN_MAGIC) {
+        ok = parse_export(data, st.st_size, cols, res);
+    } else {
+        res.error = "not a recording or binary export";
+        ok = false;
+    }
+    munmap(map, st.st_size);
+    if (!ok)
+        return;
+
+    map_epoch(cols);
+    derive(cols);
+    res.samples = cols.size();
+
+    std::string out = dir + "/" + output_name(path);
+
+    if (!(csv ? write_csv(out + ".csv", cols) : write_columns(out, cols)))
+        res.error = "could not write " + out + ": " + strerror(errno);
+}
+
+/**
+ * @brief Add a file, or the recordings and exports in a directory.
+ */
+static void
+collect(const std::string& path, std::vector<std::string>& files)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st)) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        files.push_back(path);
+        return;
+    }
+
+    DIR* dir = opendir(path.c_str());
+    if (!dir)
+        return;
+    while (auto* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name[0] == '.')
+            continue;
+
+        size_t dot = name.find_last_of('.');
+        std::string ext = dot == std::string::npos ? "" : name.substr(dot);
+        if (ext == ".dat" || ext == ".bin")
+            files.push_back(path + "/" + name);
+    }
+    closedir(dir);
+}
+
+static void
+usage(const char* prog)
+{
+    fprintf(
+        stderr,
+        "Usage: %s [-o dir] [-f csv|columns] [-j jobs] <file or dir>...\n"
+        "\n"
+        "  -o  Where to write the output (default: .)\n"
+        "  -f  Output format (default: csv)\n"
+        "  -j  Files to convert at once (default: one per core)\n",
+        prog
+    );
+}
+
+/******************************************************************************/
+
+int
+main(int argc, char** argv)
+{
+    std::string out_dir = ".";
+    bool csv = true;
+    unsigned jobs = std::thread::hardware_concurrency();
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:f:j:h")) != -1) {
+        switch (opt) {
+            case 'o':
+                out_dir = optarg;
+                break;
+            case 'f':
+                if (!strcmp(optarg, "csv")) {
+                    csv = true;
+                } else if (!strcmp(optarg, "columns")) {
+                    csv = false;
+                } else {
+                    usage(argv[0]);
+                    return 2;
+                }
+                break;
+            case 'j':
+                jobs = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (optind == argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> files;
+    for (int i = optind; i < argc; i++)
+        collect(argv[i], files);
+
+    // Workers would write over each other's output
+    std::map<std::string, std::string> outputs;
+    bool clash = false;
+    for (const auto& file : files) {
+        auto res = outputs.emplace(output_name(file), file);
+        if (!res.second) {
+            fprintf(
+                stderr, "%s and %s would both be converted to %s\n",
+                res.first->second.c_str(), file.c_str(), res.first->first.c_str()
+            );
+            clash = true;
+        }
+    }
+    if (clash)
+        return 2;
+
+    if (mkdir(out_dir.c_str(), 0755) && errno != EEXIST) {
+        fprintf(stderr, "Could not create %s: %s\n", out_dir.c_str(), strerror(errno));
+        return 1;
+    }
+
+    // Each worker takes the next file until there are none left
+    auto start = std::chrono::steady_clock::now();
+    std::vector<job_result_t> results(files.size());
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    jobs = std::max(1u, std::min<unsigned>(jobs, files.size()));
+
+    for (unsigned i = 0; i < jobs; i++) {
+        workers.emplace_back([&] {
+            for (size_t j; (j = next++) < files.size();)
+                convert(files[j], out_dir, csv, results[j]);
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double secs = elapsed.count();
+
+    size_t samples = 0, bytes = 0, failed = 0;
+    for (const auto& res : results) {
+        if (!res.error.empty()) {
+            fprintf(stderr, "%s: %s\n", res.path.c_str(), res.error.c_str());
+            failed++;
+            continue;
+        }
+        if (!res.warning.empty())
+            fprintf(stderr, "%s: %s\n", res.path.c_str(), res.warning.c_str());
+        samples += res.samples;
+        bytes += res.bytes;
+    }
+
+    fprintf(
+        stderr,
+        "Converted %zu of %zu files, %zu samples, in %.2f s (%.1f MB/s, %u jobs)\n",
+        files.size() - failed, files.size(), samples, secs, bytes / 1e6 / secs, jobs
+    );
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,413 @@
+/**
+ * @file hostbench.cpp
+ * @author Nino Maruszewski (nino.maruszewski@gmail.com)
+ * @brief Microbenchmarks for the sampling hot paths, on the host.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 Nino Maruszewski
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef PIO_UNIT_TESTING // The test suites have their own main()
+
+#include "../include/cobs.hpp"
+#include "../include/config.h"
+#include "../include/export.hpp"
+#include "../include/gorilla.hpp"
+#include "../include/recording.hpp"
+#include "../include/serialstream.hpp"
+#include "../include/storage.hpp"
+
+#include <esp_rom_crc.h>
+#include <LittleFS.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+/*
+ * Times the sampling, recording, and export paths in the native environment
+ * (see lib/native_shim), and counts their allocations and output:
+ *
+ * - gorilla_encode: compressing samples into REC_BLOCK_SIZE blocks, as
+ *   recordings do.
+ * - gorilla_decode: reading them back, as exports and replays do. Fails if
+ *   they don't match the original samples bit for bit.
+ * - export_csv_gzip: a gzipped CSV export of a recording, with RecExporter.
+ * - serialstream: building, checksumming, and COBS-encoding sample frames.
+ *
+ *     pio run -e native && .pio/build/native/program          Print the results
+ *     .pio/build/native/program --save tools/bench_baseline.txt
+ *     .pio/build/native/program --check tools/bench_baseline.txt
+ *
+ * --check fails if a path allocates more than the baseline, or its output grew
+ * by more than 1%. Times depend on the machine, so they are only printed. The
+ * on-device benchmarks (the 'b' and 'e' serial commands) cover the flash and
+ * network.
+ */
+
+// Samples per run
+#define SAMPLES 20000
+
+// Runs per benchmark, the fastest one counts
+#define RUNS 15
+
+// Size of the chunks exports are sent in
+#define EXPORT_CHUNK 1460
+
+// Name of the recording exports are benchmarked with
+#define BENCH_RECORDING "hostbench.dat"
+
+static size_t allocs = 0;
+
+void*
+operator new(size_t size)
+{
+    allocs++;
+    if (void* ptr = malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+// Not inlined, so GCC doesn't mistake the free() for a mismatched delete
+__attribute__((noinline)) void
+operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+__attribute__((noinline)) void
+operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+/**
+ * @brief A sample, laid out the way recordings store one.
+ */
+struct sample_t {
+    uint32_t time;
+    uint16_t time_us;
+    float values[GORILLA_CHANNELS]; // ypr, accel, gyro
+};
+
+/**
+ * @brief A benchmark result.
+ */
+struct result_t {
+    std::string name;
+    double ns;     // Per sample
+    double allocs; // Per sample
+    double bytes;  // Output bytes per sample
+};
+
+/******************************************************************************/
+
+/**
+ * @brief A pseudo-random number, the same on every platform (unlike rand()).
+ */
+static uint32_t
+bench_rand()
+{
+    static uint32_t state = 1;
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+/**
+ * @brief Make samples that look like a swimmer: strokes, plus sensor noise.
+ */
+static std::vector<sample_t>
+make_samples()
+{
+    std::vector<sample_t> samples(SAMPLES);
+
+    for (size_t i = 0; i < SAMPLES; i++) {
+        auto& s = samples[i];
+        float t = i * MPU_SAMPLE_RATE / 1000.0f;
+        auto noise = [] { return (bench_rand() / (float)(1 << 24) - 0.5f) * 0.02f; };
+
+        // Some interrupt latency, like on the ESP32
+        uint64_t us = (1000 + i * MPU_SAMPLE_RATE) * 1000ull + bench_rand() % 40;
+        s.time = us / 1000;
+        s.time_us = us % 1000;
+        s.values[0] = 0.3f * sinf(t * 0.2f) + noise();
+        s.values[1] = 0.5f * sinf(t * 1.1f) + noise();
+        s.values[2] = 0.8f * sinf(t * 1.1f + 1) + noise();
+        for (size_t c = 3; c < 6; c++)
+            s.values[c] = 4 * sinf(t * 2.2f + c) + noise() * 50;
+        for (size_t c = 6; c < 9; c++)
+            s.values[c] = 3 * cosf(t * 1.1f + c) + noise() * 10;
+    }
+    return samples;
+}
+
+/**
+ * @brief Record the samples, for the export benchmarks.
+ */
+static bool
+record_samples(const std::vector<sample_t>& samples)
+{
+    if (!LittleFS.begin(true) || !storage_setup())
+        return false;
+
+    static RecWriter writer; // Too big for the stack, like on the ESP32
+    if (!writer.begin(storage_create(BENCH_RECORDING, STORAGE_LITTLEFS)))
+        return false;
+
+    for (const auto& s : samples) {
+        mpu_data_t sample;
+        memcpy(sample.ypr, s.values, sizeof(sample.ypr));
+        sample.accel = VectorFloat(s.values[3], s.values[4], s.values[5]);
+        sample.gyro = VectorFloat(s.values[6], s.values[7], s.values[8]);
+        sample.time = s.time;
+        sample.time_us = s.time * 1000ll + s.time_us;
+        if (!writer.write(sample))
+            return false;
+    }
+    writer.close();
+    return true;
+}
+
+/**
+ * @brief Time a benchmark.
+ *
+ * @param name The benchmark name.
+ * @param fn Runs the benchmark once, and returns the output size.
+ */
+template <typename Fn>
+static result_t
+run(const char* name, Fn fn)
+{
+    result_t res{name, 1e18, 0, 0};
+
+    for (size_t i = 0; i < RUNS; i++) {
+        size_t start_allocs = allocs;
+        auto start = std::chrono::steady_clock::now();
+        size_t bytes = fn();
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        res.ns = std::min(res.ns, ns / SAMPLES);
+        res.allocs = (double)(allocs - start_allocs) / SAMPLES;
+        res.bytes = (double)bytes / SAMPLES;
+    }
+
+    printf(
+        "%-16s %9.1f ns/sample %8.3f allocs/sample %7.2f B/sample\n", name, res.ns,
+        res.allocs, res.bytes
+    );
+    return res;
+}
+
+/**
+ * @brief Read a saved baseline.
+ */
+static std::vector<result_t>
+load_baseline(const char* path)
+{
+    std::vector<result_t> results;
+    FILE* f = fopen(path, "r");
+    if (!f)
+        return results;
+
+    char name[64];
+    result_t res{};
+    while (fscanf(f, "%63s %lf %lf", name, &res.allocs, &res.bytes) == 3) {
+        res.name = name;
+        results.push_back(res);
+    }
+    fclose(f);
+    return results;
+}
+
+/******************************************************************************/
+
+int
+main(int argc, char** argv)
+{
+    const char* save_path = nullptr;
+    const char* check_path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--save") && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (!strcmp(argv[i], "--check") && i + 1 < argc) {
+            check_path = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--save FILE] [--check FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    auto samples = make_samples();
+    std::vector<result_t> results;
+    bool ok = true;
+
+    // Recording: compress into blocks
+    std::vector<uint8_t> store(SAMPLES * sizeof(sample_t));
+    std::vector<size_t> block_ends;
+    block_ends.reserve(SAMPLES);
+    results.push_back(run("gorilla_encode", [&] {
+        block_ends.clear();
+        size_t start = 0;
+
+        GorillaEncoder enc;
+        enc.begin(store.data(), REC_BLOCK_SIZE);
+        for (const auto& s : samples) {
+            if (!enc.has_room()) {
+                start += enc.size();
+                block_ends.push_back(start);
+                enc.begin(store.data() + start, REC_BLOCK_SIZE);
+            }
+            enc.encode(s.time, s.time_us, s.values);
+        }
+        block_ends.push_back(start + enc.size());
+        return block_ends.back();
+    }));
+
+    // Export and replay: decompress the blocks
+    std::vector<sample_t> decoded(SAMPLES);
+    results.push_back(run("gorilla_decode", [&] {
+        GorillaDecoder dec;
+        size_t count = 0, start = 0;
+
+        for (size_t end : block_ends) {
+            dec.begin(store.data() + start, end - start);
+            while (count < SAMPLES) {
+                auto& s = decoded[count];
+                if (!dec.decode(&s.time, &s.time_us, s.values))
+                    break;
+                count++;
+            }
+            start = end;
+        }
+        return count * sizeof(sample_t);
+    }));
+
+    // Compression must be lossless, down to the bits of NaNs and -0
+    for (size_t i = 0; i < SAMPLES; i++) {
+        const auto &in = samples[i], &out = decoded[i];
+        if (in.time != out.time || in.time_us != out.time_us
+            || memcmp(in.values, out.values, sizeof(in.values))) {
+            printf("MISMATCH gorilla_decode: sample %zu differs\n", i);
+            ok = false;
+            break;
+        }
+    }
+
+    // CSV export: a real export of a recording, gzipped
+    if (!record_samples(samples)) {
+        fprintf(stderr, "Could not record the samples\n");
+        return 1;
+    }
+    results.push_back(run("export_csv_gzip", [&] {
+        static RecExporter exporter; // Too big for the stack, like on the ESP32
+        if (!exporter.begin(storage_open(BENCH_RECORDING), EXPORT_CSV)
+            || !exporter.compress())
+            return (size_t)0;
+
+        uint8_t chunk[EXPORT_CHUNK];
+        size_t bytes = 0, n;
+        while ((n = exporter.fill(chunk, sizeof(chunk))))
+            bytes += n;
+        exporter.close();
+        return bytes;
+    }));
+
+    // Serial streaming: build, checksum, and encode frames
+    results.push_back(run("serialstream", [&] {
+        uint8_t buf[cobs_max_len(sizeof(serialstream_sample_t)) + 1];
+        size_t bytes = 0;
+        uint32_t seq = 0;
+
+        for (const auto& s : samples) {
+            serialstream_sample_t frame;
+            frame.type = SERIALSTREAM_SAMPLE;
+            frame.seq = seq++;
+            frame.time = s.time;
+            memcpy(frame.ypr, s.values, sizeof(float) * 9);
+
+            auto* raw = reinterpret_cast<uint8_t*>(&frame);
+            frame.crc = esp_rom_crc32_le(0, raw, sizeof(frame) - sizeof(frame.crc));
+            bytes += cobs_encode(raw, sizeof(frame), buf) + 1;
+        }
+        return bytes;
+    }));
+
+    if (save_path) {
+        FILE* f = fopen(save_path, "w");
+        if (!f) {
+            fprintf(stderr, "Could not write %s\n", save_path);
+            return 1;
+        }
+        for (const auto& res : results)
+            fprintf(
+                f, "%s %.3f %.2f\n", res.name.c_str(), res.allocs, res.bytes
+            );
+        fclose(f);
+        printf("Saved the baseline to %s\n", save_path);
+    }
+
+    if (!check_path)
+        return ok ? 0 : 1;
+
+    auto baseline = load_baseline(check_path);
+    if (baseline.empty()) {
+        fprintf(stderr, "No baseline in %s\n", check_path);
+        return 1;
+    }
+
+    for (const auto& base : baseline) {
+        auto res = std::find_if(results.begin(), results.end(), [&](const auto& r) {
+            return r.name == base.name;
+        });
+        if (res == results.end())
+            continue;
+
+        if (res->allocs > base.allocs + 1e-3) {
+            printf(
+                "REGRESSION %s: %.3f allocs/sample, baseline %.3f\n",
+                base.name.c_str(), res->allocs, base.allocs
+            );
+            ok = false;
+        }
+        if (res->bytes > base.bytes * 1.01) {
+            printf(
+                "REGRESSION %s: %.2f B/sample, baseline %.2f\n", base.name.c_str(),
+                res->bytes, base.bytes
+            );
+            ok = false;
+        }
+    }
+    printf(ok ? "No regressions\n" : "");
+    return ok ? 0 : 1;
+}
+
+#endif // PIO_UNIT_TESTING
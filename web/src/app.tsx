@@ -1,5 +1,6 @@
 import {
     Acceleration,
+    Latency,
     SSEStatus,
     Temperature,
     YawPitchRoll,
@@ -33,6 +34,7 @@ export function App() {
             <YawPitchRoll />
             <Acceleration />
             <Temperature />
+            <Latency />
         </MpuDataProvider>
     );
 }
@@ -3,3 +3,4 @@ export * from "./acceleration/Acceleration";
 export * from "./yaw-pitch-roll/YawPitchRoll";
 export * from "./line-chart/line-chart";
 export * from "./sse-status/sse-status"
+export * from "./latency/Latency";
@@ -0,0 +1,146 @@
+import { type LatencySample, MpuDataContext } from "@/providers";
+import { useContext, useEffect, useState } from "react";
+
+// Stage durations of one sample (ms)
+type Stages = Record<string, number>;
+
+// p50, p95, and max of each stage (ms)
+type Summary = Record<string, [number, number, number]>;
+
+// The tracker's own summary, from GET /latency (us)
+interface DeviceLatency {
+    enabled: boolean;
+    count: number;
+    stages: Record<string, { p50: number; p95: number; max: number }>;
+}
+
+const STAGES = ["acquire", "queue", "encode", "network", "render", "total"];
+
+/**
+ * Split each rendered sample's latency into stages.
+ *
+ * Without a synced tracker clock, network is relative to the fastest sample,
+ * so it only shows the delay on top of the best case.
+ */
+function breakdown(samples: LatencySample[]): Stages[] {
+    const rendered = samples.filter((s) => s.rendered !== undefined);
+
+    // When each sample was handed to the event source, in the tracker's clock
+    const sent = rendered.map((s) =>
+        s.epochUs !== undefined
+            ? (s.epochUs + s.trace[2]) / 1000
+            : s.time + s.trace[2] / 1000,
+    );
+    const base = rendered.every((s) => s.epochUs !== undefined)
+        ? 0
+        : Math.min(...rendered.map((s, i) => s.received - sent[i]));
+
+    return rendered.map((s, i) => {
+        const [decoded, dequeued, encoded] = s.trace.map((t) => t / 1000);
+        const stages: Stages = {
+            acquire: decoded,
+            queue: dequeued - decoded,
+            encode: encoded - dequeued,
+            network: s.received - sent[i] - base,
+            render: (s.rendered as number) - s.received,
+        };
+        stages.total = encoded + stages.network + stages.render;
+        return stages;
+    });
+}
+
+function summarize(samples: Stages[]): Summary {
+    const summary: Summary = {};
+    for (const stage of STAGES) {
+        const vals = samples.map((s) => s[stage]).sort((a, b) => a - b);
+        const at = (q: number) =>
+            vals[Math.min(Math.floor(vals.length * q), vals.length - 1)];
+        summary[stage] = [at(0.5), at(0.95), vals[vals.length - 1]];
+    }
+    return summary;
+}
+
+export function Latency() {
+    const { latency } = useContext(MpuDataContext);
+    const [device, setDevice] = useState<DeviceLatency | null>(null);
+    const [summary, setSummary] = useState<Summary | null>(null);
+
+    useEffect(() => {
+        const update = () => {
+            fetch("/latency")
+                .then((res) => res.json())
+                .then(setDevice)
+                .catch(() => setDevice(null));
+
+            const samples = breakdown(latency.current);
+            setSummary(samples.length ? summarize(samples) : null);
+        };
+
+        update();
+        const interval = setInterval(update, 1000);
+        return () => clearInterval(interval);
+    }, [latency]);
+
+    const setEnabled = (enabled: boolean) => {
+        latency.current = [];
+        fetch("/latency", { method: enabled ? "POST" : "DELETE" })
+            .then((res) => res.json())
+            .then(setDevice)
+            .catch(() => setDevice(null));
+    };
+
+    const fmt = (ms: number) => ms.toFixed(2);
+
+    return (
+        <div>
+            <label>
+                <input
+                    type="checkbox"
+                    checked={device?.enabled ?? false}
+                    disabled={!device}
+                    onChange={(e) => setEnabled(e.target.checked)}
+                />{" "}
+                Trace latency
+            </label>
+
+            {summary && (
+                <table>
+                    <thead>
+                        <tr>
+                            <th>Stage</th>
+                            <th>p50 (ms)</th>
+                            <th>p95 (ms)</th>
+                            <th>max (ms)</th>
+                        </tr>
+                    </thead>
+                    <tbody>
+                        {STAGES.map((stage) => (
+                            <tr key={stage}>
+                                <td>{stage}</td>
+                                {summary[stage].map((ms, i) => (
+                                    <td key={i}>{fmt(ms)}</td>
+                                ))}
+                            </tr>
+                        ))}
+                        {device && device.stages.send && (
+                            <tr>
+                                <td>send (on the tracker)</td>
+                                <td>{fmt(device.stages.send.p50 / 1000)}</td>
+                                <td>{fmt(device.stages.send.p95 / 1000)}</td>
+                                <td>{fmt(device.stages.send.max / 1000)}</td>
+                            </tr>
+                        )}
+                    </tbody>
+                </table>
+            )}
+            {summary && (
+                <p>
+                    Network includes the send stage. Once the tracker's time is
+                    synced, it's measured against this computer's clock, so
+                    it's only as good as that clock. Until then, it's the delay
+                    on top of the fastest sample.
+                </p>
+            )}
+        </div>
+    );
+}
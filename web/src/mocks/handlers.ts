@@ -1,5 +1,13 @@
 import { ResponseTransformer, rest } from "msw";
 
+let tracing = false;
+
+const latency = () => ({
+    enabled: tracing,
+    count: 0,
+    stages: {},
+});
+
 export const handlers = [
     // SSE
     rest.get("/events", (req, res, ctx) => {
@@ -10,6 +18,7 @@ export const handlers = [
             ypr: [Math.random(), Math.random(), Math.random()],
             accel: [Math.random(), Math.random(), Math.random()],
             temp: Math.random(),
+            ...(tracing ? { trace: [900, 1100, 1400] } : {}),
         };
         messages.push(
             ctx.delay(1000),
@@ -27,4 +36,15 @@ export const handlers = [
             ...messages,
         );
     }),
+
+    // Latency tracing
+    rest.get("/latency", (req, res, ctx) => res(ctx.json(latency()))),
+    rest.post("/latency", (req, res, ctx) => {
+        tracing = true;
+        return res(ctx.json(latency()));
+    }),
+    rest.delete("/latency", (req, res, ctx) => {
+        tracing = false;
+        return res(ctx.json(latency()));
+    }),
 ];
@@ -1,23 +1,45 @@
 import { useEffect, useRef, useState } from "react";
-import { createContext, type ReactNode } from "react";
+import { createContext, type MutableRefObject, type ReactNode } from "react";
 
 export interface MpuData {
     ypr: [number, number, number];
     accel: [number, number, number];
     temp: number;
     time: number;
+    // When it was sampled (us since the epoch), once the time is synced
+    epochUs?: number;
+    // While latency tracing is on: when it was decoded, picked up by the data
+    // task, and encoded on the tracker (us after its interrupt)
+    trace?: [number, number, number];
 }
 
+// A traced sample, with when we received and drew it (ms since the epoch)
+export interface LatencySample {
+    time: number;
+    epochUs?: number;
+    trace: [number, number, number];
+    received: number;
+    rendered?: number;
+}
+
+// Number of traced samples to keep
+const LATENCY_SAMPLES = 256;
+
 type MpuContextData = {
     error: Event | null;
     data: MpuData[];
+    latency: MutableRefObject<LatencySample[]>;
 };
 
 export const MpuDataContext = createContext<MpuContextData>({
     error: null,
     data: [],
+    latency: { current: [] },
 });
 
+// performance.now() is more precise than Date.now(), but starts at page load
+const now = () => performance.timeOrigin + performance.now();
+
 interface MpuDataProviderProps {
     maxElements?: number;
     onOpen?: (e: MessageEvent) => void;
@@ -34,6 +56,7 @@ export function MpuDataProvider({
     children,
 }: MpuDataProviderProps) {
     const sseRef = useRef<EventSource | null>(null);
+    const latencyRef = useRef<LatencySample[]>([]);
 
     const [error, setError] = useState<Event | null>(null);
     const [data, setData] = useState<MpuData[]>([]);
@@ -65,22 +88,51 @@ export function MpuDataProvider({
         if (!sse) return;
 
         const onData = (ev: MessageEvent) => {
+            const received = now();
+            let sample: MpuData;
             try {
-                setData((prev) => [
-                    ...prev.slice(-(maxElements - 1)),
-                    {
-                        ...JSON.parse(ev.data),
-                        time: parseInt(ev.lastEventId, 10),
-                    },
-                ]);
+                sample = {
+                    ...JSON.parse(ev.data),
+                    time: parseInt(ev.lastEventId, 10),
+                };
             } catch (e) {
                 // Do nothing, as we got invalid data
+                return;
+            }
+            setData((prev) => [...prev.slice(-(maxElements - 1)), sample]);
+
+            if (sample.trace) {
+                const traced: LatencySample = {
+                    time: sample.time,
+                    epochUs: sample.epochUs,
+                    trace: sample.trace,
+                    received,
+                };
+                const samples = latencyRef.current;
+                samples.push(traced);
+                if (samples.length > LATENCY_SAMPLES) samples.shift();
+
+                // The update renders before the next frame is drawn
+                requestAnimationFrame(() => {
+                    traced.rendered = now();
+                });
             }
         };
         sse.addEventListener("mpuData", onData);
 
+        // A replay starts a new series
+        const onReplay = (ev: MessageEvent) => {
+            try {
+                if (JSON.parse(ev.data).state === "started") setData([]);
+            } catch (e) {
+                // Do nothing, as we got invalid data
+            }
+        };
+        sse.addEventListener("replay", onReplay);
+
         return () => {
             sse.removeEventListener("mpuData", onData);
+            sse.removeEventListener("replay", onReplay);
         };
     }, [maxElements]);
 
@@ -95,7 +147,7 @@ export function MpuDataProvider({
     }, [onOpen]);
 
     return (
-        <MpuDataContext.Provider value={{ data, error }}>
+        <MpuDataContext.Provider value={{ data, error, latency: latencyRef }}>
             {children}
         </MpuDataContext.Provider>
     );